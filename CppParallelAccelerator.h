@@ -7,9 +7,99 @@
 #include <memory>
 #include <thread>
 #include <queue>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <type_traits>
 
 #define DEBUG false
 
+//the per-core cache the tiled loops are sized for
+#ifndef L2_CACHE_SIZE
+#define L2_CACHE_SIZE (256u * 1024u)
+#endif
+
+/*
+* One block of a tiled 2D loop, the output range is [begin, end).
+* The halo range is the part of the source a stencil of the given radius reads, clamped to the image.
+*/
+struct ParallelTile
+{
+	uint32_t xBegin;
+	uint32_t xEnd;
+	uint32_t yBegin;
+	uint32_t yEnd;
+
+	uint32_t haloXBegin;
+	uint32_t haloXEnd;
+	uint32_t haloYBegin;
+	uint32_t haloYEnd;
+};
+
+/*
+* Process-wide work-stealing pool.
+* Every worker owns a deque: the owner pops from the back, idle workers steal from the front.
+* The calling thread joins the work until its own batch is finished, so nested parallel_for never blocks a worker.
+*/
+class CppThreadPool
+{
+public:
+	static CppThreadPool& Instance();
+
+	//workers plus the calling thread
+	uint16_t GetNumThreads() const;
+
+	//Func(begin, end) is called once per chunk of [0, count)
+	template<typename Function>
+	void RunChunks(const size_t& count, const size_t& chunkSize, Function&& Func);
+
+	~CppThreadPool();
+
+	CppThreadPool(const CppThreadPool&) = delete;
+	CppThreadPool& operator=(const CppThreadPool&) = delete;
+
+protected:
+	struct TaskGroup
+	{
+		void (*invoke)(void* context, size_t begin, size_t end) = nullptr;
+		void* context = nullptr;
+		std::atomic<size_t> pending{ 0u };
+	};
+
+	struct Task
+	{
+		TaskGroup* group;
+		size_t begin;
+		size_t end;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+protected:
+	explicit CppThreadPool(const uint16_t& numWorkers);
+
+	void WorkerLoop(const size_t& index);
+	void Push(const size_t& queueIndex, const Task& task);
+	bool PopOrSteal(const size_t& ownIndex, Task& task);
+	static void Execute(const Task& task);
+
+	static size_t& CurrentWorkerIndex();
+
+protected:
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex sleepLock;
+	std::condition_variable wakeUp;
+	std::atomic<size_t> queuedTasks{ 0u };
+	bool stopping = false;
+};
+
 class CppParallelAccelerator
 {
 
@@ -35,12 +125,40 @@ public:
 	template<typename Index_type, typename Function>
 	static void parallel_for(Index_type First, const Index_type Last, const Index_type Step, Function&& Func);
 
+	//Func(const ParallelTile&), tiles are sized so that the source block with its halo stays in L2
+	template<typename Function>
+	static void parallel_for_tile(const uint32_t& width, const uint32_t& height, const uint32_t& halo, const uint32_t& bytesPerPixel, Function&& Func);
+
 protected:
 	std::vector<std::unique_ptr<std::thread>> allThreads;
 };
 
+/*
+* Fixed-capacity FIFO between two pipeline stages.
+* Push blocks while the queue is full, so a fast producer cannot run ahead of memory.
+* After Close, Pop still drains what is left and returns false once empty.
+*/
+template<typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(const size_t& capacity);
+
+	//false if the queue was closed before the item got in
+	bool Push(T&& item);
+	bool Pop(T& item);
+	void Close();
 
-inline CppParallelAccelerator::CppParallelAccelerator()
+protected:
+	std::mutex lock;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+	std::deque<T> items;
+	size_t capacity;
+	bool closed = false;
+};
+
+inline uint32_t DefaultExecutionThreads()
 {
 #if !DEBUG
 	uint32_t numberOfExecutionThreads = (std::thread::hardware_concurrency() + 1) >> 1;
@@ -48,8 +166,186 @@ inline CppParallelAccelerator::CppParallelAccelerator()
 #else
 	uint32_t numberOfExecutionThreads = 1;
 #endif
+	return numberOfExecutionThreads;
+}
+
+inline CppThreadPool& CppThreadPool::Instance()
+{
+	//the calling thread is one of the execution threads
+	static CppThreadPool pool(static_cast<uint16_t>(DefaultExecutionThreads() - 1u));
+	return pool;
+}
+
+inline CppThreadPool::CppThreadPool(const uint16_t& numWorkers)
+{
+	//the last queue belongs to the threads outside the pool
+	for (size_t i = 0u; i <= numWorkers; ++i)
+	{
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	workers.reserve(numWorkers);
+	for (size_t i = 0u; i < numWorkers; ++i)
+	{
+		workers.emplace_back(&CppThreadPool::WorkerLoop, this, i);
+	}
+}
+
+inline CppThreadPool::~CppThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (auto& worker : workers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+}
+
+inline uint16_t CppThreadPool::GetNumThreads() const
+{
+	return static_cast<uint16_t>(workers.size() + 1u);
+}
+
+inline size_t& CppThreadPool::CurrentWorkerIndex()
+{
+	static thread_local size_t index = SIZE_MAX;
+	return index;
+}
+
+inline void CppThreadPool::Push(const size_t& queueIndex, const Task& task)
+{
+	//count first, so a thief never takes the counter below zero
+	queuedTasks.fetch_add(1u, std::memory_order_release);
+
+	std::lock_guard<std::mutex> guard(queues[queueIndex]->lock);
+	queues[queueIndex]->tasks.push_back(task);
+}
+
+inline bool CppThreadPool::PopOrSteal(const size_t& ownIndex, Task& task)
+{
+	if (queuedTasks.load(std::memory_order_acquire) == 0u)
+		return false;
+
+	//own queue first, newest task is still hot in cache
+	if (ownIndex < queues.size())
+	{
+		auto& own = *queues[ownIndex];
+		std::lock_guard<std::mutex> guard(own.lock);
+
+		if (!own.tasks.empty())
+		{
+			task = own.tasks.back();
+			own.tasks.pop_back();
+			queuedTasks.fetch_sub(1u, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	//steal the oldest task from the others
+	for (size_t i = 1u; i <= queues.size(); ++i)
+	{
+		auto& victim = *queues[(ownIndex + i) % queues.size()];
+		std::unique_lock<std::mutex> guard(victim.lock, std::try_to_lock);
+
+		if (guard.owns_lock() && !victim.tasks.empty())
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			queuedTasks.fetch_sub(1u, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+inline void CppThreadPool::Execute(const Task& task)
+{
+	task.group->invoke(task.group->context, task.begin, task.end);
+	task.group->pending.fetch_sub(1u, std::memory_order_acq_rel);
+}
+
+inline void CppThreadPool::WorkerLoop(const size_t& index)
+{
+	CurrentWorkerIndex() = index;
+	Task task;
+
+	while (true)
+	{
+		if (PopOrSteal(index, task))
+		{
+			Execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wakeUp.wait(guard, [this] { return stopping || queuedTasks.load(std::memory_order_acquire) != 0u; });
+
+		if (stopping)
+			return;
+	}
+}
+
+template<typename Function>
+inline void CppThreadPool::RunChunks(const size_t& count, const size_t& chunkSize, Function&& Func)
+{
+	if (count == 0u)
+		return;
+
+	const size_t numChunks = (count + chunkSize - 1u) / chunkSize;
+
+	//nothing to share, skip the queues
+	if (numChunks == 1u || workers.empty())
+	{
+		Func(static_cast<size_t>(0u), count);
+		return;
+	}
+
+	using FunctionType = std::remove_reference_t<Function>;
+
+	TaskGroup group;
+	group.context = const_cast<void*>(static_cast<const void*>(&Func));
+	group.invoke = [](void* context, size_t begin, size_t end) {
+		(*static_cast<FunctionType*>(context))(begin, end);
+		};
+	group.pending.store(numChunks, std::memory_order_relaxed);
+
+	const size_t ownIndex = (CurrentWorkerIndex() < workers.size()) ? CurrentWorkerIndex() : workers.size();
+
+	//neighbouring chunks go to the same queue, stealing rebalances the tail
+	const size_t chunksPerQueue = (numChunks + queues.size() - 1u) / queues.size();
+
+	for (size_t chunk = 0u; chunk < numChunks; ++chunk)
+	{
+		size_t begin = chunk * chunkSize;
+		size_t end = (begin + chunkSize < count) ? (begin + chunkSize) : count;
+
+		Push((ownIndex + chunk / chunksPerQueue) % queues.size(), Task{ &group, begin, end });
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+	}
+	wakeUp.notify_all();
+
+	//help until the whole batch is done
+	Task task;
+	while (group.pending.load(std::memory_order_acquire) != 0u)
+	{
+		if (PopOrSteal(ownIndex, task))
+			Execute(task);
+		else
+			std::this_thread::yield();
+	}
+}
 
-	allThreads.resize(numberOfExecutionThreads);
+inline CppParallelAccelerator::CppParallelAccelerator()
+{
+	allThreads.resize(DefaultExecutionThreads());
 }
 
 inline CppParallelAccelerator::CppParallelAccelerator(const uint16_t& numThreads)
@@ -71,7 +367,7 @@ inline void CppParallelAccelerator::Join()
 {
 	for (auto& thread : allThreads)
 	{
-		if (thread->joinable())
+		if (thread && thread->joinable())
 			thread->join();
 	}
 }
@@ -106,23 +402,134 @@ inline void CppParallelAccelerator::parallel_for(Index_type First, const Index_t
 template<typename Index_type, typename Function>
 inline void CppParallelAccelerator::parallel_for(Index_type First, const Index_type Last, const Index_type Step, Function&& Func)
 {
-	CppParallelAccelerator accelerator;
-	std::queue<Index_type> param;
+	if (!(First < Last))
+		return;
+
+	auto& pool = CppThreadPool::Instance();
 
-	while (First < Last)
+	const size_t count = static_cast<size_t>((Last - First + Step - 1) / Step);
+
+	//a few chunks per thread keeps the load balanced without paying per index
+	const size_t numChunks = static_cast<size_t>(pool.GetNumThreads()) << 2u;
+	const size_t chunkSize = (count + numChunks - 1u) / numChunks;
+
+	pool.RunChunks(count, chunkSize, [&First, &Step, &Func](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			Func(static_cast<Index_type>(First + static_cast<Index_type>(i) * Step));
+		}
+		});
+}
+
+template<typename Function>
+inline void CppParallelAccelerator::parallel_for_tile(const uint32_t& width, const uint32_t& height, const uint32_t& halo, const uint32_t& bytesPerPixel, Function&& Func)
+{
+	if (width == 0u || height == 0u)
+		return;
+
+	auto& pool = CppThreadPool::Instance();
+
+	//half of L2 for the source, the rest is left to the output and the other hyper thread
+	constexpr size_t budget = L2_CACHE_SIZE >> 1u;
+	//at least this many output rows per tile, otherwise the halo rows dominate
+	constexpr uint32_t minRows = 8u;
+	constexpr uint32_t minWidth = 64u;
+
+	const size_t haloSpan = static_cast<size_t>(halo) << 1u;
+
+	uint32_t tileWidth = width;
+	while (tileWidth > minWidth && (tileWidth + haloSpan) * (haloSpan + minRows) * bytesPerPixel > budget)
+	{
+		tileWidth = (tileWidth + 1u) >> 1u;
+	}
+
+	const size_t rowsFit = budget / ((tileWidth + haloSpan) * bytesPerPixel);
+	uint32_t tileHeight = (rowsFit > haloSpan + minRows) ? static_cast<uint32_t>(rowsFit - haloSpan) : minRows;
+
+	//still enough tiles to keep every thread busy
+	const uint32_t columns = (width + tileWidth - 1u) / tileWidth;
+	const size_t minTiles = static_cast<size_t>(pool.GetNumThreads()) << 2u;
+	const size_t minRowsOfTiles = (minTiles + columns - 1u) / columns;
+
+	if (((height + tileHeight - 1u) / tileHeight) < minRowsOfTiles)
 	{
-		for (uint16_t i = 0; i < accelerator.GetNumThreads(); ++i)
+		tileHeight = static_cast<uint32_t>((height + minRowsOfTiles - 1u) / minRowsOfTiles);
+	}
+	tileHeight = (tileHeight < 1u) ? 1u : ((tileHeight > height) ? height : tileHeight);
+
+	const uint32_t rows = (height + tileHeight - 1u) / tileHeight;
+	const size_t count = static_cast<size_t>(columns) * rows;
+	const size_t chunkSize = (count + minTiles - 1u) / minTiles;
+
+	pool.RunChunks(count, chunkSize, [&](size_t begin, size_t end) {
+		for (size_t index = begin; index < end; ++index)
 		{
-			if ((First + i * Step) < Last)
-				param.push((First + i * Step));
-			else
-				break;
+			//walk down a column of tiles, so the halo rows of the next tile are already cached
+			const uint32_t column = static_cast<uint32_t>(index / rows);
+			const uint32_t row = static_cast<uint32_t>(index % rows);
+
+			ParallelTile tile;
+			tile.xBegin = column * tileWidth;
+			tile.xEnd = (tile.xBegin + tileWidth < width) ? (tile.xBegin + tileWidth) : width;
+			tile.yBegin = row * tileHeight;
+			tile.yEnd = (tile.yBegin + tileHeight < height) ? (tile.yBegin + tileHeight) : height;
+
+			tile.haloXBegin = (tile.xBegin > halo) ? (tile.xBegin - halo) : 0u;
+			tile.haloXEnd = (static_cast<size_t>(tile.xEnd) + halo < width) ? (tile.xEnd + halo) : width;
+			tile.haloYBegin = (tile.yBegin > halo) ? (tile.yBegin - halo) : 0u;
+			tile.haloYEnd = (static_cast<size_t>(tile.yEnd) + halo < height) ? (tile.yEnd + halo) : height;
+
+			Func(tile);
 		}
+		});
+}
+
+template<typename T>
+inline BoundedQueue<T>::BoundedQueue(const size_t& capacity) :capacity(capacity > 0u ? capacity : 1u)
+{
+}
+
+template<typename T>
+inline bool BoundedQueue<T>::Push(T&& item)
+{
+	std::unique_lock<std::mutex> guard(this->lock);
+	this->notFull.wait(guard, [this]() { return this->closed || this->items.size() < this->capacity; });
 
-		accelerator.Run(Func, param);
-		accelerator.Join();
+	if (this->closed)
+		return false;
 
-		First += Step * accelerator.GetNumThreads();
+	this->items.push_back(std::move(item));
+	guard.unlock();
+
+	this->notEmpty.notify_one();
+	return true;
+}
+
+template<typename T>
+inline bool BoundedQueue<T>::Pop(T& item)
+{
+	std::unique_lock<std::mutex> guard(this->lock);
+	this->notEmpty.wait(guard, [this]() { return this->closed || !this->items.empty(); });
+
+	if (this->items.empty())
+		return false;
+
+	item = std::move(this->items.front());
+	this->items.pop_front();
+	guard.unlock();
+
+	this->notFull.notify_one();
+	return true;
+}
+
+template<typename T>
+inline void BoundedQueue<T>::Close()
+{
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->closed = true;
 	}
+	this->notFull.notify_all();
+	this->notEmpty.notify_all();
 }
-#endif // !CPPPARALLELACCELERATOR
\ No newline at end of file
+#endif // !CPPPARALLELACCELERATOR
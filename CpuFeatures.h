@@ -0,0 +1,111 @@
+#pragma once
+#ifndef CPUFEATURES
+#define CPUFEATURES
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+/*
+* Instruction sets this process may use, read once through CPUID.
+* The AVX bits also need XGETBV to confirm the OS saves the wider registers.
+*/
+struct CpuFeatures
+{
+	bool sse41 = false;
+	bool ssse3 = false;
+	bool pclmul = false;
+	bool avx2 = false;
+	bool fma = false;
+	bool avx512f = false;
+	bool avx512cd = false;
+	bool avx512bw = false;
+	bool avx512dq = false;
+	bool avx512vl = false;
+
+	static const CpuFeatures& Get();
+
+protected:
+	CpuFeatures();
+
+	static void CpuId(const uint32_t& leaf, const uint32_t& subLeaf, uint32_t(&regs)[4]);
+	static uint64_t XGetBV(const uint32_t& index);
+};
+
+inline const CpuFeatures& CpuFeatures::Get()
+{
+	static const CpuFeatures features;
+	return features;
+}
+
+inline CpuFeatures::CpuFeatures()
+{
+	uint32_t regs[4] = {};//eax ebx ecx edx
+
+	CpuId(0u, 0u, regs);
+	const uint32_t maxLeaf = regs[0];
+
+	if (maxLeaf < 1u)
+		return;
+
+	CpuId(1u, 0u, regs);
+	const uint32_t ecx1 = regs[2];
+
+	this->ssse3 = (ecx1 >> 9u) & 1u;
+	this->sse41 = (ecx1 >> 19u) & 1u;
+	this->pclmul = (ecx1 >> 1u) & 1u;
+
+	const bool osxsave = (ecx1 >> 27u) & 1u;
+	const bool avx = (ecx1 >> 28u) & 1u;
+
+	//XMM and YMM state, then opmask and both ZMM halves
+	const uint64_t xcr0 = osxsave ? XGetBV(0u) : 0u;
+	const bool osAvx = avx && ((xcr0 & 0x06u) == 0x06u);
+	const bool osAvx512 = osAvx && ((xcr0 & 0xE0u) == 0xE0u);
+
+	this->fma = osAvx && ((ecx1 >> 12u) & 1u);
+
+	if (maxLeaf < 7u)
+		return;
+
+	CpuId(7u, 0u, regs);
+	const uint32_t ebx7 = regs[1];
+
+	this->avx2 = osAvx && ((ebx7 >> 5u) & 1u);
+	this->avx512f = osAvx512 && ((ebx7 >> 16u) & 1u);
+	this->avx512dq = osAvx512 && ((ebx7 >> 17u) & 1u);
+	this->avx512cd = osAvx512 && ((ebx7 >> 28u) & 1u);
+	this->avx512bw = osAvx512 && ((ebx7 >> 30u) & 1u);
+	this->avx512vl = osAvx512 && ((ebx7 >> 31u) & 1u);
+}
+
+inline void CpuFeatures::CpuId(const uint32_t& leaf, const uint32_t& subLeaf, uint32_t(&regs)[4])
+{
+#if defined(_MSC_VER)
+	int32_t info[4];
+	__cpuidex(info, static_cast<int32_t>(leaf), static_cast<int32_t>(subLeaf));
+
+	for (size_t i = 0; i < 4; ++i)
+		regs[i] = static_cast<uint32_t>(info[i]);
+#else
+	__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+inline uint64_t CpuFeatures::XGetBV(const uint32_t& index)
+{
+#if defined(_MSC_VER)
+	return _xgetbv(index);
+#else
+	uint32_t eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+	return (static_cast<uint64_t>(edx) << 32u) | eax;
+#endif
+}
+
+#endif // !CPUFEATURES
@@ -1,5 +1,330 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include "Image.h"
 
+//the part of [begin, end) that stays halo pixels away from both edges, may be empty
+static void InteriorSpan(const int64_t& begin, const int64_t& end, const int64_t& halo, const int64_t& size, int64_t& interiorBegin, int64_t& interiorEnd)
+{
+	//kept inside [begin, end), the border loops before it must not write past the tile when it is narrower than the halo
+	interiorBegin = min(max(begin, halo), end);
+	interiorEnd = max(interiorBegin, min(end, size - halo));
+}
+
+/*
+* GrayColor as tables: the three weighted linear channels, and for every gray level the smallest sum that reaches it.
+* The sum is added in the same order as GrayColor, so the level found is the one GrayColor computes.
+* Levels are at least 0.87% apart and a bucket of the top 16 float bits spans less than 0.79%,
+* so the level at the start of the bucket of a sum is right or one short.
+*/
+struct GrayLut
+{
+	static constexpr size_t entries = 256u;
+	//the bits of 1.0f shifted down, the sum is clamped to it
+	static constexpr size_t buckets = (0x3F80'0000u >> 16u) + 1u;
+
+	float32_t linear[3u * entries];
+	//one more level that nothing reaches
+	float32_t thresholds[entries + 1u];
+	//4 bytes of padding for the 32-bit gather of the wide kernels
+	byte coarse[buckets + 4u];
+
+	byte Level(const float32_t& sum) const;
+};
+
+inline byte GrayLut::Level(const float32_t& sum) const
+{
+	uint32_t bits;
+	const float32_t clamped = min(sum, 1.0f);
+	std::memcpy(&bits, &clamped, sizeof(bits));
+
+	const uint32_t level = this->coarse[bits >> 16u];
+	return static_cast<byte>((this->thresholds[level + 1u] <= sum) ? level + 1u : level);
+}
+
+static const GrayLut& GrayTables()
+{
+	static const GrayLut lut = []() {
+		constexpr float32_t gamma = 2.2f;
+		constexpr float32_t reciprocal = 1.0f / 2.2f;
+		const RGBAColor_32f ratio(0.2973f, 0.6274f, 0.0753f);
+
+		GrayLut tables = {};
+
+		for (size_t i = 0u; i < GrayLut::entries; ++i)
+		{
+			const uint8_t value = static_cast<uint8_t>(i);
+
+			RGBAColor_32f gray(RGBAColor_8i(value, value, value));
+			gray.R = std::powf(gray.R, gamma);
+			gray.G = std::powf(gray.G, gamma);
+			gray.B = std::powf(gray.B, gamma);
+
+			gray *= ratio;
+
+			tables.linear[i] = gray.R;
+			tables.linear[GrayLut::entries + i] = gray.G;
+			tables.linear[2u * GrayLut::entries + i] = gray.B;
+		}
+
+		//the gamma encode of GrayColor
+		const auto Level = [&reciprocal](const float32_t& sum) { return static_cast<uint32_t>(static_cast<byte>(powf(sum, reciprocal) * maxColorPix)); };
+
+		//start at the exact inverse and walk to the first float of the level
+		for (uint32_t level = 1u; level < GrayLut::entries; ++level)
+		{
+			float32_t sum = std::powf(static_cast<float32_t>(level) * ColorPixTofloat, gamma);
+
+			while (sum > 0.0f && Level(std::nextafterf(sum, 0.0f)) >= level)
+				sum = std::nextafterf(sum, 0.0f);
+
+			while (sum < 1.0f && Level(sum) < level)
+				sum = std::nextafterf(sum, 1.0f);
+
+			tables.thresholds[level] = sum;
+		}
+		tables.thresholds[GrayLut::entries] = std::numeric_limits<float32_t>::infinity();
+
+		for (uint32_t bucket = 0u; bucket < GrayLut::buckets; ++bucket)
+		{
+			float32_t start;
+			const uint32_t bits = bucket << 16u;
+			std::memcpy(&start, &bits, sizeof(start));
+
+			tables.coarse[bucket] = static_cast<byte>(std::upper_bound(tables.thresholds + 1, tables.thresholds + GrayLut::entries, start) - tables.thresholds - 1);
+		}
+		return tables;
+		}();
+
+	return lut;
+}
+
+//S = R + G + B in [0, 765], split into coarse buckets of 32 fine bins
+static constexpr uint32_t surfaceBins = 766u;
+static constexpr uint32_t surfaceFineBits = 5u;
+static constexpr uint32_t surfaceFineSize = 1u << surfaceFineBits;
+static constexpr uint32_t surfaceBuckets = (surfaceBins + surfaceFineSize - 1u) >> surfaceFineBits;
+
+/*
+* Surface blur of one tile with per-column histograms over the 2r+1 rows of the window (Perreault-Hebert).
+* Fine bins hold count, R, G, B; coarse buckets and the totals (bucket surfaceBuckets) also hold S, S*R, S*G, S*B.
+* The coarse window slides by whole column histograms, the fine bins of a bucket are only brought up to date when a center lands in it.
+*/
+static void SurfaceBlurTile(TextureData& input, TextureData& result, const ParallelTile& tile, const int64_t& radius, const float64_t& k)
+{
+	constexpr uint32_t coarseStride = (surfaceBuckets + 1u) * 8u;
+
+	thread_local std::vector<uint32_t> columnFine;
+	thread_local std::vector<uint32_t> columnCoarse;
+	thread_local std::vector<uint32_t> windowFine;
+
+	const int64_t width = input.width;
+	const int64_t height = input.height;
+
+	//the real columns the tile window can reach
+	const int64_t columnBase = max(int64_t(0), int64_t(tile.xBegin) - radius);
+	const int64_t columnEnd = min(width, int64_t(tile.xEnd) + radius);
+	const size_t columns = static_cast<size_t>(columnEnd - columnBase);
+
+	columnFine.assign(columns * surfaceBins * 4u, 0u);
+	columnCoarse.assign(columns * coarseStride, 0u);
+	windowFine.resize(static_cast<size_t>(surfaceBins) * 4u);
+
+	const auto ClampColumn = [&width, &columnBase](const int64_t& x) { return static_cast<size_t>(((x < 0) ? 0 : ((x >= width) ? width - 1 : x)) - columnBase); };
+	const auto ClampRow = [&height](const int64_t& y) { return (y < 0) ? 0 : ((y >= height) ? height - 1 : y); };
+
+	//unsigned wrap-around makes removal a plain subtraction
+	const auto Update = [](uint32_t* fine, uint32_t* coarse, const RGBAColor_8i& pixel, const uint32_t& sign) {
+		const uint32_t S = static_cast<uint32_t>(pixel.R) + pixel.G + pixel.B;
+		const uint32_t values[8] = { 1u, S, pixel.R, pixel.G, pixel.B, S * pixel.R, S * pixel.G, S * pixel.B };
+
+		uint32_t* bin = fine + (static_cast<size_t>(S) << 2u);
+		bin[0] += sign;
+		bin[1] += sign * pixel.R;
+		bin[2] += sign * pixel.G;
+		bin[3] += sign * pixel.B;
+
+		uint32_t* bucket = coarse + ((S >> surfaceFineBits) << 3u);
+		uint32_t* total = coarse + (surfaceBuckets << 3u);
+
+		for (uint32_t q = 0u; q < 8u; ++q)
+		{
+			bucket[q] += sign * values[q];
+			total[q] += sign * values[q];
+		}
+		};
+
+	for (size_t c = 0u; c < columns; ++c)
+	{
+		for (int64_t h = -radius; h <= radius; ++h)
+		{
+			Update(columnFine.data() + c * surfaceBins * 4u, columnCoarse.data() + c * coarseStride, input.at(columnBase + c, ClampRow(int64_t(tile.yBegin) + h)), 1u);
+		}
+	}
+
+	uint64_t windowCoarse[coarseStride];
+	int64_t stamps[surfaceBuckets];
+
+	for (int64_t Y = tile.yBegin; Y < tile.yEnd; ++Y)
+	{
+		//slide every column histogram down one row
+		if (Y > tile.yBegin)
+		{
+			const int64_t rowOut = ClampRow(Y - 1 - radius);
+			const int64_t rowIn = ClampRow(Y + radius);
+
+			if (rowOut != rowIn)
+			{
+				const RGBAColor_8i* out = input.row(rowOut);
+				const RGBAColor_8i* in = input.row(rowIn);
+
+				for (size_t c = 0u; c < columns; ++c)
+				{
+					uint32_t* fine = columnFine.data() + c * surfaceBins * 4u;
+					uint32_t* coarse = columnCoarse.data() + c * coarseStride;
+
+					Update(fine, coarse, out[columnBase + c], 0u - 1u);
+					Update(fine, coarse, in[columnBase + c], 1u);
+				}
+			}
+		}
+
+		for (uint32_t q = 0u; q < coarseStride; ++q)
+		{
+			windowCoarse[q] = 0u;
+		}
+
+		for (int64_t x = int64_t(tile.xBegin) - radius; x <= int64_t(tile.xBegin) + radius; ++x)
+		{
+			const uint32_t* coarse = columnCoarse.data() + ClampColumn(x) * coarseStride;
+
+			for (uint32_t q = 0u; q < coarseStride; ++q)
+			{
+				windowCoarse[q] += coarse[q];
+			}
+		}
+
+		for (uint32_t b = 0u; b < surfaceBuckets; ++b)
+		{
+			stamps[b] = INT64_MIN;
+		}
+
+		const RGBAColor_8i* centers = input.row(Y);
+		RGBAColor_8i* output = result.row(Y);
+
+		for (int64_t X = tile.xBegin; X < tile.xEnd; ++X)
+		{
+			if (X > tile.xBegin)
+			{
+				const size_t columnIn = ClampColumn(X + radius);
+				const size_t columnOut = ClampColumn(X - 1 - radius);
+
+				if (columnIn != columnOut)
+				{
+					const uint32_t* in = columnCoarse.data() + columnIn * coarseStride;
+					const uint32_t* out = columnCoarse.data() + columnOut * coarseStride;
+
+					for (uint32_t q = 0u; q < coarseStride; ++q)
+					{
+						windowCoarse[q] += static_cast<uint64_t>(in[q]) - out[q];
+					}
+				}
+			}
+
+			const RGBAColor_8i& center = centers[X];
+			const uint32_t Sc = static_cast<uint32_t>(center.R) + center.G + center.B;
+			const uint32_t bucket = Sc >> surfaceFineBits;
+			const uint32_t binBegin = bucket << surfaceFineBits;
+			const uint32_t binEnd = min(binBegin + surfaceFineSize, surfaceBins);
+
+			uint32_t* fineWindow = windowFine.data() + (static_cast<size_t>(binBegin) << 2u);
+			const size_t binCount = static_cast<size_t>(binEnd - binBegin) << 2u;
+
+			const auto AddColumn = [&binBegin, &binCount, &fineWindow](const size_t& column, const uint32_t& sign) {
+				const uint32_t* fine = columnFine.data() + (column * surfaceBins + binBegin) * 4u;
+
+				for (size_t q = 0u; q < binCount; ++q)
+				{
+					fineWindow[q] += sign * fine[q];
+				}
+				};
+
+			//bring the fine bins of this bucket to the current window
+			if (stamps[bucket] == INT64_MIN || X - stamps[bucket] > 2 * radius)
+			{
+				for (size_t q = 0u; q < binCount; ++q)
+				{
+					fineWindow[q] = 0u;
+				}
+
+				for (int64_t x = X - radius; x <= X + radius; ++x)
+				{
+					AddColumn(ClampColumn(x), 1u);
+				}
+			}
+			else
+			{
+				for (int64_t x = stamps[bucket] + 1; x <= X; ++x)
+				{
+					const size_t columnIn = ClampColumn(x + radius);
+					const size_t columnOut = ClampColumn(x - 1 - radius);
+
+					if (columnIn != columnOut)
+					{
+						AddColumn(columnIn, 1u);
+						AddColumn(columnOut, 0u - 1u);
+					}
+				}
+			}
+			stamps[bucket] = X;
+
+			//count, S, R, G, B, S*R, S*G, S*B of the window pixels with S_p < S_c
+			int64_t below[8] = {};
+
+			for (uint32_t b = 0u; b < bucket; ++b)
+			{
+				for (uint32_t q = 0u; q < 8u; ++q)
+				{
+					below[q] += windowCoarse[(b << 3u) + q];
+				}
+			}
+
+			for (uint32_t bin = binBegin; bin < Sc; ++bin)
+			{
+				const uint32_t* fine = windowFine.data() + (static_cast<size_t>(bin) << 2u);
+
+				below[0] += fine[0];
+				below[1] += static_cast<int64_t>(bin) * fine[0];
+				below[2] += fine[1];
+				below[3] += fine[2];
+				below[4] += fine[3];
+				below[5] += static_cast<int64_t>(bin) * fine[1];
+				below[6] += static_cast<int64_t>(bin) * fine[2];
+				below[7] += static_cast<int64_t>(bin) * fine[3];
+			}
+
+			const uint64_t* total = windowCoarse + (surfaceBuckets << 3u);
+
+			//sum |S_p - S_c| * v = S_c * (2 * below(v) - total(v)) + total(S * v) - 2 * below(S * v)
+			const auto Distance = [&Sc, &below, &total](const uint32_t& v, const uint32_t& sv) {
+				return static_cast<float64_t>(static_cast<int64_t>(Sc) * (2 * below[v] - static_cast<int64_t>(total[v])) + static_cast<int64_t>(total[sv]) - 2 * below[sv]);
+				};
+
+			const float64_t sum = static_cast<float64_t>(total[0]) - k * Distance(0u, 1u);
+			const float64_t scale = 1.0 / (maxColorPix * sum);
+
+			RGBAColor_32f pixelSum(
+				static_cast<float32_t>((total[2] - k * Distance(2u, 5u)) * scale),
+				static_cast<float32_t>((total[3] - k * Distance(3u, 6u)) * scale),
+				static_cast<float32_t>((total[4] - k * Distance(4u, 7u)) * scale),
+				center.A * ColorPixTofloat);
+
+			output[X] = pixelSum.toRGBAColor_8i();
+		}
+	}
+}
+
 bool ImageProcessingTools::Zoom_Default(TextureData& input, TextureData& result, const float32_t& magnification, const float32_t& threshold, const Exponent& exponent)
 {
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
@@ -10,8 +335,7 @@ bool ImageProcessingTools::Zoom_Default(TextureData& input, TextureData& result,
 
 	float32_t scaleIndex = 1.0f / magnification;
 
-	auto& resultRGBA = result.getRGBA_uint8();
-	resultRGBA.resize(static_cast<size_t>(result.width) * result.height);
+	result.resize(result.width, result.height);
 
 #define LerpRGBA(pixA,pixB,r) \
 {                             \
@@ -158,87 +482,331 @@ bool ImageProcessingTools::Zoom_BicubicConvolutionSampling4x4(TextureData& input
 
 	float32_t scaleIndex = 1.0f / magnification;
 
-	auto& resultRGBA = result.getRGBA_uint8();
-	resultRGBA.resize(static_cast<size_t>(result.width) * result.height);
+	result.resize(result.width, result.height);
 
-	const auto CalcSrcIndex = [&scaleIndex](const auto& dstIndex) {
-		return std::fmaxf(0.0f, (dstIndex + 0.5f) * scaleIndex - 0.5f);
-		};
+	//the weights only depend on the output column or row, so each axis is tabulated once
+	ResampleAxis axisX, axisY;
+	ImageProcessingTools::BicubicResampleAxis(axisX, input.width, result.width, scaleIndex, a);
+	ImageProcessingTools::BicubicResampleAxis(axisY, input.height, result.height, scaleIndex, a);
 
+	ImageProcessingTools::SeparableResample(input, result, axisX, axisY);
+	return true;
+}
+
+void ImageProcessingTools::BicubicResampleAxis(ResampleAxis& axis, const uint32_t& srcSize, const uint32_t& dstSize, const float32_t& scaleIndex, const float32_t& a)
+{
 	constexpr auto& Formula = ImageProcessingTools::bicubicConvolutionZoomFormula;
 
-	parallel::parallel_for(0u, result.height, [&result, &input, &a, &CalcSrcIndex, &Formula](uint32_t Y) {
-		float32_t dy = CalcSrcIndex(Y);
-		int64_t Row = dy;
-		dy -= Row;
+	axis.resize(dstSize, 4u);
 
-		for (uint32_t X = 0u; X < result.width; ++X)
+	for (uint32_t i = 0u; i < dstSize; ++i)
+	{
+		float32_t d = std::fmaxf(0.0f, (i + 0.5f) * scaleIndex - 0.5f);
+		const int64_t base = d;
+		d -= base;
+
+		int32_t* index = axis.indexAt(i);
+		float32_t* weight = axis.weightAt(i);
+
+		//taps at base - 1 to base + 2
+		for (int64_t k = 0; k < 4; ++k)
 		{
-			float32_t dx = CalcSrcIndex(X);
-			int64_t Column = dx;
-			dx -= Column;
+			int64_t source = base - 1 + k;
+			BorderClamp::Resolve(source, srcSize);
 
-			//Construct the weight matrix
-			floatVec4 kernelX[4];
-			floatVec4 kernelY[4];
+			index[k] = static_cast<int32_t>(source);
+			weight[k] = Formula(a, static_cast<float32_t>(k - 1) - d);
+		}
+	}
+}
+
+void ImageProcessingTools::SeparableResample(TextureData& input, TextureData& result, const ResampleAxis& axisX, const ResampleAxis& axisY, const float32_t& bias)
+{
+	//output rows per band, the horizontal pass of a band is kept in a per-thread float buffer
+	constexpr uint32_t bandRows = 16u;
+	const uint32_t bandCount = (result.height + bandRows - 1u) / bandRows;
+
+	parallel::parallel_for(0u, bandCount, [&input, &result, &axisX, &axisY, &bias](uint32_t band) {
+		thread_local std::vector<floatVec4> horizontal;
+
+		const uint32_t yBegin = band * bandRows;
+		const uint32_t yEnd = min(yBegin + bandRows, result.height);
 
-			//Pay attention to the high and low
-			kernelX[0] = floatVec4(Formula(a, 2.0f - dx), Formula(a, 1.0f - dx), Formula(a, 0.0f - dx), Formula(a, -1.0f - dx));
-			kernelX[1] = kernelX[0];
-			kernelX[2] = kernelX[0];
-			kernelX[3] = kernelX[0];
+		//the source rows this band reads
+		int32_t rowBegin = static_cast<int32_t>(input.height);
+		int32_t rowEnd = 0;
 
-			kernelY[0] = floatVec4(Formula(a, -1.0f - dy));
-			kernelY[1] = floatVec4(Formula(a, 0.0f - dy));
-			kernelY[2] = floatVec4(Formula(a, 1.0f - dy));
-			kernelY[3] = floatVec4(Formula(a, 2.0f - dy));
+		for (uint32_t Y = yBegin; Y < yEnd; ++Y)
+		{
+			const int32_t* index = axisY.indexAt(Y);
 
-			kernelX[0] *= kernelY[0];
-			kernelX[1] *= kernelY[1];
-			kernelX[2] *= kernelY[2];
-			kernelX[3] *= kernelY[3];
+			for (uint32_t k = 0u; k < axisY.taps; ++k)
+			{
+				rowBegin = min(rowBegin, index[k]);
+				rowEnd = max(rowEnd, index[k] + 1);
+			}
+		}
 
-			const auto& kernel = kernelX;
+		horizontal.resize(static_cast<size_t>(rowEnd - rowBegin) * result.width);
 
-			// Unrolling loops to enhance performance
-			RGBAColor_32f rgba_f(0.0f, 0.0f, 0.0f, 0.0f);
+		for (int32_t Row = rowBegin; Row < rowEnd; ++Row)
+		{
+			const RGBAColor_8i* source = input.row(Row);
+			floatVec4* target = horizontal.data() + static_cast<size_t>(Row - rowBegin) * result.width;
+
+			for (uint32_t X = 0u; X < result.width; ++X)
+			{
+				const int32_t* index = axisX.indexAt(X);
+				const float32_t* weight = axisX.weightAt(X);
 
-			rgba_f += RGBAColor_32f(input(Column + (-1), Row + (-1)), kernel[0][0]);
-			rgba_f += RGBAColor_32f(input(Column + (0), Row + (-1)), kernel[0][1]);
-			rgba_f += RGBAColor_32f(input(Column + (1), Row + (-1)), kernel[0][2]);
-			rgba_f += RGBAColor_32f(input(Column + (2), Row + (-1)), kernel[0][3]);
+				RGBAColor_32f rgba_f(0.0f, 0.0f, 0.0f, 0.0f);
 
-			rgba_f += RGBAColor_32f(input(Column + (-1), Row + (0)), kernel[1][0]);
-			rgba_f += RGBAColor_32f(input(Column + (0), Row + (0)), kernel[1][1]);
-			rgba_f += RGBAColor_32f(input(Column + (1), Row + (0)), kernel[1][2]);
-			rgba_f += RGBAColor_32f(input(Column + (2), Row + (0)), kernel[1][3]);
+				for (uint32_t k = 0u; k < axisX.taps; ++k)
+				{
+					rgba_f += RGBAColor_32f(source[index[k]], weight[k]);
+				}
+				target[X] = rgba_f;
+			}
+		}
 
-			rgba_f += RGBAColor_32f(input(Column + (-1), Row + (1)), kernel[2][0]);
-			rgba_f += RGBAColor_32f(input(Column + (0), Row + (1)), kernel[2][1]);
-			rgba_f += RGBAColor_32f(input(Column + (1), Row + (1)), kernel[2][2]);
-			rgba_f += RGBAColor_32f(input(Column + (2), Row + (1)), kernel[2][3]);
+		for (uint32_t Y = yBegin; Y < yEnd; ++Y)
+		{
+			const int32_t* index = axisY.indexAt(Y);
+			const float32_t* weight = axisY.weightAt(Y);
+			RGBAColor_8i* output = result.row(Y);
 
-			rgba_f += RGBAColor_32f(input(Column + (-1), Row + (2)), kernel[3][0]);
-			rgba_f += RGBAColor_32f(input(Column + (0), Row + (2)), kernel[3][1]);
-			rgba_f += RGBAColor_32f(input(Column + (1), Row + (2)), kernel[3][2]);
-			rgba_f += RGBAColor_32f(input(Column + (2), Row + (2)), kernel[3][3]);
+			for (uint32_t X = 0u; X < result.width; ++X)
+			{
+				RGBAColor_32f rgba_f(bias, bias, bias, bias);
 
-			result(X, Y) = rgba_f.toRGBAColor_8i();
+				for (uint32_t k = 0u; k < axisY.taps; ++k)
+				{
+					rgba_f += horizontal[static_cast<size_t>(index[k] - rowBegin) * result.width + X] * weight[k];
+				}
+				output[X] = rgba_f.toRGBAColor_8i();
+			}
 		}
 		});
+}
+
+bool ImageProcessingTools::Zoom_Minification(TextureData& input, TextureData& result, const float32_t& magnification, const MinifyFilter& filter)
+{
+	if (input.getRGBA_uint8().size() == 0 || magnification <= 0.0f)//Handle it well, otherwise there will be problems in parallel
+		return false;
+
+	const uint32_t width = max(1u, static_cast<uint32_t>(input.width * magnification));
+	const uint32_t height = max(1u, static_cast<uint32_t>(input.height * magnification));
+
+	//integer box pre-reduction down to about twice the target size, the windowed filter does the rest
+	const uint32_t factor = static_cast<uint32_t>(0.5f / magnification);
+
+	TextureData reduced;
+
+	if (factor > 1u)
+		ImageProcessingTools::BoxReduce(input, reduced, factor);
+
+	TextureData& source = (factor > 1u) ? reduced : input;
+
+	ResampleAxis axisX, axisY;
+	ImageProcessingTools::MinifyResampleAxis(axisX, source.width, width, filter);
+	ImageProcessingTools::MinifyResampleAxis(axisY, source.height, height, filter);
+
+	result.resize(width, height);
+
+	ImageProcessingTools::SeparableResample(source, result, axisX, axisY, 0.5f * ColorPixTofloat);
 	return true;
 }
 
+void ImageProcessingTools::MinifyResampleAxis(ResampleAxis& axis, const uint32_t& srcSize, const uint32_t& dstSize, const MinifyFilter& filter)
+{
+	//source pixels per output pixel, the filter is stretched by it
+	const float64_t scale = static_cast<float64_t>(srcSize) / dstSize;
+	const float64_t support = (filter == MinifyFilter::lanczos3) ? 3.0 * scale : 0.5 * scale;
+
+	axis.resize(dstSize, static_cast<uint32_t>(std::ceil(2.0 * support)) + 1u);
+
+	for (uint32_t i = 0u; i < dstSize; ++i)
+	{
+		//source pixel j covers [j, j + 1)
+		const float64_t center = (i + 0.5) * scale;
+		const int64_t first = static_cast<int64_t>(std::floor(center - support));
+
+		int32_t* index = axis.indexAt(i);
+		float32_t* weight = axis.weightAt(i);
+		float64_t sum = 0.0;
+
+		for (uint32_t k = 0u; k < axis.taps; ++k)
+		{
+			int64_t source = first + k;
+
+			float64_t w;
+			if (filter == MinifyFilter::lanczos3)
+			{
+				w = ImageProcessingTools::lanczos3Formula(static_cast<float32_t>((source + 0.5 - center) / scale));
+			}
+			else
+			{
+				//the overlap of the pixel with the output footprint
+				w = max(0.0, min(source + 1.0, center + support) - max(static_cast<float64_t>(source), center - support));
+			}
+
+			BorderClamp::Resolve(source, srcSize);
+
+			index[k] = static_cast<int32_t>(source);
+			weight[k] = static_cast<float32_t>(w);
+			sum += w;
+		}
+
+		//normalized so flat areas keep their color
+		for (uint32_t k = 0u; k < axis.taps; ++k)
+		{
+			weight[k] = static_cast<float32_t>(weight[k] / sum);
+		}
+	}
+}
+
+void ImageProcessingTools::BoxReduce(TextureData& input, TextureData& result, const uint32_t& factor)
+{
+	result.resize((input.width + factor - 1u) / factor, (input.height + factor - 1u) / factor);
+
+	parallel::parallel_for(0u, result.height, [&input, &result, &factor](uint32_t Y) {
+		thread_local std::vector<uint64_t> sums;
+		sums.assign(static_cast<size_t>(result.width) << 2u, 0u);
+
+		const uint32_t yBegin = Y * factor;
+		const uint32_t yEnd = min(yBegin + factor, input.height);
+
+		//walk the source rows in order, each output column sums its block of the row
+		for (uint32_t Row = yBegin; Row < yEnd; ++Row)
+		{
+			const RGBAColor_8i* source = input.row(Row);
+
+			for (uint32_t X = 0u; X < result.width; ++X)
+			{
+				const uint32_t xEnd = min((X + 1u) * factor, input.width);
+				uint64_t* sum = sums.data() + (static_cast<size_t>(X) << 2u);
+
+				for (uint32_t Column = X * factor; Column < xEnd; ++Column)
+				{
+					sum[0] += source[Column].R;
+					sum[1] += source[Column].G;
+					sum[2] += source[Column].B;
+					sum[3] += source[Column].A;
+				}
+			}
+		}
+
+		RGBAColor_8i* output = result.row(Y);
+
+		for (uint32_t X = 0u; X < result.width; ++X)
+		{
+			//the last block of a row or column may be partial
+			const uint64_t count = static_cast<uint64_t>(yEnd - yBegin) * (min((X + 1u) * factor, input.width) - X * factor);
+			const uint64_t half = count >> 1u;
+			const uint64_t* sum = sums.data() + (static_cast<size_t>(X) << 2u);
+
+			output[X] = RGBAColor_8i(
+				static_cast<uint8_t>((sum[0] + half) / count),
+				static_cast<uint8_t>((sum[1] + half) / count),
+				static_cast<uint8_t>((sum[2] + half) / count),
+				static_cast<uint8_t>((sum[3] + half) / count));
+		}
+		});
+}
+
+/*
+* Sharpen kernels in 16-bit fixed point. The taps of a group share one weight, so a group is summed as 16-bit channels
+* and multiplied once by _mm_madd_epi16. The weights are scaled by 1 << shift and the center takes what the others leave,
+* so a flat area keeps its color exactly. This is the SSE2 path, PixelKernelTable::Sharpen does the same with wider registers.
+*/
+struct FixedSharpen
+{
+	//the weights of groups 0 1 and groups 2 3 interleaved, group 3 is the center pixel
+	__m128i pairs[2];
+	__m128i shift;
+	//the same for the wide kernels
+	int16_t weights16[4];
+	int32_t bits;
+
+	bool init(const float32_t(&weights)[3], const uint32_t(&counts)[3]);
+};
+
+//false if the weights are too large for 16 bits even unscaled
+bool FixedSharpen::init(const float32_t(&weights)[3], const uint32_t(&counts)[3])
+{
+	constexpr int64_t limit = INT16_MAX;
+
+	for (int32_t bits = 14; bits >= 0; --bits)
+	{
+		int64_t fixed[4] = { 0, 0, 0, int64_t(1) << bits };
+		bool fits = true;
+
+		for (size_t group = 0u; group < 3u; ++group)
+		{
+			fixed[group] = std::llround(static_cast<float64_t>(weights[group]) * (int64_t(1) << bits));
+			fixed[3] -= fixed[group] * counts[group];
+		}
+		for (const int64_t& weight : fixed)
+		{
+			fits = fits && (weight >= -limit) && (weight <= limit);
+		}
+
+		if (fits)
+		{
+			this->pairs[0] = _mm_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(fixed[1]) << 16u) | (static_cast<uint32_t>(fixed[0]) & 0xFFFFu)));
+			this->pairs[1] = _mm_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(fixed[3]) << 16u) | (static_cast<uint32_t>(fixed[2]) & 0xFFFFu)));
+			this->shift = _mm_cvtsi32_si128(bits);
+
+			for (size_t group = 0u; group < 4u; ++group)
+			{
+				this->weights16[group] = static_cast<int16_t>(fixed[group]);
+			}
+			this->bits = bits;
+			return true;
+		}
+	}
+	return false;
+}
+
+//4 interior pixels from X on, center[dy] is the row dy away, a group sums at most 12 taps of 255
+template<size_t N>
+static void SharpenFixed(const RGBAColor_8i* const* center, const int64_t& X, const SharpenTap(&taps)[N], const FixedSharpen& kernel, RGBAColor_8i* output)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sums[4][2] = {};
+
+	for (const SharpenTap& tap : taps)
+	{
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center[tap.dy] + X + tap.dx));
+
+		sums[tap.group][0] = _mm_add_epi16(sums[tap.group][0], _mm_unpacklo_epi8(bytes, zero));
+		sums[tap.group][1] = _mm_add_epi16(sums[tap.group][1], _mm_unpackhi_epi8(bytes, zero));
+	}
+
+	__m128i halves[2];
+	for (size_t half = 0u; half < 2u; ++half)
+	{
+		//one pixel of 4 int32 channels each
+		const __m128i first = _mm_add_epi32(
+			_mm_madd_epi16(_mm_unpacklo_epi16(sums[0][half], sums[1][half]), kernel.pairs[0]),
+			_mm_madd_epi16(_mm_unpacklo_epi16(sums[2][half], sums[3][half]), kernel.pairs[1]));
+		const __m128i second = _mm_add_epi32(
+			_mm_madd_epi16(_mm_unpackhi_epi16(sums[0][half], sums[1][half]), kernel.pairs[0]),
+			_mm_madd_epi16(_mm_unpackhi_epi16(sums[2][half], sums[3][half]), kernel.pairs[1]));
+
+		//truncated like toRGBAColor_8i, both packs saturate so the clamp comes with them
+		halves[half] = _mm_packs_epi32(_mm_sra_epi32(first, kernel.shift), _mm_sra_epi32(second, kernel.shift));
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(output + X), _mm_packus_epi16(halves[0], halves[1]));
+}
+
 bool ImageProcessingTools::SharpenLaplace3x3(TextureData& input, TextureData& result, const float32_t& strength)
 {
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	result.width = input.width;
-	result.height = input.height;
-
-	auto& resultRGBA = result.getRGBA_uint8();
-	resultRGBA.resize(input.getRGBA_uint8().size());
+	result.resize(input.width, input.height);
 
 	const float32_t factor = -0.01f * strength;
 	constexpr float32_t oneHalfRoot = 0.70710678f;
@@ -258,29 +826,78 @@ bool ImageProcessingTools::SharpenLaplace3x3(TextureData& input, TextureData& re
 	const float32_t outerFar = factor * oneHalfRoot;
 	const float32_t center = 1.0f - (4.0f * oneHalfRootPlusOne) * factor;
 
-	parallel::parallel_for(0u, result.height, [&result, &input, &outerNear, &outerFar, &center](int64_t Y) {
-		for (int64_t X = 0u; X < result.width; ++X)
-		{
-			RGBAColor_32f rgba_f1(0.0f, 0.0f, 0.0f, 0.0f);
-			RGBAColor_32f rgba_f2(0.0f, 0.0f, 0.0f, 0.0f);
+	const auto Kernel = [&outerNear, &outerFar, &center](const auto& Fetch) {
+		RGBAColor_32f rgba_f1(0.0f, 0.0f, 0.0f, 0.0f);
+		RGBAColor_32f rgba_f2(0.0f, 0.0f, 0.0f, 0.0f);
+
+		rgba_f1 += RGBAColor_32f(Fetch(-1, -1));
+		rgba_f1 += RGBAColor_32f(Fetch(+1, -1));
+		rgba_f1 += RGBAColor_32f(Fetch(-1, +1));
+		rgba_f1 += RGBAColor_32f(Fetch(+1, +1));
 
-			rgba_f1 += RGBAColor_32f(input(X - 1, Y - 1));
-			rgba_f1 += RGBAColor_32f(input(X + 1, Y - 1));
-			rgba_f1 += RGBAColor_32f(input(X - 1, Y + 1));
-			rgba_f1 += RGBAColor_32f(input(X + 1, Y + 1));
+		rgba_f2 += RGBAColor_32f(Fetch(+0, -1));
+		rgba_f2 += RGBAColor_32f(Fetch(-1, +0));
+		rgba_f2 += RGBAColor_32f(Fetch(+1, +0));
+		rgba_f2 += RGBAColor_32f(Fetch(+0, +1));
 
-			rgba_f2 += RGBAColor_32f(input(X + 0, Y - 1));
-			rgba_f2 += RGBAColor_32f(input(X - 1, Y + 0));
-			rgba_f2 += RGBAColor_32f(input(X + 1, Y + 0));
-			rgba_f2 += RGBAColor_32f(input(X + 0, Y + 1));
+		rgba_f1 *= outerFar;
+		rgba_f2 *= outerNear;
+
+		rgba_f1 += RGBAColor_32f(Fetch(+0, +0), center);
+		rgba_f1 += rgba_f2;
+
+		return rgba_f1.toRGBAColor_8i();
+		};
 
-			rgba_f1 *= outerFar;
-			rgba_f2 *= outerNear;
+	static constexpr SharpenTap taps[] = {
+		{ -1, -1, 0 }, { +1, -1, 0 }, { -1, +1, 0 }, { +1, +1, 0 },
+		{ +0, -1, 1 }, { -1, +0, 1 }, { +1, +0, 1 }, { +0, +1, 1 },
+		{ +0, +0, 3 }
+	};
 
-			rgba_f1 += RGBAColor_32f(input(X + 0, Y + 0), center);
-			rgba_f1 += rgba_f2;
+	FixedSharpen fixed;
+	const bool useFixed = fixed.init({ outerFar, outerNear, 0.0f }, { 4u, 4u, 0u });
+	const PixelKernelTable* const wide = useFixed ? ImageProcessingTools::WidePixelKernels() : nullptr;
+
+	CppParallelAccelerator::parallel_for_tile(result.width, result.height, 1u, sizeof(RGBAColor_8i), [&result, &input, &Kernel, &fixed, &wide, &useFixed](const ParallelTile& tile) {
+		int64_t interiorXBegin, interiorXEnd, interiorYBegin, interiorYEnd;
+		InteriorSpan(tile.xBegin, tile.xEnd, 1, input.width, interiorXBegin, interiorXEnd);
+		InteriorSpan(tile.yBegin, tile.yEnd, 1, input.height, interiorYBegin, interiorYEnd);
+
+		for (int64_t Y = tile.yBegin; Y < tile.yEnd; ++Y)
+		{
+			RGBAColor_8i* output = result.row(Y);
+			int64_t X = tile.xBegin;
+
+			const auto Border = [&input, &X, &Y](const int64_t& dx, const int64_t& dy) { return input.sample<BorderClamp>(X + dx, Y + dy); };
+
+			if (Y >= interiorYBegin && Y < interiorYEnd)
+			{
+				const RGBAColor_8i* rows[3] = { input.row(Y - 1), input.row(Y), input.row(Y + 1) };
+				const auto Interior = [&rows, &X](const int64_t& dx, const int64_t& dy) -> const RGBAColor_8i& { return rows[1 + dy][X + dx]; };
+
+				for (; X < interiorXBegin; ++X)
+				{
+					output[X] = Kernel(Border);
+				}
+				if (wide && X < interiorXEnd)
+				{
+					X += static_cast<int64_t>(wide->Sharpen(reinterpret_cast<const uint32_t* const*>(rows + 1), X, static_cast<size_t>(interiorXEnd - X), taps, std::size(taps), fixed.weights16, fixed.bits, reinterpret_cast<uint32_t*>(output)));
+				}
+				for (; useFixed && X + 4 <= interiorXEnd; X += 4)
+				{
+					SharpenFixed(rows + 1, X, taps, fixed, output);
+				}
+				for (; X < interiorXEnd; ++X)
+				{
+					output[X] = Kernel(Interior);
+				}
+			}
 
-			result(X, Y) = rgba_f1.toRGBAColor_8i();
+			for (; X < tile.xEnd; ++X)
+			{
+				output[X] = Kernel(Border);
+			}
 		}
 		});
 	return true;
@@ -291,11 +908,7 @@ bool ImageProcessingTools::SharpenGaussLaplace5x5(TextureData& input, TextureDat
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	result.width = input.width;
-	result.height = input.height;
-
-	auto& resultRGBA = result.getRGBA_uint8();
-	resultRGBA.resize(input.getRGBA_uint8().size());
+	result.resize(input.width, input.height);
 
 	float32_t factor = -0.002f * strength;
 	/*
@@ -315,79 +928,217 @@ bool ImageProcessingTools::SharpenGaussLaplace5x5(TextureData& input, TextureDat
 	//const float32_t outerl1Far = 0.0f;
 	const float32_t center = 1.0f - 12.0f * factor;
 
-	parallel::parallel_for(0u, result.height, [&result, &input, &outerl2Far, &outerl2Near, &outerl1Near, &center](int64_t Y) {
-		for (int64_t X = 0u; X < result.width; ++X)
-		{
-			RGBAColor_32f rgba_f1(0.0f, 0.0f, 0.0f, 0.0f);
-			RGBAColor_32f rgba_f2(0.0f, 0.0f, 0.0f, 0.0f);
-			RGBAColor_32f rgba_f3(0.0f, 0.0f, 0.0f, 0.0f);
-
-			rgba_f1 += RGBAColor_32f(input(X - 2, Y - 2));
-			rgba_f1 += RGBAColor_32f(input(X + 2, Y - 2));
-			rgba_f1 += RGBAColor_32f(input(X - 2, Y + 2));
-			rgba_f1 += RGBAColor_32f(input(X + 2, Y + 2));
-
-			rgba_f2 += RGBAColor_32f(input(X - 1, Y - 2));
-			rgba_f2 += RGBAColor_32f(input(X + 0, Y - 2));
-			rgba_f2 += RGBAColor_32f(input(X + 1, Y - 2));
-			rgba_f2 += RGBAColor_32f(input(X - 2, Y - 1));
-			rgba_f2 += RGBAColor_32f(input(X - 2, Y + 0));
-			rgba_f2 += RGBAColor_32f(input(X - 2, Y + 1));
-			rgba_f2 += RGBAColor_32f(input(X + 2, Y - 1));
-			rgba_f2 += RGBAColor_32f(input(X + 2, Y + 0));
-			rgba_f2 += RGBAColor_32f(input(X + 2, Y + 1));
-			rgba_f2 += RGBAColor_32f(input(X - 1, Y + 2));
-			rgba_f2 += RGBAColor_32f(input(X + 0, Y + 2));
-			rgba_f2 += RGBAColor_32f(input(X + 1, Y + 2));
-
-			rgba_f3 += RGBAColor_32f(input(X + 0, Y - 1));
-			rgba_f3 += RGBAColor_32f(input(X - 1, Y + 0));
-			rgba_f3 += RGBAColor_32f(input(X + 1, Y + 0));
-			rgba_f3 += RGBAColor_32f(input(X + 0, Y + 1));
-
-			rgba_f1 *= outerl2Far;
-			rgba_f2 *= outerl2Near;
-			rgba_f3 *= outerl1Near;
-
-			rgba_f1 += RGBAColor_32f(input(X + 0, Y + 0), center);
-			rgba_f1 += rgba_f2;
-			rgba_f1 += rgba_f3;
-
-			result(X, Y) = rgba_f1.toRGBAColor_8i();
+	const auto Kernel = [&outerl2Far, &outerl2Near, &outerl1Near, &center](const auto& Fetch) {
+		RGBAColor_32f rgba_f1(0.0f, 0.0f, 0.0f, 0.0f);
+		RGBAColor_32f rgba_f2(0.0f, 0.0f, 0.0f, 0.0f);
+		RGBAColor_32f rgba_f3(0.0f, 0.0f, 0.0f, 0.0f);
+
+		rgba_f1 += RGBAColor_32f(Fetch(-2, -2));
+		rgba_f1 += RGBAColor_32f(Fetch(+2, -2));
+		rgba_f1 += RGBAColor_32f(Fetch(-2, +2));
+		rgba_f1 += RGBAColor_32f(Fetch(+2, +2));
+
+		rgba_f2 += RGBAColor_32f(Fetch(-1, -2));
+		rgba_f2 += RGBAColor_32f(Fetch(+0, -2));
+		rgba_f2 += RGBAColor_32f(Fetch(+1, -2));
+		rgba_f2 += RGBAColor_32f(Fetch(-2, -1));
+		rgba_f2 += RGBAColor_32f(Fetch(-2, +0));
+		rgba_f2 += RGBAColor_32f(Fetch(-2, +1));
+		rgba_f2 += RGBAColor_32f(Fetch(+2, -1));
+		rgba_f2 += RGBAColor_32f(Fetch(+2, +0));
+		rgba_f2 += RGBAColor_32f(Fetch(+2, +1));
+		rgba_f2 += RGBAColor_32f(Fetch(-1, +2));
+		rgba_f2 += RGBAColor_32f(Fetch(+0, +2));
+		rgba_f2 += RGBAColor_32f(Fetch(+1, +2));
+
+		rgba_f3 += RGBAColor_32f(Fetch(+0, -1));
+		rgba_f3 += RGBAColor_32f(Fetch(-1, +0));
+		rgba_f3 += RGBAColor_32f(Fetch(+1, +0));
+		rgba_f3 += RGBAColor_32f(Fetch(+0, +1));
+
+		rgba_f1 *= outerl2Far;
+		rgba_f2 *= outerl2Near;
+		rgba_f3 *= outerl1Near;
+
+		rgba_f1 += RGBAColor_32f(Fetch(+0, +0), center);
+		rgba_f1 += rgba_f2;
+		rgba_f1 += rgba_f3;
+
+		return rgba_f1.toRGBAColor_8i();
+		};
+
+	static constexpr SharpenTap taps[] = {
+		{ -2, -2, 0 }, { +2, -2, 0 }, { -2, +2, 0 }, { +2, +2, 0 },
+		{ -1, -2, 1 }, { +0, -2, 1 }, { +1, -2, 1 }, { -2, -1, 1 }, { -2, +0, 1 }, { -2, +1, 1 },
+		{ +2, -1, 1 }, { +2, +0, 1 }, { +2, +1, 1 }, { -1, +2, 1 }, { +0, +2, 1 }, { +1, +2, 1 },
+		{ +0, -1, 2 }, { -1, +0, 2 }, { +1, +0, 2 }, { +0, +1, 2 },
+		{ +0, +0, 3 }
+	};
+
+	FixedSharpen fixed;
+	const bool useFixed = fixed.init({ outerl2Far, outerl2Near, outerl1Near }, { 4u, 12u, 4u });
+	const PixelKernelTable* const wide = useFixed ? ImageProcessingTools::WidePixelKernels() : nullptr;
+
+	CppParallelAccelerator::parallel_for_tile(result.width, result.height, 2u, sizeof(RGBAColor_8i), [&result, &input, &Kernel, &fixed, &wide, &useFixed](const ParallelTile& tile) {
+		int64_t interiorXBegin, interiorXEnd, interiorYBegin, interiorYEnd;
+		InteriorSpan(tile.xBegin, tile.xEnd, 2, input.width, interiorXBegin, interiorXEnd);
+		InteriorSpan(tile.yBegin, tile.yEnd, 2, input.height, interiorYBegin, interiorYEnd);
+
+		for (int64_t Y = tile.yBegin; Y < tile.yEnd; ++Y)
+		{
+			RGBAColor_8i* output = result.row(Y);
+			int64_t X = tile.xBegin;
+
+			const auto Border = [&input, &X, &Y](const int64_t& dx, const int64_t& dy) { return input.sample<BorderClamp>(X + dx, Y + dy); };
+
+			if (Y >= interiorYBegin && Y < interiorYEnd)
+			{
+				const RGBAColor_8i* rows[5] = { input.row(Y - 2), input.row(Y - 1), input.row(Y), input.row(Y + 1), input.row(Y + 2) };
+				const auto Interior = [&rows, &X](const int64_t& dx, const int64_t& dy) -> const RGBAColor_8i& { return rows[2 + dy][X + dx]; };
+
+				for (; X < interiorXBegin; ++X)
+				{
+					output[X] = Kernel(Border);
+				}
+				if (wide && X < interiorXEnd)
+				{
+					X += static_cast<int64_t>(wide->Sharpen(reinterpret_cast<const uint32_t* const*>(rows + 2), X, static_cast<size_t>(interiorXEnd - X), taps, std::size(taps), fixed.weights16, fixed.bits, reinterpret_cast<uint32_t*>(output)));
+				}
+				for (; useFixed && X + 4 <= interiorXEnd; X += 4)
+				{
+					SharpenFixed(rows + 2, X, taps, fixed, output);
+				}
+				for (; X < interiorXEnd; ++X)
+				{
+					output[X] = Kernel(Interior);
+				}
+			}
+
+			for (; X < tile.xEnd; ++X)
+			{
+				output[X] = Kernel(Border);
+			}
 		}
 		});
 	return true;
 }
 
 bool ImageProcessingTools::AecsHdrToneMapping(TextureData& inputOutput, const float32_t& lumRatio)
+{
+	return ChannelLutTransform(inputOutput, ToneMappingLut(lumRatio));
+}
+
+ChannelLut ImageProcessingTools::ToneMappingLut(const float32_t& lumRatio)
+{
+	//the curve of every channel only depends on its own value, 256 evaluations cover the image
+	return ChannelLut::Bake([&lumRatio](const RGBAColor_8i& pixel) {
+		RGBAColor_32f color(pixel);
+
+		ImageProcessingTools::ACESToneMappingColor(color, lumRatio);
+
+		return color.toRGBAColor_8i();
+		});
+}
+
+ChannelLut ImageProcessingTools::ReverseColorLut()
+{
+	return ChannelLut::Bake([](RGBAColor_8i pixel) {
+		ImageProcessingTools::ReverseColor(pixel);
+		return pixel;
+		});
+}
+
+void ImageProcessingTools::ChannelLutRow(RGBAColor_8i* row, const size_t& count, const ChannelLut& lut)
+{
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		kernels->ApplyLut(reinterpret_cast<uint32_t*>(row), count, lut.table);
+		return;
+	}
+
+	for (size_t X = 0u; X < count; ++X)
+	{
+		row[X] = lut.Lookup(row[X]);
+	}
+}
+
+bool ImageProcessingTools::ChannelLutTransform(TextureData& inputOutput, const ChannelLut& lut)
 {
 	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	inputOutput.clearImage();
+	parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &lut](uint32_t Y) {
+		ImageProcessingTools::ChannelLutRow(inputOutput.row(Y), inputOutput.width, lut);
+		});
+	return true;
+}
+
+void ImageProcessingTools::ColorCubeRow(RGBAColor_8i* row, const size_t& count, const ColorCube& cube)
+{
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		kernels->ApplyCube(reinterpret_cast<uint32_t*>(row), count, cube.lattice.front().arr, cube.size, cube.scale, cube.bias, cube.alpha);
+		return;
+	}
 
-	parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &lumRatio](uint32_t Y) {
-		for (auto X = 0u; X < inputOutput.width; ++X)
-		{
-			RGBAColor_32f color(inputOutput(X, Y));
+	for (size_t X = 0u; X < count; ++X)
+	{
+		row[X] = cube.Lookup(row[X]);
+	}
+}
 
-			ImageProcessingTools::ACESToneMappingColor(color, lumRatio);
+bool ImageProcessingTools::ColorCubeTransform(TextureData& inputOutput, const ColorCube& cube)
+{
+	if (inputOutput.getRGBA_uint8().size() == 0 || cube.size < ColorCube::minSize)//Handle it well, otherwise there will be problems in parallel
+		return false;
 
-			inputOutput(X, Y) = color.toRGBAColor_8i();
-		}
+	parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &cube](uint32_t Y) {
+		ImageProcessingTools::ColorCubeRow(inputOutput.row(Y), inputOutput.width, cube);
 		});
 	return true;
 }
 
+ColorCube ImageProcessingTools::PointOperationCube(const std::vector<PointOperation>& chain, const uint32_t& size)
+{
+	return ColorCube::Bake(size, [&chain](RGBAColor_32f color) {
+		for (const PointOperation& operation : chain)
+		{
+			switch (operation.kind)
+			{
+			case PointOperation::Kind::toneMapping:
+				ImageProcessingTools::ACESToneMappingColor(color, operation.param[0]);
+				break;
+			case PointOperation::Kind::vividness:
+				ImageProcessingTools::VividnessAdjustmentColor(color, operation.param[0]);
+				break;
+			case PointOperation::Kind::natualVividness:
+				ImageProcessingTools::NatualVividnessAdjustmentColor(color, operation.param[0]);
+				break;
+			case PointOperation::Kind::hslAdjustment:
+				ImageProcessingTools::HSLAdjustmentColor(color, operation.param[0], operation.param[1], operation.param[2]);
+				break;
+			case PointOperation::Kind::reverseColor:
+				color = RGBAColor_32f(1.0f) - color;
+				break;
+			default:
+				break;
+			}
+
+			//what the 8-bit round trip between two steps would clamp
+			Clamp(color.R, 0.0f, 1.0f);
+			Clamp(color.G, 0.0f, 1.0f);
+			Clamp(color.B, 0.0f, 1.0f);
+			Clamp(color.A, 0.0f, 1.0f);
+		}
+		return color;
+		});
+}
+
 bool ImageProcessingTools::ReverseColorImage(TextureData& inputOutput)
 {
 	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	inputOutput.clearImage();
-
 	for (auto& color : inputOutput.getRGBA_uint8())
 	{
 		ReverseColor(color);
@@ -400,19 +1151,25 @@ bool ImageProcessingTools::Grayscale(TextureData& input, TextureData& result)
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	input.clearImage();
+	result.resize(input.width, input.height, 1u);
 
-	result.width = input.width;
-	result.height = input.height;
-	result.image.resize(input.getRGBA_uint8().size());
+	const GrayLut& lut = GrayTables();
 
-	parallel::parallel_for(0u, input.height, [&input, &result](uint32_t Y) {
-		size_t offset = static_cast<size_t>(input.width) * Y;
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		parallel::parallel_for(0u, input.height, [&input, &result, &lut, kernels](uint32_t Y) {
+			kernels->Grayscale(reinterpret_cast<const uint32_t*>(input.row(Y)), result.image.data() + static_cast<size_t>(input.width) * Y, input.width, lut.linear, lut.coarse, lut.thresholds);
+			});
+		return true;
+	}
+
+	parallel::parallel_for(0u, input.height, [&input, &result, &lut](uint32_t Y) {
+		const RGBAColor_8i* row = input.row(Y);
+		byte* output = result.image.data() + static_cast<size_t>(input.width) * Y;
 
 		for (auto X = 0u; X < input.width; ++X)
 		{
-			ImageProcessingTools::GrayColor(input(X, Y), result.image[offset + X]);
+			output[X] = lut.Level(lut.linear[row[X].R] + lut.linear[GrayLut::entries + row[X].G] + lut.linear[2u * GrayLut::entries + row[X].B]);
 		}
 		});
 	return true;
@@ -423,16 +1180,9 @@ bool ImageProcessingTools::ChannelGrayScale(TextureData& input, TextureData& res
 	if (input.image.size() == 0)
 		return false;
 
-	resultR.width = input.width;
-	resultR.height = input.height;
-	resultG.width = input.width;
-	resultG.height = input.height;
-	resultB.width = input.width;
-	resultB.height = input.height;
-
-	resultR.image.resize(input.image.size() >> 2);
-	resultG.image.resize(input.image.size() >> 2);
-	resultB.image.resize(input.image.size() >> 2);
+	resultR.resize(input.width, input.height, 1u);
+	resultG.resize(input.width, input.height, 1u);
+	resultB.resize(input.width, input.height, 1u);
 
 	for (size_t i = 0; i < input.image.size(); i += 4)
 	{
@@ -455,8 +1205,13 @@ bool ImageProcessingTools::VividnessAdjustment(TextureData& inputOutput, const f
 	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	inputOutput.clearImage();
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &vividRatio, kernels](uint32_t Y) {
+			kernels->Vividness(reinterpret_cast<uint32_t*>(inputOutput.row(Y)), inputOutput.width, vividRatio);
+			});
+		return true;
+	}
 
 	parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &vividRatio](uint32_t Y) {
 		for (auto X = 0u; X < inputOutput.width; ++X)
@@ -476,8 +1231,13 @@ bool ImageProcessingTools::NatualVividnessAdjustment(TextureData& inputOutput, c
 	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	inputOutput.clearImage();
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &vividRatio, kernels](uint32_t Y) {
+			kernels->NatualVividness(reinterpret_cast<uint32_t*>(inputOutput.row(Y)), inputOutput.width, vividRatio);
+			});
+		return true;
+	}
 
 	parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &vividRatio](uint32_t Y) {
 		for (auto X = 0u; X < inputOutput.width; ++X)
@@ -497,12 +1257,15 @@ bool ImageProcessingTools::Binarization(TextureData& input, TextureData& result,
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	input.clearImage();
+	result.resize(input.width, input.height, 1u);
 
-	result.width = input.width;
-	result.height = input.height;
-	result.image.resize(input.getRGBA_uint8().size());
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		parallel::parallel_for(0u, input.height, [&input, &result, &threshold, kernels](uint32_t Y) {
+			kernels->Binarization(reinterpret_cast<const uint32_t*>(input.row(Y)), result.image.data() + static_cast<size_t>(input.width) * Y, input.width, threshold);
+			});
+		return true;
+	}
 
 	parallel::parallel_for(0u, input.height, [&input, &result, &threshold](uint32_t Y) {
 		size_t offset = static_cast<size_t>(input.width) * Y;
@@ -520,12 +1283,7 @@ bool ImageProcessingTools::Quaternization(TextureData& input, TextureData& resul
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	input.clearImage();
-
-	result.width = input.width;
-	result.height = input.height;
-	result.image.resize(input.getRGBA_uint8().size());
+	result.resize(input.width, input.height, 1u);
 
 	parallel::parallel_for(0u, input.height, [&input, &result, &threshold](uint32_t Y) {
 		size_t offset = static_cast<size_t>(input.width) * Y;
@@ -543,12 +1301,7 @@ bool ImageProcessingTools::Hexadecimalization(TextureData& input, TextureData& r
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	input.clearImage();
-
-	result.width = input.width;
-	result.height = input.height;
-	result.image.resize(input.getRGBA_uint8().size());
+	result.resize(input.width, input.height, 1u);
 
 	parallel::parallel_for(0u, input.height, [&input, &result](uint32_t Y) {
 		size_t offset = static_cast<size_t>(input.width) * Y;
@@ -566,48 +1319,29 @@ bool ImageProcessingTools::SurfaceBlur(TextureData& input, TextureData& result,
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	result.width = input.width;
-	result.height = input.height;
-
-	auto& resultRGBA = result.getRGBA_uint8();
-	resultRGBA.resize(input.getRGBA_uint8().size());
+	result.resize(input.width, input.height);
 
 	const float32_t denominator = 0.40f / threshold;
 
-	parallel::parallel_for(0u, result.height, [&result, &input, &radius, &denominator](uint32_t Y) {
-		auto toGray = [](const RGBAColor_32f& rgba_f)
-			{
-				return fabsf((rgba_f.R + rgba_f.G + rgba_f.B) * 0.33333f);
-			};
-
-		for (auto X = 0u; X < result.width; ++X)
-		{
-			RGBAColor_32f center(input(X, Y));
-			RGBAColor_32f pixelSum(0.0f, 0.0f, 0.0f, 0.0f);
-
-			float32_t sum = 0.0f;
-			float32_t weight;
-
-			for (int64_t h = -radius; h <= radius; ++h)
-			{
-				for (int64_t w = -radius; w <= radius; ++w)
-				{
-					RGBAColor_32f pixel(input(X + w, Y + h));
-					pixel -= center;
+	/*
+		weight = 1 - |gray(pixel - center)| * denominator
+		       = 1 - k * |S_p - S_c|, S = R + G + B, k = 0.33333 * denominator / 255
+		the weight is linear on both sides of S_c, so every window sum is a total minus twice the part below S_c
+	*/
+	const float64_t k = static_cast<float64_t>(0.33333f) * denominator / maxColorPix;
 
-					weight = 1.0f - (toGray(pixel) * denominator);
+	constexpr uint32_t tileSide = 256u;
+	const uint32_t tilesX = (result.width + tileSide - 1u) / tileSide;
+	const uint32_t tilesY = (result.height + tileSide - 1u) / tileSide;
 
-					sum += weight;
+	parallel::parallel_for(0u, tilesX * tilesY, [&result, &input, &radius, &k, &tilesX](uint32_t index) {
+		ParallelTile tile = {};
+		tile.xBegin = (index % tilesX) * tileSide;
+		tile.xEnd = min(tile.xBegin + tileSide, result.width);
+		tile.yBegin = (index / tilesX) * tileSide;
+		tile.yEnd = min(tile.yBegin + tileSide, result.height);
 
-					pixelSum += RGBAColor_32f(input(X + w, Y + h), weight);
-				}
-			}
-
-			pixelSum /= sum;
-			pixelSum.A = center.A;
-
-			result(X, Y) = pixelSum.toRGBAColor_8i();
-		}
+		SurfaceBlurTile(input, result, tile, radius, k);
 		});
 	return true;
 }
@@ -617,103 +1351,140 @@ bool ImageProcessingTools::SobelEdgeEnhancement(TextureData& input, TextureData&
 	if (input.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	result.width = input.width;
-	result.height = input.height;
+	result.resize(input.width, input.height);
 
-	auto& resultRGBA = result.getRGBA_uint8();
-	resultRGBA.resize(input.getRGBA_uint8().size());
-
-	parallel::parallel_for(0u, result.height, [&result, &input, &thresholdMin, &thresholdMax, &strength](int64_t Y) {
-		for (int64_t X = 0u; X < result.width; ++X)
+	CppParallelAccelerator::parallel_for_tile(result.width, result.height, 1u, sizeof(RGBAColor_8i), [&result, &input, &thresholdMin, &thresholdMax, &strength](const ParallelTile& tile) {
+		for (int64_t Y = tile.yBegin; Y < tile.yEnd; ++Y)
 		{
-			RGBAColor_32f Gx(0.0f, 0.0f, 0.0f, 0.0f);
-			RGBAColor_32f Gy(0.0f, 0.0f, 0.0f, 0.0f);
+			for (int64_t X = tile.xBegin; X < tile.xEnd; ++X)
+			{
+				RGBAColor_32f Gx(0.0f, 0.0f, 0.0f, 0.0f);
+				RGBAColor_32f Gy(0.0f, 0.0f, 0.0f, 0.0f);
+
+				Gx += RGBAColor_32f(input(X - 1, Y - 1), -1.0f);
+				Gx += RGBAColor_32f(input(X + 1, Y - 1), 1.0f);
+				Gx += RGBAColor_32f(input(X - 1, Y + 0), -2.0f);
+				Gx += RGBAColor_32f(input(X + 1, Y + 0), 2.0f);
+				Gx += RGBAColor_32f(input(X - 1, Y + 1), -1.0f);
+				Gx += RGBAColor_32f(input(X + 1, Y + 1), 1.0f);
+
+				Gy += RGBAColor_32f(input(X - 1, Y - 1), 1.0f);
+				Gy += RGBAColor_32f(input(X + 0, Y - 1), 2.0f);
+				Gy += RGBAColor_32f(input(X + 1, Y - 1), 1.0f);
+				Gy += RGBAColor_32f(input(X - 1, Y + 1), -1.0f);
+				Gy += RGBAColor_32f(input(X + 0, Y + 1), -2.0f);
+				Gy += RGBAColor_32f(input(X + 1, Y + 1), -1.0f);
+
+				float32_t gx = Gx.R + Gx.G + Gx.B;
+				float32_t gy = Gy.R + Gy.G + Gy.B;
+
+				float32_t G = sqrtf((gx * gx) + (gy * gy)) * 0.33333f;
+
+				if (G < thresholdMin)
+					G = 0.0f;
+				else if (G <= thresholdMax)
+					G *= strength;
+
+				RGBAColor_32f center(G);
+				result(X, Y) = center.toRGBAColor_8i();
+				result(X, Y).A = input(X, Y).A;
+			}
+		}
+		});
+	return true;
+}
 
-			Gx += RGBAColor_32f(input(X - 1, Y - 1), -1.0f);
-			Gx += RGBAColor_32f(input(X + 1, Y - 1), 1.0f);
-			Gx += RGBAColor_32f(input(X - 1, Y + 0), -2.0f);
-			Gx += RGBAColor_32f(input(X + 1, Y + 0), 2.0f);
-			Gx += RGBAColor_32f(input(X - 1, Y + 1), -1.0f);
-			Gx += RGBAColor_32f(input(X + 1, Y + 1), 1.0f);
+//adds count RGBA pixels to the four uint32 lanes R G B A of sum
+static __m128i SumPixels(const RGBAColor_8i* pixels, const uint32_t& count, __m128i sum)
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t X = 0u;
 
-			Gy += RGBAColor_32f(input(X - 1, Y - 1), 1.0f);
-			Gy += RGBAColor_32f(input(X + 0, Y - 1), 2.0f);
-			Gy += RGBAColor_32f(input(X + 1, Y - 1), 1.0f);
-			Gy += RGBAColor_32f(input(X - 1, Y + 1), -1.0f);
-			Gy += RGBAColor_32f(input(X + 0, Y + 1), -2.0f);
-			Gy += RGBAColor_32f(input(X + 1, Y + 1), -1.0f);
+	//4 pixels a load, the two halves are added in 16 bits before they are widened
+	for (; X + 4u <= count; X += 4u)
+	{
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + X));
+		const __m128i pairs = _mm_add_epi16(_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero));
 
-			float32_t gx = Gx.R + Gx.G + Gx.B;
-			float32_t gy = Gy.R + Gy.G + Gy.B;
+		sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_unpacklo_epi16(pairs, zero), _mm_unpackhi_epi16(pairs, zero)));
+	}
 
-			float32_t G = sqrtf((gx * gx) + (gy * gy)) * 0.33333f;
+	for (; X < count; ++X)
+	{
+		sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int32_t>(pixels[X].data)), zero), zero));
+	}
+	return sum;
+}
 
-			if (G < thresholdMin)
-				G = 0.0f;
-			else if (G <= thresholdMax)
-				G *= strength;
+//count copies of color, 4 pixels a store
+static void FillPixels(RGBAColor_8i* pixels, const uint32_t& count, const RGBAColor_8i& color)
+{
+	const __m128i fill = _mm_set1_epi32(static_cast<int32_t>(color.data));
+	uint32_t X = 0u;
 
-			RGBAColor_32f center(G);
-			result(X, Y) = center.toRGBAColor_8i();
-			result(X, Y).A = input(X, Y).A;
-		}
-		});
-	return true;
+	for (; X + 4u <= count; X += 4u)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + X), fill);
+	}
+
+	for (; X < count; ++X)
+	{
+		pixels[X] = color;
+	}
 }
 
 bool ImageProcessingTools::MosaicPixelation(TextureData& inputOutput, const uint32_t& sideLength)
 {
-	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
+	if (inputOutput.getRGBA_uint8().size() == 0 || sideLength == 0u)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	inputOutput.clearImage();
+	const uint32_t blocks = (inputOutput.width + sideLength - 1u) / sideLength;
+	const size_t rowBytes = static_cast<size_t>(inputOutput.width) * sizeof(RGBAColor_8i);
 
-	parallel::parallel_for(0u, inputOutput.height, sideLength, [&inputOutput, &sideLength](uint32_t Y) {
-		//add column
-		for (auto h = 0u; (h < sideLength) && ((Y + h) < inputOutput.height); ++h)
-		{
-			for (auto X = 0u; X < inputOutput.width; X += sideLength)
-			{
-				RGBAColor_32f columnSum(inputOutput(X, (Y + h)));
+	//a task owns the rows of one band of blocks, every pixel of it is summed before any is written
+	parallel::parallel_for(0u, inputOutput.height, sideLength, [&inputOutput, &sideLength, &blocks, &rowBytes](uint32_t Y) {
+		const uint32_t rows = Min(sideLength, inputOutput.height - Y);
 
-				for (auto w = 1; w < sideLength; ++w)
-				{
-					columnSum += RGBAColor_32f(inputOutput(X + w, (Y + h)));
-				}
+		//R G B A of every block, 255 * 512 * 512 still fits a uint32 lane
+		std::vector<uint32_t> sums(static_cast<size_t>(blocks) * 4u, 0u);
+
+		for (auto h = 0u; h < rows; ++h)
+		{
+			const RGBAColor_8i* row = inputOutput.row(Y + h);
 
-				columnSum /= sideLength;
+			for (auto block = 0u; block < blocks; ++block)
+			{
+				const uint32_t X = block * sideLength;
+				__m128i* sum = reinterpret_cast<__m128i*>(sums.data() + block * 4u);
 
-				inputOutput(X, (Y + h)) = columnSum.toRGBAColor_8i();
+				_mm_storeu_si128(sum, SumPixels(row + X, Min(sideLength, inputOutput.width - X), _mm_loadu_si128(sum)));
 			}
 		}
 
-		//add row
-		for (auto X = 0u; X < inputOutput.width; X += sideLength)
-		{
-			RGBAColor_32f rowSum(inputOutput(X, Y));
+		//the blocks at the right and bottom edge average the pixels they have
+		RGBAColor_8i* first = inputOutput.row(Y);
 
-			for (auto h = 1u; h < sideLength; ++h)
-			{
-				rowSum += RGBAColor_32f(inputOutput(X, Y + h));
-			}
+		for (auto block = 0u; block < blocks; ++block)
+		{
+			const uint32_t X = block * sideLength;
+			const uint32_t columns = Min(sideLength, inputOutput.width - X);
+			const uint32_t count = columns * rows;
 
-			rowSum /= sideLength;
+			const uint32_t* sum = sums.data() + block * 4u;
 
-			inputOutput(X, Y) = rowSum.toRGBAColor_8i();
+			//rounded to nearest
+			const RGBAColor_8i average(
+				static_cast<uint8_t>((sum[0] + (count >> 1u)) / count),
+				static_cast<uint8_t>((sum[1] + (count >> 1u)) / count),
+				static_cast<uint8_t>((sum[2] + (count >> 1u)) / count),
+				static_cast<uint8_t>((sum[3] + (count >> 1u)) / count));
 
-			//set value to column
-			for (auto w = 1u; (w < sideLength) && ((X + w) < inputOutput.width); ++w)
-			{
-				inputOutput((X + w), Y) = inputOutput(X, Y);
-			}
+			FillPixels(first + X, columns, average);
 		}
 
-		//copy values
-		for (auto h = 1u; (h < sideLength) && ((Y + h) < inputOutput.height); ++h)
+		for (auto h = 1u; h < rows; ++h)
 		{
-			std::copy(&inputOutput(0u, Y), &inputOutput(0u, Y) + inputOutput.width,
-				&inputOutput(0u, Y) + h * inputOutput.width);
+			std::memcpy(inputOutput.row(Y + h), first, rowBytes);
 		}
 		});
 	return true;
@@ -726,10 +1497,7 @@ bool ImageProcessingTools::MixedPictures(TextureData& inputOutside, TextureData&
 	if (inputOutside.getRGBA_uint8().size() == 0u || inputInside.getRGBA_uint8().size() == 0u)
 		return false;
 
-	result.width = Min(inputOutside.width, inputInside.width);
-	result.height = Min(inputOutside.height, inputInside.height);
-
-	result.image.resize((static_cast<size_t>(result.width) * result.height) << 1u);//gray and alpha
+	result.resize(Min(inputOutside.width, inputInside.width), Min(inputOutside.height, inputInside.height), 2u);//gray and alpha
 
 	parallel::parallel_for(0u, result.height, [&inputOutside, &inputInside, &result, &filteringMethod](uint32_t Y) {
 		size_t offset = (static_cast<size_t>(Y) * result.width) << 1u;
@@ -753,12 +1521,7 @@ bool ImageProcessingTools::PixelToRGB3x3(TextureData& input, TextureData& result
 	if (input.getRGBA_uint8().size() == 0u)
 		return false;
 
-	input.clearImage();
-
-	result.width = input.width * 3u;
-	result.height = input.height * 3u;
-
-	result.getRGBA_uint8().resize(static_cast<size_t>(result.width) * result.height);
+	result.resize(input.width * 3u, input.height * 3u);
 
 	parallel::parallel_for(0u, input.height, [&input, &result, &brightness](uint32_t Y)
 		{
@@ -791,9 +1554,6 @@ bool ImageProcessingTools::Encryption_xor(TextureData& inputOutput, const uint32
 	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	inputOutput.clearImage();
-
 	//create random engine with key
 	std::default_random_engine engine(key);
 	uint32_t key_base = (inputOutput.width << 16) ^ (inputOutput.height << 8) ^ key;
@@ -833,8 +1593,13 @@ bool ImageProcessingTools::HSLAdjustment(TextureData& inputOutput, const float32
 	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
 		return false;
 
-	//not need this time
-	inputOutput.clearImage();
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &hueRatio, &saturationRatio, &lightnessRatio, kernels](uint32_t Y) {
+			kernels->HSLAdjustment(reinterpret_cast<uint32_t*>(inputOutput.row(Y)), inputOutput.width, hueRatio, saturationRatio, lightnessRatio);
+			});
+		return true;
+	}
 
 	parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &hueRatio, &saturationRatio, &lightnessRatio](uint32_t Y) {
 		for (auto X = 0u; X < inputOutput.width; ++X)
@@ -847,4 +1612,121 @@ bool ImageProcessingTools::HSLAdjustment(TextureData& inputOutput, const float32
 		}
 		});
 	return true;
+}
+bool ImageProcessingTools::PointOperationChain(TextureData& inputOutput, const std::vector<PointOperation>& chain)
+{
+	if (inputOutput.getRGBA_uint8().size() == 0)//Handle it well, otherwise there will be problems in parallel
+		return false;
+
+	//a run of per-channel steps (tone mapping, reverse) becomes one table, the others stay as they are
+	struct Stage
+	{
+		const PointOperation* operation = nullptr;
+		ChannelLut lut;
+	};
+
+	std::vector<Stage> stages;
+	bool lastIsLut = false;
+
+	for (const PointOperation& operation : chain)
+	{
+		const bool isLut = operation.kind == PointOperation::Kind::toneMapping || operation.kind == PointOperation::Kind::reverseColor;
+
+		if (!isLut)
+		{
+			stages.emplace_back();
+			stages.back().operation = &operation;
+			lastIsLut = false;
+			continue;
+		}
+
+		const ChannelLut lut = (operation.kind == PointOperation::Kind::toneMapping) ? ToneMappingLut(operation.param[0]) : ReverseColorLut();
+
+		if (lastIsLut)
+		{
+			stages.back().lut = stages.back().lut.Then(lut);
+		}
+		else
+		{
+			stages.emplace_back();
+			stages.back().lut = lut;
+		}
+		lastIsLut = true;
+	}
+
+	if (const PixelKernelTable* kernels = ImageProcessingTools::WidePixelKernels())
+	{
+		//the row stays in L1 while every step runs over it
+		parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &stages, kernels](uint32_t Y) {
+			uint32_t* pixels = reinterpret_cast<uint32_t*>(inputOutput.row(Y));
+
+			for (const Stage& stage : stages)
+			{
+				if (stage.operation == nullptr)
+				{
+					kernels->ApplyLut(pixels, inputOutput.width, stage.lut.table);
+					continue;
+				}
+
+				const PointOperation& operation = *stage.operation;
+
+				switch (operation.kind)
+				{
+				case PointOperation::Kind::vividness:
+					kernels->Vividness(pixels, inputOutput.width, operation.param[0]);
+					break;
+				case PointOperation::Kind::natualVividness:
+					kernels->NatualVividness(pixels, inputOutput.width, operation.param[0]);
+					break;
+				case PointOperation::Kind::hslAdjustment:
+					kernels->HSLAdjustment(pixels, inputOutput.width, operation.param[0], operation.param[1], operation.param[2]);
+					break;
+				default:
+					break;
+				}
+			}
+			});
+		return true;
+	}
+
+	parallel::parallel_for(0u, inputOutput.height, [&inputOutput, &stages](uint32_t Y) {
+		RGBAColor_8i* row = inputOutput.row(Y);
+
+		for (auto X = 0u; X < inputOutput.width; ++X)
+		{
+			RGBAColor_8i pixel = row[X];
+
+			for (const Stage& stage : stages)
+			{
+				if (stage.operation == nullptr)
+				{
+					pixel = stage.lut.Lookup(pixel);
+					continue;
+				}
+
+				const PointOperation& operation = *stage.operation;
+				RGBAColor_32f color(pixel);
+
+				switch (operation.kind)
+				{
+				case PointOperation::Kind::vividness:
+					ImageProcessingTools::VividnessAdjustmentColor(color, operation.param[0]);
+					break;
+				case PointOperation::Kind::natualVividness:
+					ImageProcessingTools::NatualVividnessAdjustmentColor(color, operation.param[0]);
+					break;
+				case PointOperation::Kind::hslAdjustment:
+					ImageProcessingTools::HSLAdjustmentColor(color, operation.param[0], operation.param[1], operation.param[2]);
+					break;
+				default:
+					break;
+				}
+
+				pixel = color.toRGBAColor_8i();
+			}
+
+			row[X] = pixel;
+		}
+		});
+	return true;
 }
\ No newline at end of file
@@ -12,8 +12,12 @@
 #include <thread>
 #include <array>
 #include <random>
+#include <new>
+#include <cstring>
 #include "basedef.h"
 #include "CppParallelAccelerator.h"
+#include "CpuFeatures.h"
+#include "ImageSimd.h"
 
 /*
 * Processors in different working modes need to be treated differently
@@ -122,31 +126,121 @@ struct alignas(4) RGBAColor_8i
 	RGBAColor_8i& operator~();
 };
 
+/*
+* 64-byte aligned byte storage, owns the pixels of a TextureData
+*/
+class PixelBuffer
+{
+public:
+	static constexpr size_t alignment = 64u;
+
+	PixelBuffer() = default;
+	PixelBuffer(const PixelBuffer& other);
+	PixelBuffer(PixelBuffer&& other) noexcept;
+	PixelBuffer& operator=(const PixelBuffer& other);
+	PixelBuffer& operator=(PixelBuffer&& other) noexcept;
+	~PixelBuffer();
+
+	byte* data();
+	const byte* data() const;
+	size_t size() const;
+	bool empty() const;
+
+	byte* begin();
+	byte* end();
+
+	//keeps the old content like std::vector, new bytes are left uninitialized
+	void resize(const size_t& newSize);
+	void clear();
+
+	byte& operator[](const size_t& index);
+	const byte& operator[](const size_t& index) const;
+
+protected:
+	byte* buffer = nullptr;
+	size_t length = 0u;
+	size_t capacity = 0u;
+};
+
+/*
+* Typed window over a PixelBuffer, no copy is made
+*/
+template<typename T>
+class PixelView
+{
+public:
+	PixelView(T* ptr, const size_t& count);
+
+	T* data() const;
+	size_t size() const;
+
+	T* begin() const;
+	T* end() const;
+
+	T& operator[](const size_t& index) const;
+
+protected:
+	T* ptr = nullptr;
+	size_t count = 0u;
+};
+
+/*
+* Border policies for fetches outside the image, picked at compile time.
+* Resolve maps index into [0, size), false means use the constant color.
+*/
+struct BorderClamp
+{
+	static bool Resolve(int64_t& index, const int64_t& size);
+};
+
+//reflect without repeating the edge pixel: -1 -> 1, size -> size - 2
+struct BorderMirror
+{
+	static bool Resolve(int64_t& index, const int64_t& size);
+};
+
+struct BorderWrap
+{
+	static bool Resolve(int64_t& index, const int64_t& size);
+};
+
+struct BorderConstant
+{
+	static bool Resolve(int64_t& index, const int64_t& size);
+};
+
 struct TextureData
 {
 public:
 	TextureData() = default;
 	TextureData(std::vector<RGBAColor_8i>& image_in, const uint32_t& width, const uint32_t& height);
 
-	std::vector<RGBAColor_8i>& getRGBA_uint8();
+	//zero-copy views, the RGBA bytes and RGBAColor_8i share the same layout
+	PixelView<RGBAColor_8i> getRGBA_uint8();
+	PixelView<byte> getBytes();
+
+	//allocate width * height pixels of channels bytes each
+	void resize(const uint32_t& width, const uint32_t& height, const uint32_t& channels = 4u);
 
+	//clamped access, safe for any column and row
 	RGBAColor_8i& operator()(int64_t column, int64_t row);
 
+	//unchecked access, the caller keeps column and row inside the image
+	RGBAColor_8i* row(const int64_t& row);
+	RGBAColor_8i& at(const int64_t& column, const int64_t& row);
+
+	template<typename Border = BorderClamp>
+	RGBAColor_8i sample(int64_t column, int64_t row, const RGBAColor_8i& constant = RGBAColor_8i(0u, 0u, 0u, 0u));
+
 	byte& operator[](const size_t& index);
 
-	void loadRGBAtoByteStream();
-	void clearImage();
-	void clearRGBA_uint8();
 	void clear();
 
 public:
 	uint32_t width = 0u;
 	uint32_t height = 0u;
 
-	std::vector<byte> image;
-
-protected:
-	std::vector<RGBAColor_8i> imageRGBA_uint8;
+	PixelBuffer image;
 };
 
 struct alignas(16) RGBAColor_32f
@@ -224,6 +318,99 @@ public:
 using floatVec4 = RGBAColor_32f;
 using HSLAColor_32f = RGBAColor_32f;
 
+/*
+* The source taps of one axis of a separable resize, built once per call.
+* Tap k of output i reads index[i * taps + k], already clamped into the source, with weight[i * taps + k].
+*/
+struct ResampleAxis
+{
+public:
+	void resize(const uint32_t& length, const uint32_t& taps);
+
+	int32_t* indexAt(const uint32_t& i);
+	float32_t* weightAt(const uint32_t& i);
+	const int32_t* indexAt(const uint32_t& i) const;
+	const float32_t* weightAt(const uint32_t& i) const;
+
+public:
+	uint32_t length = 0u;
+	uint32_t taps = 0u;
+
+	std::vector<int32_t> index;
+	std::vector<float32_t> weight;
+};
+
+/*
+* One step of a fused point-wise chain, param holds the arguments of the matching single-image function in order.
+* Each step still rounds back to 8 bits, so a chain gives the same bytes as running the steps one by one.
+*/
+struct PointOperation
+{
+	enum class Kind :uint8_t
+	{
+		toneMapping,
+		vividness,
+		natualVividness,
+		hslAdjustment,
+		reverseColor
+	};
+
+	Kind kind = Kind::reverseColor;
+	float32_t param[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+/*
+* A per-channel function of 8-bit values baked into one 256-entry table per channel, R G B A like RGBAColor_8i.
+* Tables compose, so a run of such steps in a chain costs one lookup per channel.
+*/
+struct ChannelLut
+{
+	static constexpr size_t entries = 256u;
+
+	//the wide kernels gather 32 bits at a byte offset, the padding keeps the read of the last entry inside
+	alignas(64) byte table[4u * entries + 4u] = {};
+
+	//function maps RGBAColor_8i to RGBAColor_8i and must treat every channel on its own, it is run on the 256 gray pixels
+	template<typename Function>
+	static ChannelLut Bake(const Function& function);
+
+	//this table, then next
+	ChannelLut Then(const ChannelLut& next) const;
+	RGBAColor_8i Lookup(const RGBAColor_8i& color) const;
+};
+
+/*
+* A color transform sampled on size^3 points of the RGB cube, red fastest like the .cube format.
+* A color is interpolated inside the tetrahedron of its cell that the order of its fractions picks,
+* the result is rounded to nearest so an identity cube gives the input back. Alpha never reaches R G B, a table of its own maps it.
+*/
+struct ColorCube
+{
+	static constexpr uint32_t minSize = 2u;
+	static constexpr uint32_t maxSize = 256u;
+
+	uint32_t size = 0u;
+	//R G B of every point from 0 to 255, A is unused
+	std::vector<RGBAColor_32f> lattice;
+	//lattice position of an 8-bit channel: value * scale + bias, clamped to [0, size - 1]
+	float32_t scale[3] = { 0.0f, 0.0f, 0.0f };
+	float32_t bias[3] = { 0.0f, 0.0f, 0.0f };
+	//the wide kernels gather 32 bits at a byte offset, the padding keeps the read of the last entry inside
+	alignas(64) byte alpha[256u + 4u] = {};
+
+	//size points per axis over the domain 0 to 1, an identity alpha, the lattice is left black
+	void resize(const uint32_t& size);
+	//the input range the lattice spans on each channel, 0 to 1 by default
+	void setDomain(const float32_t domainMin[3], const float32_t domainMax[3]);
+	RGBAColor_32f& at(const uint32_t& R, const uint32_t& G, const uint32_t& B);
+
+	//function maps RGBAColor_32f to RGBAColor_32f from 0 to 1 and must keep alpha out of R G B
+	template<typename Function>
+	static ColorCube Bake(const uint32_t& size, const Function& function);
+
+	RGBAColor_8i Lookup(const RGBAColor_8i& color) const;
+};
+
 class ImageProcessingTools
 {
 public:
@@ -234,6 +421,12 @@ public:
 		quartet = 3
 	};
 
+	enum class MinifyFilter :uint8_t
+	{
+		area = 0,
+		lanczos3 = 1
+	};
+
 protected:
 	template<typename T>
 	static void FastGray(const RGBAColor_8i& color, T& result);//0 to 255
@@ -253,9 +446,25 @@ protected:
 
 	static void MixedPicturesColor(const byte& colorOut, const byte& colorIn, byte& colorResult, byte& alphaResult);
 
+	//AVX-512 or AVX2 row kernels picked once by CPUID, nullptr keeps the SSE2 per-pixel code
+	static const PixelKernelTable* WidePixelKernels();
+
+	static ChannelLut ToneMappingLut(const float32_t& lumRatio);
+	static ChannelLut ReverseColorLut();
+	static void ChannelLutRow(RGBAColor_8i* row, const size_t& count, const ChannelLut& lut);
+	static void ColorCubeRow(RGBAColor_8i* row, const size_t& count, const ColorCube& cube);
+
 protected:
 	static float32_t bicubicConvolutionZoomFormula(const float32_t& a, const float32_t& x);
 
+	static void BicubicResampleAxis(ResampleAxis& axis, const uint32_t& srcSize, const uint32_t& dstSize, const float32_t& scaleIndex, const float32_t& a);
+	//bias is added before the truncating conversion, 0.5f / 255 rounds to nearest
+	static void SeparableResample(TextureData& input, TextureData& result, const ResampleAxis& axisX, const ResampleAxis& axisY, const float32_t& bias = 0.0f);
+
+	static float32_t lanczos3Formula(const float32_t& x);
+	static void MinifyResampleAxis(ResampleAxis& axis, const uint32_t& srcSize, const uint32_t& dstSize, const MinifyFilter& filter);
+	static void BoxReduce(TextureData& input, TextureData& result, const uint32_t& factor);
+
 	static float32_t weightEffectSquare(const float32_t& dx);
 	static float32_t weightEffectQuartet(const float32_t& dx);
 
@@ -269,6 +478,7 @@ public:
 		const Exponent& exponent = Exponent::one);
 
 	static bool Zoom_BicubicConvolutionSampling4x4(TextureData& input, TextureData& result, const float32_t& magnification = 1.0f, const float32_t& a = -0.5f);
+	static bool Zoom_Minification(TextureData& input, TextureData& result, const float32_t& magnification = 0.5f, const MinifyFilter& filter = MinifyFilter::lanczos3);
 
 	static bool SharpenLaplace3x3(TextureData& input, TextureData& result, const float32_t& strength = 1.0f);
 	static bool SharpenGaussLaplace5x5(TextureData& input, TextureData& result, const float32_t& strength = 1.0f);
@@ -291,6 +501,12 @@ public:
 	static bool PixelToRGB3x3(TextureData& input, TextureData& result, const float32_t& brightness = 0.0f);
 	static bool Encryption_xor(TextureData& inputOutput, const uint32_t& key = 0b1110'1101'1011'1001'0101'1010'0010'0100);
 	static bool HSLAdjustment(TextureData& inputOutput, const float32_t& hueChange = 0.0f, const float32_t& saturationRatio = 1.0f, const float32_t& lightnessRatio = 1.0f);
+	//every pixel is read and written once for the whole chain
+	static bool PointOperationChain(TextureData& inputOutput, const std::vector<PointOperation>& chain);
+	static bool ChannelLutTransform(TextureData& inputOutput, const ChannelLut& lut);
+	static bool ColorCubeTransform(TextureData& inputOutput, const ColorCube& cube);
+	//the steps run in float without the 8-bit rounding between them, only clamped to 0 to 1
+	static ColorCube PointOperationCube(const std::vector<PointOperation>& chain, const uint32_t& size = 33u);
 };
 
 inline RGBAColor_8i::RGBAColor_8i(byte* ptr)
@@ -546,39 +762,187 @@ inline void RGBAColor_32f::FMA(const RGBAColor_32f& mul1, const RGBAColor_32f& m
 	result.float32X4 = _mm_fma_ps(mul1.float32X4, mul2.float32X4, add.float32X4);
 }
 
-inline TextureData::TextureData(std::vector<RGBAColor_8i>& image_in, const uint32_t& width, const uint32_t& height)
+inline PixelBuffer::PixelBuffer(const PixelBuffer& other)
 {
-	this->width = width;
-	this->height = height;
+	*this = other;
+}
 
-	this->image.reserve((static_cast<size_t>(width) * height) << 2);
+inline PixelBuffer::PixelBuffer(PixelBuffer&& other) noexcept
+{
+	*this = std::move(other);
+}
 
-	for (const auto& rgba : image_in)
+inline PixelBuffer& PixelBuffer::operator=(const PixelBuffer& other)
+{
+	if (this != &other)
 	{
-		this->image.push_back(rgba.R);
-		this->image.push_back(rgba.G);
-		this->image.push_back(rgba.B);
-		this->image.push_back(rgba.A);
+		this->resize(other.length);
+
+		if (other.length != 0u)
+			std::memcpy(this->buffer, other.buffer, other.length);
 	}
+	return *this;
 }
 
-inline std::vector<RGBAColor_8i>& TextureData::getRGBA_uint8()
+inline PixelBuffer& PixelBuffer::operator=(PixelBuffer&& other) noexcept
 {
-	if (this->imageRGBA_uint8.size() == 0u)
+	if (this != &other)
 	{
-		if (this->image.size() != 0u)
-		{
-			this->imageRGBA_uint8.reserve(this->image.size() >> 2);
+		this->clear();
 
-			for (size_t index = 0u; index < this->image.size(); index += 4)
-			{
-				this->imageRGBA_uint8.push_back(
-					RGBAColor_8i{ this->image.data() + index }
-				);
-			}
-		}
+		std::swap(this->buffer, other.buffer);
+		std::swap(this->length, other.length);
+		std::swap(this->capacity, other.capacity);
 	}
-	return this->imageRGBA_uint8;
+	return *this;
+}
+
+inline PixelBuffer::~PixelBuffer()
+{
+	clear();
+}
+
+inline byte* PixelBuffer::data()
+{
+	return this->buffer;
+}
+
+inline const byte* PixelBuffer::data() const
+{
+	return this->buffer;
+}
+
+inline size_t PixelBuffer::size() const
+{
+	return this->length;
+}
+
+inline bool PixelBuffer::empty() const
+{
+	return this->length == 0u;
+}
+
+inline byte* PixelBuffer::begin()
+{
+	return this->buffer;
+}
+
+inline byte* PixelBuffer::end()
+{
+	return this->buffer + this->length;
+}
+
+inline void PixelBuffer::resize(const size_t& newSize)
+{
+	if (newSize > this->capacity)
+	{
+		byte* newBuffer = static_cast<byte*>(operator new(newSize, std::align_val_t(alignment)));
+
+		if (this->length != 0u)
+			std::memcpy(newBuffer, this->buffer, this->length);
+
+		if (this->buffer != nullptr)
+			operator delete(this->buffer, std::align_val_t(alignment));
+
+		this->buffer = newBuffer;
+		this->capacity = newSize;
+	}
+	this->length = newSize;
+}
+
+inline void PixelBuffer::clear()
+{
+	if (this->buffer != nullptr)
+		operator delete(this->buffer, std::align_val_t(alignment));
+
+	this->buffer = nullptr;
+	this->length = 0u;
+	this->capacity = 0u;
+}
+
+inline byte& PixelBuffer::operator[](const size_t& index)
+{
+	assert(index < this->length && "index out of range.");
+
+	return this->buffer[index];
+}
+
+inline const byte& PixelBuffer::operator[](const size_t& index) const
+{
+	assert(index < this->length && "index out of range.");
+
+	return this->buffer[index];
+}
+
+template<typename T>
+inline PixelView<T>::PixelView(T* ptr, const size_t& count)
+{
+	this->ptr = ptr;
+	this->count = count;
+}
+
+template<typename T>
+inline T* PixelView<T>::data() const
+{
+	return this->ptr;
+}
+
+template<typename T>
+inline size_t PixelView<T>::size() const
+{
+	return this->count;
+}
+
+template<typename T>
+inline T* PixelView<T>::begin() const
+{
+	return this->ptr;
+}
+
+template<typename T>
+inline T* PixelView<T>::end() const
+{
+	return this->ptr + this->count;
+}
+
+template<typename T>
+inline T& PixelView<T>::operator[](const size_t& index) const
+{
+	assert(index < this->count && "index out of range.");
+
+	return this->ptr[index];
+}
+
+inline TextureData::TextureData(std::vector<RGBAColor_8i>& image_in, const uint32_t& width, const uint32_t& height)
+{
+	this->width = width;
+	this->height = height;
+
+	//RGBAColor_8i keeps its channels in R,G,B,A byte order
+	this->image.resize(image_in.size() * sizeof(RGBAColor_8i));
+
+	if (!image_in.empty())
+		std::memcpy(this->image.data(), image_in.data(), this->image.size());
+}
+
+inline PixelView<RGBAColor_8i> TextureData::getRGBA_uint8()
+{
+	static_assert(sizeof(RGBAColor_8i) == 4u, "RGBAColor_8i must be tightly packed.");
+
+	return PixelView<RGBAColor_8i>(reinterpret_cast<RGBAColor_8i*>(this->image.data()), this->image.size() >> 2);
+}
+
+inline PixelView<byte> TextureData::getBytes()
+{
+	return PixelView<byte>(this->image.data(), this->image.size());
+}
+
+inline void TextureData::resize(const uint32_t& width, const uint32_t& height, const uint32_t& channels)
+{
+	this->width = width;
+	this->height = height;
+
+	this->image.resize(static_cast<size_t>(width) * height * channels);
 }
 
 inline RGBAColor_8i& TextureData::operator()(int64_t column, int64_t row)
@@ -591,57 +955,81 @@ inline RGBAColor_8i& TextureData::operator()(int64_t column, int64_t row)
 	Clamp(column, 0, width - 1);
 	Clamp(row, 0, height - 1);
 
-	return this->getRGBA_uint8()[size_t(row) * width + column];
+	return this->row(row)[column];
 }
 
-inline byte& TextureData::operator[](const size_t& index)
+inline RGBAColor_8i* TextureData::row(const int64_t& row)
 {
-	assert(this->image.size() >= index && "index out of range.");
+	assert(row >= 0 && row < this->height && "row out of image range.");
 
-	return this->image[index];
+	return reinterpret_cast<RGBAColor_8i*>(this->image.data()) + static_cast<size_t>(row) * this->width;
 }
 
-inline void TextureData::loadRGBAtoByteStream()
+inline RGBAColor_8i& TextureData::at(const int64_t& column, const int64_t& row)
 {
-	this->image.clear();
-	/*this->image.reserve(this->imageRGBA_uint8.size() << 2);*/
-
-	// Acceleration is worthless here
-	//for (const auto& rgba : this->imageRGBA_uint8)
-	//{
-	//	this->image.push_back(rgba.R);
-	//	this->image.push_back(rgba.G);
-	//	this->image.push_back(rgba.B);
-	//	this->image.push_back(rgba.A);
-	//}
-
-	this->image.resize(this->imageRGBA_uint8.size() << 2);
-	// Acceleration is worthless here
-	for (size_t index = 0u; index < this->imageRGBA_uint8.size(); ++index)
+	assert(column >= 0 && column < this->width && "column out of image range.");
+
+	return this->row(row)[column];
+}
+
+template<typename Border>
+inline RGBAColor_8i TextureData::sample(int64_t column, int64_t row, const RGBAColor_8i& constant)
+{
+	if (!Border::Resolve(column, this->width) || !Border::Resolve(row, this->height))
+		return constant;
+
+	return this->row(row)[column];
+}
+
+inline bool BorderClamp::Resolve(int64_t& index, const int64_t& size)
+{
+	index = (index < 0) ? 0 : ((index >= size) ? size - 1 : index);
+
+	return true;
+}
+
+inline bool BorderMirror::Resolve(int64_t& index, const int64_t& size)
+{
+	if (size == 1)
 	{
-		image[(index << 2) + 0] = this->imageRGBA_uint8[index].R;
-		image[(index << 2) + 1] = this->imageRGBA_uint8[index].G;
-		image[(index << 2) + 2] = this->imageRGBA_uint8[index].B;
-		image[(index << 2) + 3] = this->imageRGBA_uint8[index].A;
+		index = 0;
+		return true;
 	}
+
+	//the reflection repeats every 2 * (size - 1) and is symmetric around 0
+	const int64_t period = 2 * (size - 1);
+
+	index = ((index < 0) ? -index : index) % period;
+
+	if (index >= size)
+		index = period - index;
+
+	return true;
 }
 
-inline void TextureData::clearImage()
+inline bool BorderWrap::Resolve(int64_t& index, const int64_t& size)
 {
-	this->image.clear();
-	std::vector<byte>().swap(this->image);
+	index %= size;
+
+	if (index < 0)
+		index += size;
+
+	return true;
 }
 
-inline void TextureData::clearRGBA_uint8()
+inline bool BorderConstant::Resolve(int64_t& index, const int64_t& size)
 {
-	this->imageRGBA_uint8.clear();
-	std::vector<RGBAColor_8i>().swap(this->imageRGBA_uint8);
+	return (index >= 0) && (index < size);
+}
+
+inline byte& TextureData::operator[](const size_t& index)
+{
+	return this->image[index];
 }
 
 inline void TextureData::clear()
 {
-	clearImage();
-	clearRGBA_uint8();
+	this->image.clear();
 }
 
 template<typename T>
@@ -797,6 +1185,203 @@ inline void ImageProcessingTools::HSLAdjustmentColor(RGBAColor_32f& color, const
 	hslColor.HSLtoRGB(color);
 }
 
+inline void ResampleAxis::resize(const uint32_t& length, const uint32_t& taps)
+{
+	this->length = length;
+	this->taps = taps;
+
+	this->index.resize(static_cast<size_t>(length) * taps);
+	this->weight.resize(static_cast<size_t>(length) * taps);
+}
+
+inline int32_t* ResampleAxis::indexAt(const uint32_t& i)
+{
+	return this->index.data() + static_cast<size_t>(i) * this->taps;
+}
+
+inline float32_t* ResampleAxis::weightAt(const uint32_t& i)
+{
+	return this->weight.data() + static_cast<size_t>(i) * this->taps;
+}
+
+inline const int32_t* ResampleAxis::indexAt(const uint32_t& i) const
+{
+	return this->index.data() + static_cast<size_t>(i) * this->taps;
+}
+
+inline const float32_t* ResampleAxis::weightAt(const uint32_t& i) const
+{
+	return this->weight.data() + static_cast<size_t>(i) * this->taps;
+}
+
+template<typename Function>
+inline ChannelLut ChannelLut::Bake(const Function& function)
+{
+	ChannelLut lut;
+
+	for (size_t i = 0u; i < entries; ++i)
+	{
+		const uint8_t value = static_cast<uint8_t>(i);
+		const RGBAColor_8i result = function(RGBAColor_8i(value, value, value, value));
+
+		lut.table[i] = result.R;
+		lut.table[entries + i] = result.G;
+		lut.table[2u * entries + i] = result.B;
+		lut.table[3u * entries + i] = result.A;
+	}
+	return lut;
+}
+
+inline ChannelLut ChannelLut::Then(const ChannelLut& next) const
+{
+	ChannelLut lut;
+
+	for (size_t channel = 0u; channel < 4u; ++channel)
+	{
+		const size_t base = channel * entries;
+
+		for (size_t i = 0u; i < entries; ++i)
+		{
+			lut.table[base + i] = next.table[base + this->table[base + i]];
+		}
+	}
+	return lut;
+}
+
+inline RGBAColor_8i ChannelLut::Lookup(const RGBAColor_8i& color) const
+{
+	return RGBAColor_8i(this->table[color.R], this->table[entries + color.G], this->table[2u * entries + color.B], this->table[3u * entries + color.A]);
+}
+
+inline void ColorCube::resize(const uint32_t& size)
+{
+	assert(minSize <= size && size <= maxSize && "wrong! color cube size out of range.");
+
+	this->size = size;
+	this->lattice.assign(static_cast<size_t>(size) * size * size, RGBAColor_32f(0.0f));
+
+	const float32_t domainMin[3] = { 0.0f, 0.0f, 0.0f };
+	const float32_t domainMax[3] = { 1.0f, 1.0f, 1.0f };
+	setDomain(domainMin, domainMax);
+
+	for (size_t i = 0u; i < 256u; ++i)
+	{
+		this->alpha[i] = static_cast<byte>(i);
+	}
+}
+
+inline void ColorCube::setDomain(const float32_t domainMin[3], const float32_t domainMax[3])
+{
+	for (size_t channel = 0u; channel < 3u; ++channel)
+	{
+		//(value / 255 - min) / (max - min) * (size - 1)
+		const float64_t steps = static_cast<float64_t>(this->size - 1u) / (static_cast<float64_t>(domainMax[channel]) - domainMin[channel]);
+
+		this->scale[channel] = static_cast<float32_t>(steps / maxColorPix);
+		this->bias[channel] = static_cast<float32_t>(-domainMin[channel] * steps);
+	}
+}
+
+inline RGBAColor_32f& ColorCube::at(const uint32_t& R, const uint32_t& G, const uint32_t& B)
+{
+	return this->lattice[(static_cast<size_t>(B) * this->size + G) * this->size + R];
+}
+
+template<typename Function>
+inline ColorCube ColorCube::Bake(const uint32_t& size, const Function& function)
+{
+	ColorCube cube;
+	cube.resize(size);
+
+	const float32_t step = 1.0f / static_cast<float32_t>(size - 1u);
+
+	for (uint32_t B = 0u; B < size; ++B)
+	{
+		for (uint32_t G = 0u; G < size; ++G)
+		{
+			for (uint32_t R = 0u; R < size; ++R)
+			{
+				RGBAColor_32f color = function(RGBAColor_32f(R * step, G * step, B * step, 1.0f));
+				color.A = 0.0f;
+
+				cube.at(R, G, B) = color * maxColorPix;
+			}
+		}
+	}
+
+	//alpha only depends on alpha, the gray pixels cover it
+	for (size_t i = 0u; i < 256u; ++i)
+	{
+		const uint8_t value = static_cast<uint8_t>(i);
+		cube.alpha[i] = function(RGBAColor_32f(RGBAColor_8i(value, value, value, value))).toRGBAColor_8i().A;
+	}
+	return cube;
+}
+
+inline RGBAColor_8i ColorCube::Lookup(const RGBAColor_8i& color) const
+{
+	const uint8_t channels[3] = { color.R, color.G, color.B };
+	const size_t strides[3] = { 1u, this->size, static_cast<size_t>(this->size) * this->size };
+	const float32_t top = static_cast<float32_t>(this->size - 1u);
+	const float32_t lastCell = static_cast<float32_t>(this->size - 2u);
+
+	size_t base = 0u;
+	float32_t fraction[3];
+
+	for (size_t channel = 0u; channel < 3u; ++channel)
+	{
+		float32_t position = static_cast<float32_t>(channels[channel]) * this->scale[channel] + this->bias[channel];
+		Clamp(position, 0.0f, top);
+
+		//the last point belongs to the last cell with a fraction of 1
+		const float32_t cell = Min(static_cast<float32_t>(static_cast<int32_t>(position)), lastCell);
+
+		fraction[channel] = position - cell;
+		base += static_cast<size_t>(cell) * strides[channel];
+	}
+
+	//ties go to R, then G, so the largest and the smallest fraction are never the same channel
+	const bool RG = fraction[0] >= fraction[1];
+	const bool GB = fraction[1] >= fraction[2];
+	const bool RB = fraction[0] >= fraction[2];
+
+	const size_t first = (RG && RB) ? strides[0] : (GB ? strides[1] : strides[2]);
+	const size_t last = (RB && GB) ? strides[2] : (RG ? strides[1] : strides[0]);
+	const size_t corner = strides[0] + strides[1] + strides[2];
+
+	const float32_t high = Max(fraction[0], fraction[1], fraction[2]);
+	const float32_t low = Min(fraction[0], fraction[1], fraction[2]);
+	const float32_t middle = Max(Min(fraction[0], fraction[1]), Min(Max(fraction[0], fraction[1]), fraction[2]));
+
+	const RGBAColor_32f result = this->lattice[base] * (1.0f - high) + this->lattice[base + first] * (high - middle)
+		+ this->lattice[base + corner - last] * (middle - low) + this->lattice[base + corner] * low;
+
+	float32_t R = result.R + 0.5f, G = result.G + 0.5f, B = result.B + 0.5f;
+	Clamp(R, 0.0f, maxColorPix);
+	Clamp(G, 0.0f, maxColorPix);
+	Clamp(B, 0.0f, maxColorPix);
+
+	return RGBAColor_8i(static_cast<uint8_t>(R), static_cast<uint8_t>(G), static_cast<uint8_t>(B), this->alpha[color.A]);
+}
+
+inline const PixelKernelTable* ImageProcessingTools::WidePixelKernels()
+{
+	static const PixelKernelTable* const kernels = []() -> const PixelKernelTable* {
+		const CpuFeatures& cpu = CpuFeatures::Get();
+
+		//the AVX-512 unit is built with /arch:AVX512, which lets the compiler use CD, BW, DQ and VL as well as F
+		if (cpu.avx512f && cpu.avx512cd && cpu.avx512bw && cpu.avx512dq && cpu.avx512vl)
+			return &PixelKernelsAVX512();
+
+		if (cpu.avx2 && cpu.fma)
+			return &PixelKernelsAVX2();
+
+		return nullptr;
+		}();
+
+	return kernels;
+}
+
 inline void ImageProcessingTools::MixedPicturesColor(const byte& colorOut, const byte& colorIn, byte& colorResult, byte& alphaResult)
 {
 	alphaResult = ~colorOut + colorIn;
@@ -887,6 +1472,22 @@ inline float32_t ImageProcessingTools::bicubicConvolutionZoomFormula(const float
 		}
 }
 
+inline float32_t ImageProcessingTools::lanczos3Formula(const float32_t& x)
+{
+	// sinc(x) * sinc(x / 3) for |x| < 3
+	float32_t absX = fabsf(x);
+
+	if (absX < 1e-6f)
+		return 1.0f;
+
+	if (absX >= 3.0f)
+		return 0.0f;
+
+	float32_t piX = pi * absX;
+
+	return 3.0f * std::sin(piX) * std::sin(piX * (1.0f / 3.0f)) / (piX * piX);
+}
+
 //Inverse square
 inline float32_t ImageProcessingTools::weightEffectSquare(const float32_t& dx)
 {
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef IMAGESIMD
+#define IMAGESIMD
+
+#include <cstdint>
+#include <cstddef>
+#include "basedef.h"
+
+/*
+* Wide per-pixel kernels working on RGBA8 rows, one register holds one channel of 8 (AVX2) or 16 (AVX-512) pixels.
+* The ISA translation units include nothing but this header and intrinsics,
+* so no shared inline function gets compiled with AVX enabled and picked by the linker for the SSE2 path.
+*/
+//one tap of a sharpen kernel, the taps of a group share one weight and are listed next to each other
+struct SharpenTap
+{
+	int32_t dx, dy, group;
+};
+
+struct PixelKernelTable
+{
+	//tables holds 256 bytes for each of R G B A and 4 bytes of padding, see ChannelLut
+	void (*ApplyLut)(uint32_t* pixels, size_t count, const byte* tables);
+	void (*Vividness)(uint32_t* pixels, size_t count, float32_t vividRatio);
+	void (*NatualVividness)(uint32_t* pixels, size_t count, float32_t vividRatio);
+	void (*HSLAdjustment)(uint32_t* pixels, size_t count, float32_t hueChange, float32_t saturationRatio, float32_t lightnessRatio);
+	//linear holds 256 floats for each of R G B, coarse the gray level at the top 16 bits of the sum, thresholds the smallest sum of every level
+	void (*Grayscale)(const uint32_t* pixels, byte* result, size_t count, const float32_t* linear, const byte* coarse, const float32_t* thresholds);
+	void (*Binarization)(const uint32_t* pixels, byte* result, size_t count, float32_t threshold);
+	//lattice holds A B G R floats of size^3 points, alpha 256 bytes and 4 bytes of padding, see ColorCube
+	void (*ApplyCube)(uint32_t* pixels, size_t count, const float32_t* lattice, uint32_t size, const float32_t* scale, const float32_t* bias, const byte* alpha);
+	//interior pixels x to x + count of a row, center[dy] is the row dy away; weights are the 16-bit weights of groups 0 to 3 scaled by 1 << shift.
+	//returns how many pixels it wrote from x on, the rest is left to the caller
+	size_t (*Sharpen)(const uint32_t* const* center, ptrdiff_t x, size_t count, const SharpenTap* taps, size_t tapCount, const int16_t* weights, int32_t shift, uint32_t* result);
+};
+
+//defined in ImageSimd_AVX2.cpp and ImageSimd_AVX512.cpp
+const PixelKernelTable& PixelKernelsAVX2();
+const PixelKernelTable& PixelKernelsAVX512();
+
+#endif // !IMAGESIMD
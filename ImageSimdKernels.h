@@ -0,0 +1,438 @@
+#pragma once
+/*
+* Shared body of the wide pixel kernels, included once by each ISA translation unit.
+* The includer defines struct Simd (register types, width and the operations below) inside an anonymous namespace first,
+* every kernel follows the scalar order of Image.h so results stay within rounding of the SSE2 path.
+*/
+#include <cstring>
+#include "ImageSimd.h"
+
+namespace
+{
+	using F = Simd::F;
+	using I = Simd::I;
+	using M = Simd::M;
+
+	constexpr size_t width = Simd::width;
+	constexpr float32_t maxColorPix = 255.0f;
+	constexpr float32_t ColorPixTofloat = (1.0f / maxColorPix);
+	constexpr float32_t radToDeg = 180.0f / 3.1415926f;
+
+	struct PixelsSoA
+	{
+		F R, G, B, A;
+	};
+
+	inline PixelsSoA Unpack(const I& pixels)
+	{
+		const I mask = Simd::Set1i(0xFF);
+		const F scale = Simd::Set1(ColorPixTofloat);
+
+		PixelsSoA result;
+		result.R = Simd::Mul(Simd::ToFloat(Simd::And(pixels, mask)), scale);
+		result.G = Simd::Mul(Simd::ToFloat(Simd::And(Simd::ShiftRight<8>(pixels), mask)), scale);
+		result.B = Simd::Mul(Simd::ToFloat(Simd::And(Simd::ShiftRight<16>(pixels), mask)), scale);
+		result.A = Simd::Mul(Simd::ToFloat(Simd::ShiftRight<24>(pixels)), scale);
+		return result;
+	}
+
+	//same as RGBAColor_32f::toRGBAColor_8i, scale, clamp and truncate
+	inline I ToChannel(const F& value)
+	{
+		const F scaled = Simd::Mul(value, Simd::Set1(maxColorPix));
+		return Simd::ToInt(Simd::Min(Simd::Max(scaled, Simd::Set1(0.0f)), Simd::Set1(maxColorPix)));
+	}
+
+	inline I Pack(const PixelsSoA& color)
+	{
+		I result = ToChannel(color.R);
+		result = Simd::Or(result, Simd::ShiftLeft<8>(ToChannel(color.G)));
+		result = Simd::Or(result, Simd::ShiftLeft<16>(ToChannel(color.B)));
+		result = Simd::Or(result, Simd::ShiftLeft<24>(ToChannel(color.A)));
+		return result;
+	}
+
+	//round half away from zero like std::roundf
+	inline F Round(const F& x)
+	{
+		const F t = Simd::Trunc(x);
+		const F d = Simd::Sub(x, t);
+
+		F result = Simd::Select(Simd::GreaterEqual(d, Simd::Set1(0.5f)), Simd::Add(t, Simd::Set1(1.0f)), t);
+		result = Simd::Select(Simd::LessEqual(d, Simd::Set1(-0.5f)), Simd::Sub(t, Simd::Set1(1.0f)), result);
+		return result;
+	}
+
+	//sign follows x like std::fmodf
+	inline F Fmod(const F& x, const float32_t& y)
+	{
+		const F divisor = Simd::Set1(y);
+		return Simd::NegMulAdd(Simd::Trunc(Simd::Div(x, divisor)), divisor, x);
+	}
+
+	//cephes atanf range reduction, then quadrant fix-up like std::atan2f
+	inline F Atan2(const F& y, const F& x)
+	{
+		const F zero = Simd::Set1(0.0f);
+		const F ax = Simd::Abs(x);
+		const F ay = Simd::Abs(y);
+
+		//0/0 is defined as 0 here
+		const F ratio = Simd::Select(Simd::Equal(ay, zero), zero, Simd::Div(ay, ax));
+
+		const M large = Simd::Greater(ratio, Simd::Set1(2.414213562373095f));
+		const M medium = Simd::Greater(ratio, Simd::Set1(0.4142135623730950f));
+
+		F base = Simd::Select(medium, Simd::Set1(0.78539816f), zero);
+		base = Simd::Select(large, Simd::Set1(1.57079633f), base);
+
+		F t = Simd::Select(medium, Simd::Div(Simd::Sub(ratio, Simd::Set1(1.0f)), Simd::Add(ratio, Simd::Set1(1.0f))), ratio);
+		t = Simd::Select(large, Simd::Div(Simd::Set1(-1.0f), ratio), t);
+
+		const F z = Simd::Mul(t, t);
+		F p = Simd::Set1(8.05374449538e-2f);
+		p = Simd::MulAdd(p, z, Simd::Set1(-1.38776856032e-1f));
+		p = Simd::MulAdd(p, z, Simd::Set1(1.99777106478e-1f));
+		p = Simd::MulAdd(p, z, Simd::Set1(-3.33329491539e-1f));
+		p = Simd::Mul(Simd::Mul(p, z), t);
+
+		F result = Simd::Add(base, Simd::Add(p, t));
+
+		result = Simd::Select(Simd::Less(x, zero), Simd::Sub(Simd::Set1(3.14159265f), result), result);
+		result = Simd::Select(Simd::Less(y, zero), Simd::Sub(zero, result), result);
+		return result;
+	}
+
+	//bitwise blend, the lanes are not touched as floats
+	inline I SelectI(const M& mask, const I& ifTrue, const I& ifFalse)
+	{
+		return Simd::AsInt(Simd::Select(mask, Simd::AsFloat(ifTrue), Simd::AsFloat(ifFalse)));
+	}
+
+	//runs op on whole registers, the tail goes through a zero padded copy
+	template<typename Op>
+	inline void ForEachPixels(uint32_t* pixels, const size_t& count, const Op& op)
+	{
+		size_t i = 0;
+		for (; i + width <= count; i += width)
+		{
+			Simd::StorePixels(pixels + i, op(Simd::LoadPixels(pixels + i)));
+		}
+
+		if (i < count)
+		{
+			uint32_t tail[width] = {};
+			std::memcpy(tail, pixels + i, (count - i) * sizeof(uint32_t));
+			Simd::StorePixels(tail, op(Simd::LoadPixels(tail)));
+			std::memcpy(pixels + i, tail, (count - i) * sizeof(uint32_t));
+		}
+	}
+
+	template<typename Op>
+	inline void ForEachPixelsToBytes(const uint32_t* pixels, byte* result, const size_t& count, const Op& op)
+	{
+		size_t i = 0;
+		for (; i + width <= count; i += width)
+		{
+			Simd::StoreBytes(result + i, op(Simd::LoadPixels(pixels + i)));
+		}
+
+		if (i < count)
+		{
+			uint32_t tail[width] = {};
+			byte tailResult[width] = {};
+			std::memcpy(tail, pixels + i, (count - i) * sizeof(uint32_t));
+			Simd::StoreBytes(tailResult, op(Simd::LoadPixels(tail)));
+			std::memcpy(result + i, tailResult, count - i);
+		}
+	}
+
+	//four gathers per register, each reads 32 bits at the entry and keeps the low byte
+	void ApplyLut(uint32_t* pixels, size_t count, const byte* tables)
+	{
+		const I mask = Simd::Set1i(0xFF);
+
+		ForEachPixels(pixels, count, [&](const I& in) {
+			I result = Simd::And(Simd::GatherBytes(tables, Simd::And(in, mask)), mask);
+			result = Simd::Or(result, Simd::ShiftLeft<8>(Simd::And(Simd::GatherBytes(tables + 256, Simd::And(Simd::ShiftRight<8>(in), mask)), mask)));
+			result = Simd::Or(result, Simd::ShiftLeft<16>(Simd::And(Simd::GatherBytes(tables + 512, Simd::And(Simd::ShiftRight<16>(in), mask)), mask)));
+			result = Simd::Or(result, Simd::ShiftLeft<24>(Simd::GatherBytes(tables + 768, Simd::ShiftRight<24>(in))));
+			return result;
+			});
+	}
+
+	void Vividness(uint32_t* pixels, size_t count, float32_t vividRatio)
+	{
+		//worthless calculation, the 8 bit round trip is exact
+		if (-0.001f < vividRatio && vividRatio < 0.001f) return;
+
+		const F third = Simd::Set1(0.33333f);
+		const F ratio = Simd::Set1(1.0f + vividRatio);
+
+		ForEachPixels(pixels, count, [&](const I& in) {
+			PixelsSoA color = Unpack(in);
+			const F avg = Simd::Mul(Simd::Add(Simd::Add(color.R, color.G), color.B), third);
+
+			color.R = Simd::MulAdd(Simd::Sub(color.R, avg), ratio, avg);
+			color.G = Simd::MulAdd(Simd::Sub(color.G, avg), ratio, avg);
+			color.B = Simd::MulAdd(Simd::Sub(color.B, avg), ratio, avg);
+			return Pack(color);
+			});
+	}
+
+	void NatualVividness(uint32_t* pixels, size_t count, float32_t vividRatio)
+	{
+		//worthless calculation, the 8 bit round trip is exact
+		if (-0.001f < vividRatio && vividRatio < 0.001f) return;
+
+		const F amount = Simd::Set1(2.0f * (-vividRatio));
+
+		ForEachPixels(pixels, count, [&](const I& in) {
+			PixelsSoA color = Unpack(in);
+
+			//R*0.299 + G*0.587 + B*0.114
+			const F avg = Simd::MulAdd(color.B, Simd::Set1(0.114f), Simd::MulAdd(color.G, Simd::Set1(0.587f), Simd::Mul(color.R, Simd::Set1(0.299f))));
+			const F maxChannel = Simd::Max(Simd::Max(color.B, color.G), color.R);
+			const F amtval = Simd::Mul(Simd::Abs(Simd::Sub(maxChannel, avg)), amount);
+
+			color.R = Simd::MulAdd(Simd::Sub(maxChannel, color.R), amtval, color.R);
+			color.G = Simd::MulAdd(Simd::Sub(maxChannel, color.G), amtval, color.G);
+			color.B = Simd::MulAdd(Simd::Sub(maxChannel, color.B), amtval, color.B);
+			return Pack(color);
+			});
+	}
+
+	void HSLAdjustment(uint32_t* pixels, size_t count, float32_t hueChange, float32_t saturationRatio, float32_t lightnessRatio)
+	{
+		const F zero = Simd::Set1(0.0f);
+		const F one = Simd::Set1(1.0f);
+		const F two = Simd::Set1(2.0f);
+		const F half = Simd::Set1(0.5f);
+		const F full = Simd::Set1(360.0f);
+
+		ForEachPixels(pixels, count, [&](const I& in) {
+			PixelsSoA color = Unpack(in);
+
+			//RGBAColor_32f::RGBtoHSL
+			const F maxChannel = Simd::Max(Simd::Max(color.R, color.G), color.B);
+			const F minChannel = Simd::Min(Simd::Min(color.R, color.G), color.B);
+
+			F L = Simd::Mul(Simd::Add(maxChannel, minChannel), half);
+			const M inRange = Simd::MaskAnd(Simd::Less(zero, L), Simd::Less(L, one));
+			F S = Simd::Select(inRange, Simd::Div(Simd::Sub(maxChannel, minChannel), Simd::Sub(one, Simd::Abs(Simd::MulAdd(two, L, Simd::Set1(-1.0f))))), zero);
+
+			const F y = Simd::Mul(Simd::Set1(1.7320508f), Simd::Sub(color.G, color.B));
+			const F x = Simd::Sub(Simd::Sub(Simd::Mul(two, color.R), color.G), color.B);
+			F H = Round(Simd::Mul(Atan2(y, x), Simd::Set1(radToDeg)));
+			H = Simd::Select(Simd::Less(H, zero), Simd::Add(H, full), H);
+
+			//ImageProcessingTools::HSLAdjustmentColor
+			H = Fmod(Simd::Add(Fmod(Simd::Add(H, Simd::Set1(hueChange)), 360.0f), full), 360.0f);
+			S = Simd::Min(Simd::Max(Simd::Mul(S, Simd::Set1(saturationRatio)), zero), one);
+			L = Simd::Min(Simd::Max(Simd::Mul(L, Simd::Set1(lightnessRatio)), zero), one);
+
+			//RGBAColor_32f::HSLtoRGB
+			const F C = Simd::Mul(Simd::Sub(one, Simd::Abs(Simd::MulAdd(two, L, Simd::Set1(-1.0f)))), S);
+			const F hPrime = Simd::Mul(H, Simd::Set1(1.0f / 60.0f));
+			const F X = Simd::Mul(C, Simd::Sub(one, Simd::Abs(Simd::Sub(Fmod(hPrime, 2.0f), one))));
+			const F lightMin = Simd::NegMulAdd(C, half, L);
+
+			//walk the sectors from the last one down so the lowest matching sector wins
+			F R = C, G = zero, B = X;
+
+			M sector = Simd::LessEqual(hPrime, Simd::Set1(5.0f));
+			R = Simd::Select(sector, X, R); B = Simd::Select(sector, C, B);
+
+			sector = Simd::LessEqual(hPrime, Simd::Set1(4.0f));
+			R = Simd::Select(sector, zero, R); G = Simd::Select(sector, X, G);
+
+			sector = Simd::LessEqual(hPrime, Simd::Set1(3.0f));
+			G = Simd::Select(sector, C, G); B = Simd::Select(sector, X, B);
+
+			sector = Simd::LessEqual(hPrime, Simd::Set1(2.0f));
+			R = Simd::Select(sector, X, R); B = Simd::Select(sector, zero, B);
+
+			sector = Simd::LessEqual(hPrime, Simd::Set1(1.0f));
+			R = Simd::Select(sector, C, R); G = Simd::Select(sector, X, G);
+
+			color.R = Simd::Add(R, lightMin);
+			color.G = Simd::Add(G, lightMin);
+			color.B = Simd::Add(B, lightMin);
+			return Pack(color);
+			});
+	}
+
+	//the weighted linear channels are summed in the scalar order, the level at the top bits of the sum is off by at most one
+	void Grayscale(const uint32_t* pixels, byte* result, size_t count, const float32_t* linear, const byte* coarse, const float32_t* thresholds)
+	{
+		const I mask = Simd::Set1i(0xFF);
+
+		ForEachPixelsToBytes(pixels, result, count, [&](const I& in) {
+			F sum = Simd::Add(Simd::GatherFloats(linear, Simd::And(in, mask)), Simd::GatherFloats(linear + 256, Simd::And(Simd::ShiftRight<8>(in), mask)));
+			sum = Simd::Add(sum, Simd::GatherFloats(linear + 512, Simd::And(Simd::ShiftRight<16>(in), mask)));
+
+			const I bucket = Simd::ShiftRight<16>(Simd::AsInt(Simd::Min(sum, Simd::Set1(1.0f))));
+			const I level = Simd::And(Simd::GatherBytes(coarse, bucket), mask);
+			const I next = Simd::AddI(level, Simd::Set1i(1));
+
+			return Simd::ToInt(Simd::Select(Simd::LessEqual(Simd::GatherFloats(thresholds, next), sum), Simd::ToFloat(next), Simd::ToFloat(level)));
+			});
+	}
+
+	void Binarization(const uint32_t* pixels, byte* result, size_t count, float32_t threshold)
+	{
+		const F level = Simd::Set1(threshold * maxColorPix);
+		const I mask = Simd::Set1i(0xFF);
+
+		ForEachPixelsToBytes(pixels, result, count, [&](const I& in) {
+			const I R = Simd::And(in, mask);
+			const I G = Simd::And(Simd::ShiftRight<8>(in), mask);
+			const I B = Simd::And(Simd::ShiftRight<16>(in), mask);
+
+			//ImageProcessingTools::FastGray, 2/8 5/8 1/8
+			I avg = Simd::ShiftLeft<2>(R);
+			avg = Simd::AddI(avg, Simd::ShiftLeft<3>(G));
+			avg = Simd::AddI(avg, Simd::ShiftLeft<1>(G));
+			avg = Simd::AddI(avg, Simd::ShiftLeft<1>(B));
+			avg = Simd::ShiftRight<4>(avg);
+
+			return Simd::ToInt(Simd::Select(Simd::GreaterEqual(Simd::ToFloat(avg), level), Simd::Set1(maxColorPix), Simd::Set1(0.0f)));
+			});
+	}
+
+	//ColorCube::Lookup in the same order with fused multiply-adds, the gathers read the corners channel by channel
+	void ApplyCube(uint32_t* pixels, size_t count, const float32_t* lattice, uint32_t size, const float32_t* scale, const float32_t* bias, const byte* alpha)
+	{
+		const I mask = Simd::Set1i(0xFF);
+		const F zero = Simd::Set1(0.0f);
+		const F one = Simd::Set1(1.0f);
+		const F half = Simd::Set1(0.5f);
+		const F top = Simd::Set1(static_cast<float32_t>(size - 1u));
+		const F lastCell = Simd::Set1(static_cast<float32_t>(size - 2u));
+		const F white = Simd::Set1(maxColorPix);
+
+		//in floats, a point is 4 of them
+		const I strides[3] = { Simd::Set1i(4), Simd::Set1i(static_cast<int32_t>(4u * size)), Simd::Set1i(static_cast<int32_t>(4u * size * size)) };
+		const I corner = Simd::AddI(Simd::AddI(strides[0], strides[1]), strides[2]);
+
+		ForEachPixels(pixels, count, [&](const I& in) {
+			const I values[3] = { Simd::And(in, mask), Simd::And(Simd::ShiftRight<8>(in), mask), Simd::And(Simd::ShiftRight<16>(in), mask) };
+
+			I base = Simd::Set1i(0);
+			F fraction[3];
+
+			for (size_t channel = 0u; channel < 3u; ++channel)
+			{
+				F position = Simd::MulAdd(Simd::ToFloat(values[channel]), Simd::Set1(scale[channel]), Simd::Set1(bias[channel]));
+				position = Simd::Min(Simd::Max(position, zero), top);
+
+				const F cell = Simd::Min(Simd::ToFloat(Simd::ToInt(position)), lastCell);
+
+				fraction[channel] = Simd::Sub(position, cell);
+				base = Simd::AddI(base, Simd::MulI(Simd::ToInt(cell), strides[channel]));
+			}
+
+			const M RG = Simd::GreaterEqual(fraction[0], fraction[1]);
+			const M GB = Simd::GreaterEqual(fraction[1], fraction[2]);
+			const M RB = Simd::GreaterEqual(fraction[0], fraction[2]);
+
+			const I first = SelectI(Simd::MaskAnd(RG, RB), strides[0], SelectI(GB, strides[1], strides[2]));
+			const I last = SelectI(Simd::MaskAnd(RB, GB), strides[2], SelectI(RG, strides[1], strides[0]));
+
+			const F high = Simd::Max(fraction[0], Simd::Max(fraction[1], fraction[2]));
+			const F low = Simd::Min(fraction[0], Simd::Min(fraction[1], fraction[2]));
+			const F middle = Simd::Max(Simd::Min(fraction[0], fraction[1]), Simd::Min(Simd::Max(fraction[0], fraction[1]), fraction[2]));
+
+			const I corners[4] = { base, Simd::AddI(base, first), Simd::SubI(Simd::AddI(base, corner), last), Simd::AddI(base, corner) };
+			const F weights[4] = { Simd::Sub(one, high), Simd::Sub(high, middle), Simd::Sub(middle, low), low };
+
+			//R G B sit at floats 3 2 1 of a point
+			I result = Simd::ShiftLeft<24>(Simd::GatherBytes(alpha, Simd::ShiftRight<24>(in)));
+
+			for (int32_t channel = 0; channel < 3; ++channel)
+			{
+				const float32_t* plane = lattice + (3 - channel);
+
+				F value = Simd::Mul(Simd::GatherFloats(plane, corners[0]), weights[0]);
+				for (size_t k = 1u; k < 4u; ++k)
+				{
+					value = Simd::MulAdd(Simd::GatherFloats(plane, corners[k]), weights[k], value);
+				}
+
+				const I channelValue = Simd::ToInt(Simd::Min(Simd::Max(Simd::Add(value, half), zero), white));
+				result = Simd::Or(result, (channel == 0) ? channelValue : ((channel == 1) ? Simd::ShiftLeft<8>(channelValue) : Simd::ShiftLeft<16>(channelValue)));
+			}
+			return result;
+			});
+	}
+
+	/*
+	* The words of SharpenFixed in Image.cpp lane by lane, so the result is the same bit for bit, 2 * wordPixels pixels a step.
+	* Two taps of a group are interleaved and summed by pmaddubsw with weights of 1, pmaddwd applies the group weights exactly.
+	* pmulhrsw is left out, its rounding at 15 bits would add up over the groups and miss the float path by more than 1.
+	*/
+	size_t Sharpen(const uint32_t* const* center, ptrdiff_t x, size_t count, const SharpenTap* taps, size_t tapCount, const int16_t* weights, int32_t shift, uint32_t* result)
+	{
+		constexpr size_t step = Simd::wordPixels << 1u;
+
+		const Simd::W zero = Simd::ZeroW();
+		const Simd::W ones = Simd::Set1w(0x01010101);
+		const Simd::W pairs[2] = {
+			Simd::Set1w(static_cast<int32_t>((static_cast<uint32_t>(static_cast<uint16_t>(weights[1])) << 16u) | static_cast<uint16_t>(weights[0]))),
+			Simd::Set1w(static_cast<int32_t>((static_cast<uint32_t>(static_cast<uint16_t>(weights[3])) << 16u) | static_cast<uint16_t>(weights[2])))
+		};
+
+		size_t done = 0u;
+		for (; done + step <= count; done += step)
+		{
+			for (size_t part = 0u; part < step; part += Simd::wordPixels)
+			{
+				const ptrdiff_t X = x + static_cast<ptrdiff_t>(done + part);
+				Simd::W sums[4][2] = { { zero, zero }, { zero, zero }, { zero, zero }, { zero, zero } };
+
+				for (size_t i = 0u; i < tapCount; ++i)
+				{
+					const SharpenTap& tap = taps[i];
+					const Simd::W first = Simd::LoadWords(center[tap.dy] + X + tap.dx);
+					Simd::W second = zero;
+
+					if (i + 1u < tapCount && taps[i + 1u].group == tap.group)
+					{
+						++i;
+						second = Simd::LoadWords(center[taps[i].dy] + X + taps[i].dx);
+					}
+
+					sums[tap.group][0] = Simd::Add16(sums[tap.group][0], Simd::MaddBytes(Simd::UnpackLo8(first, second), ones));
+					sums[tap.group][1] = Simd::Add16(sums[tap.group][1], Simd::MaddBytes(Simd::UnpackHi8(first, second), ones));
+				}
+
+				Simd::W halves[2];
+				for (size_t half = 0u; half < 2u; ++half)
+				{
+					const Simd::W low = Simd::Add32(
+						Simd::MaddWords(Simd::UnpackLo16(sums[0][half], sums[1][half]), pairs[0]),
+						Simd::MaddWords(Simd::UnpackLo16(sums[2][half], sums[3][half]), pairs[1]));
+					const Simd::W high = Simd::Add32(
+						Simd::MaddWords(Simd::UnpackHi16(sums[0][half], sums[1][half]), pairs[0]),
+						Simd::MaddWords(Simd::UnpackHi16(sums[2][half], sums[3][half]), pairs[1]));
+
+					halves[half] = Simd::PackSigned32(Simd::ShiftRightArithmetic32(low, shift), Simd::ShiftRightArithmetic32(high, shift));
+				}
+
+				Simd::StoreWords(result + X, Simd::PackUnsigned16(halves[0], halves[1]));
+			}
+		}
+		return done;
+	}
+
+	const PixelKernelTable kernelTable = {
+		ApplyLut,
+		Vividness,
+		NatualVividness,
+		HSLAdjustment,
+		Grayscale,
+		Binarization,
+		ApplyCube,
+		Sharpen
+	};
+}
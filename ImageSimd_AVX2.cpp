@@ -0,0 +1,106 @@
+//built with AVX2 and FMA enabled, only reached when CpuFeatures reports both
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "ImageSimd.h"
+
+namespace
+{
+	struct Simd
+	{
+		using F = __m256;
+		using I = __m256i;
+		using M = __m256;
+
+		static constexpr size_t width = 8u;
+
+		static F Set1(const float32_t& value) { return _mm256_set1_ps(value); }
+		static I Set1i(const int32_t& value) { return _mm256_set1_epi32(value); }
+
+		static I LoadPixels(const uint32_t* pixels) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels)); }
+		//32 bits at base + index bytes, and the float at base[index]
+		static I GatherBytes(const byte* base, const I& index) { return _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), index, 1); }
+		static F GatherFloats(const float32_t* base, const I& index) { return _mm256_i32gather_ps(base, index, 4); }
+		static void StorePixels(uint32_t* pixels, const I& value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), value); }
+
+		//low byte of every lane, lanes hold 0 to 255
+		static void StoreBytes(byte* result, const I& value)
+		{
+			const __m256i words = _mm256_packus_epi32(value, value);
+			const __m256i bytes = _mm256_packus_epi16(words, words);
+			const __m256i ordered = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(result), _mm256_castsi256_si128(ordered));
+		}
+
+		static F Add(const F& a, const F& b) { return _mm256_add_ps(a, b); }
+		static F Sub(const F& a, const F& b) { return _mm256_sub_ps(a, b); }
+		static F Mul(const F& a, const F& b) { return _mm256_mul_ps(a, b); }
+		static F Div(const F& a, const F& b) { return _mm256_div_ps(a, b); }
+		static F Min(const F& a, const F& b) { return _mm256_min_ps(a, b); }
+		static F Max(const F& a, const F& b) { return _mm256_max_ps(a, b); }
+		static F Abs(const F& a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		static F Trunc(const F& a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+		//a * b + c and c - a * b in one rounding
+		static F MulAdd(const F& a, const F& b, const F& c) { return _mm256_fmadd_ps(a, b, c); }
+		static F NegMulAdd(const F& a, const F& b, const F& c) { return _mm256_fnmadd_ps(a, b, c); }
+
+		static F ToFloat(const I& a) { return _mm256_cvtepi32_ps(a); }
+		static I ToInt(const F& a) { return _mm256_cvttps_epi32(a); }
+		static F AsFloat(const I& a) { return _mm256_castsi256_ps(a); }
+		static I AsInt(const F& a) { return _mm256_castps_si256(a); }
+
+		static I And(const I& a, const I& b) { return _mm256_and_si256(a, b); }
+		static I Or(const I& a, const I& b) { return _mm256_or_si256(a, b); }
+		static I AddI(const I& a, const I& b) { return _mm256_add_epi32(a, b); }
+		static I SubI(const I& a, const I& b) { return _mm256_sub_epi32(a, b); }
+		static I MulI(const I& a, const I& b) { return _mm256_mullo_epi32(a, b); }
+		template<int N> static I ShiftLeft(const I& a) { return _mm256_slli_epi32(a, N); }
+		template<int N> static I ShiftRight(const I& a) { return _mm256_srli_epi32(a, N); }
+
+		static M Less(const F& a, const F& b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static M LessEqual(const F& a, const F& b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+		static M Greater(const F& a, const F& b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static M GreaterEqual(const F& a, const F& b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+		static M Equal(const F& a, const F& b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		static M MaskAnd(const M& a, const M& b) { return _mm256_and_ps(a, b); }
+		static F Select(const M& mask, const F& ifTrue, const F& ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, mask); }
+
+		//16-bit words for the fixed point kernels, every operation stays inside a 128-bit lane
+		using W = __m256i;
+
+		static constexpr size_t wordPixels = 8u;
+
+		static W LoadWords(const uint32_t* pixels) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels)); }
+		static void StoreWords(uint32_t* pixels, const W& value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), value); }
+		static W Set1w(const int32_t& value) { return _mm256_set1_epi32(value); }
+		static W ZeroW() { return _mm256_setzero_si256(); }
+		static W UnpackLo8(const W& a, const W& b) { return _mm256_unpacklo_epi8(a, b); }
+		static W UnpackHi8(const W& a, const W& b) { return _mm256_unpackhi_epi8(a, b); }
+		static W UnpackLo16(const W& a, const W& b) { return _mm256_unpacklo_epi16(a, b); }
+		static W UnpackHi16(const W& a, const W& b) { return _mm256_unpackhi_epi16(a, b); }
+		//unsigned bytes of a times signed bytes of b, and int16 words of a times b, adjacent products summed
+		static W MaddBytes(const W& a, const W& b) { return _mm256_maddubs_epi16(a, b); }
+		static W MaddWords(const W& a, const W& b) { return _mm256_madd_epi16(a, b); }
+		static W Add16(const W& a, const W& b) { return _mm256_add_epi16(a, b); }
+		static W Add32(const W& a, const W& b) { return _mm256_add_epi32(a, b); }
+		static W ShiftRightArithmetic32(const W& a, const int32_t& count) { return _mm256_sra_epi32(a, _mm_cvtsi32_si128(count)); }
+		static W PackSigned32(const W& a, const W& b) { return _mm256_packs_epi32(a, b); }
+		static W PackUnsigned16(const W& a, const W& b) { return _mm256_packus_epi16(a, b); }
+	};
+}
+
+#include "ImageSimdKernels.h"
+
+const PixelKernelTable& PixelKernelsAVX2()
+{
+	return kernelTable;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
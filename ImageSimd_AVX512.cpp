@@ -0,0 +1,101 @@
+//built with AVX-512 F, CD, BW, DQ and VL enabled like /arch:AVX512, only reached when CpuFeatures reports all of them
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f,avx512cd,avx512bw,avx512dq,avx512vl,avx2,fma")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512cd,avx512bw,avx512dq,avx512vl,avx2,fma"))), apply_to = function)
+#endif
+
+#include <immintrin.h>
+#include "ImageSimd.h"
+
+namespace
+{
+	struct Simd
+	{
+		using F = __m512;
+		using I = __m512i;
+		using M = __mmask16;
+
+		static constexpr size_t width = 16u;
+
+		static F Set1(const float32_t& value) { return _mm512_set1_ps(value); }
+		static I Set1i(const int32_t& value) { return _mm512_set1_epi32(value); }
+
+		static I LoadPixels(const uint32_t* pixels) { return _mm512_loadu_si512(pixels); }
+		//32 bits at base + index bytes, and the float at base[index]
+		static I GatherBytes(const byte* base, const I& index) { return _mm512_i32gather_epi32(index, base, 1); }
+		static F GatherFloats(const float32_t* base, const I& index) { return _mm512_i32gather_ps(index, base, 4); }
+		static void StorePixels(uint32_t* pixels, const I& value) { _mm512_storeu_si512(pixels, value); }
+
+		//low byte of every lane, lanes hold 0 to 255
+		static void StoreBytes(byte* result, const I& value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm512_cvtepi32_epi8(value)); }
+
+		static F Add(const F& a, const F& b) { return _mm512_add_ps(a, b); }
+		static F Sub(const F& a, const F& b) { return _mm512_sub_ps(a, b); }
+		static F Mul(const F& a, const F& b) { return _mm512_mul_ps(a, b); }
+		static F Div(const F& a, const F& b) { return _mm512_div_ps(a, b); }
+		static F Min(const F& a, const F& b) { return _mm512_min_ps(a, b); }
+		static F Max(const F& a, const F& b) { return _mm512_max_ps(a, b); }
+		static F Abs(const F& a) { return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(0x7FFFFFFF))); }
+		static F Trunc(const F& a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+		//a * b + c and c - a * b in one rounding
+		static F MulAdd(const F& a, const F& b, const F& c) { return _mm512_fmadd_ps(a, b, c); }
+		static F NegMulAdd(const F& a, const F& b, const F& c) { return _mm512_fnmadd_ps(a, b, c); }
+
+		static F ToFloat(const I& a) { return _mm512_cvtepi32_ps(a); }
+		static I ToInt(const F& a) { return _mm512_cvttps_epi32(a); }
+		static F AsFloat(const I& a) { return _mm512_castsi512_ps(a); }
+		static I AsInt(const F& a) { return _mm512_castps_si512(a); }
+
+		static I And(const I& a, const I& b) { return _mm512_and_epi32(a, b); }
+		static I Or(const I& a, const I& b) { return _mm512_or_epi32(a, b); }
+		static I AddI(const I& a, const I& b) { return _mm512_add_epi32(a, b); }
+		static I SubI(const I& a, const I& b) { return _mm512_sub_epi32(a, b); }
+		static I MulI(const I& a, const I& b) { return _mm512_mullo_epi32(a, b); }
+		template<int N> static I ShiftLeft(const I& a) { return _mm512_slli_epi32(a, N); }
+		template<int N> static I ShiftRight(const I& a) { return _mm512_srli_epi32(a, N); }
+
+		static M Less(const F& a, const F& b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		static M LessEqual(const F& a, const F& b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+		static M Greater(const F& a, const F& b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+		static M GreaterEqual(const F& a, const F& b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+		static M Equal(const F& a, const F& b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+		static M MaskAnd(const M& a, const M& b) { return static_cast<M>(a & b); }
+		static F Select(const M& mask, const F& ifTrue, const F& ifFalse) { return _mm512_mask_blend_ps(mask, ifFalse, ifTrue); }
+
+		//16-bit words for the fixed point kernels, 256 bits wide like the AVX2 unit so both share one Sharpen layout.
+		//every operation stays inside a 128-bit lane
+		using W = __m256i;
+
+		static constexpr size_t wordPixels = 8u;
+
+		static W LoadWords(const uint32_t* pixels) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels)); }
+		static void StoreWords(uint32_t* pixels, const W& value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), value); }
+		static W Set1w(const int32_t& value) { return _mm256_set1_epi32(value); }
+		static W ZeroW() { return _mm256_setzero_si256(); }
+		static W UnpackLo8(const W& a, const W& b) { return _mm256_unpacklo_epi8(a, b); }
+		static W UnpackHi8(const W& a, const W& b) { return _mm256_unpackhi_epi8(a, b); }
+		static W UnpackLo16(const W& a, const W& b) { return _mm256_unpacklo_epi16(a, b); }
+		static W UnpackHi16(const W& a, const W& b) { return _mm256_unpackhi_epi16(a, b); }
+		//unsigned bytes of a times signed bytes of b, and int16 words of a times b, adjacent products summed
+		static W MaddBytes(const W& a, const W& b) { return _mm256_maddubs_epi16(a, b); }
+		static W MaddWords(const W& a, const W& b) { return _mm256_madd_epi16(a, b); }
+		static W Add16(const W& a, const W& b) { return _mm256_add_epi16(a, b); }
+		static W Add32(const W& a, const W& b) { return _mm256_add_epi32(a, b); }
+		static W ShiftRightArithmetic32(const W& a, const int32_t& count) { return _mm256_sra_epi32(a, _mm_cvtsi32_si128(count)); }
+		static W PackSigned32(const W& a, const W& b) { return _mm256_packs_epi32(a, b); }
+		static W PackUnsigned16(const W& a, const W& b) { return _mm256_packus_epi16(a, b); }
+	};
+}
+
+#include "ImageSimdKernels.h"
+
+const PixelKernelTable& PixelKernelsAVX512()
+{
+	return kernelTable;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
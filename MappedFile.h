@@ -0,0 +1,171 @@
+#pragma once
+#ifndef MAPPEDFILE
+#define MAPPEDFILE
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "basedef.h"
+
+/*
+* Read-only view of a whole file, the pages are loaded by the OS on first touch.
+* The decoder reads the PNG from here instead of a malloc'd copy of the file.
+*/
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	//false if the file can't be opened or mapped, an empty file maps to size 0
+	bool Open(const std::filesystem::path& file);
+	void Close();
+
+	const byte* data() const;
+	size_t size() const;
+
+protected:
+	const byte* view = nullptr;
+	size_t length = 0u;
+
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int32_t descriptor = -1;
+#endif
+};
+
+inline MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+inline bool MappedFile::Open(const std::filesystem::path& file)
+{
+	Close();
+
+	this->file = CreateFileW(file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (this->file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(this->file, &fileSize))
+	{
+		Close();
+		return false;
+	}
+
+	//a mapping of zero bytes is an error, there is nothing to view anyway
+	if (fileSize.QuadPart == 0)
+		return true;
+
+	this->mapping = CreateFileMappingW(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (this->mapping != nullptr)
+		this->view = static_cast<const byte*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (this->view == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	this->length = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+inline void MappedFile::Close()
+{
+	if (this->view != nullptr)
+		UnmapViewOfFile(this->view);
+
+	if (this->mapping != nullptr)
+		CloseHandle(this->mapping);
+
+	if (this->file != INVALID_HANDLE_VALUE)
+		CloseHandle(this->file);
+
+	this->view = nullptr;
+	this->length = 0u;
+	this->mapping = nullptr;
+	this->file = INVALID_HANDLE_VALUE;
+}
+#else
+inline bool MappedFile::Open(const std::filesystem::path& file)
+{
+	Close();
+
+	this->descriptor = open(file.c_str(), O_RDONLY);
+	if (this->descriptor < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(this->descriptor, &status) != 0 || !S_ISREG(status.st_mode))
+	{
+		Close();
+		return false;
+	}
+
+	//mmap rejects a length of zero, there is nothing to view anyway
+	if (status.st_size == 0)
+		return true;
+
+	void* mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, this->descriptor, 0);
+	if (mapped == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	//the decoder walks the chunks and inflates IDAT front to back
+	madvise(mapped, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+	this->view = static_cast<const byte*>(mapped);
+	this->length = static_cast<size_t>(status.st_size);
+	return true;
+}
+
+inline void MappedFile::Close()
+{
+	if (this->view != nullptr)
+		munmap(const_cast<byte*>(this->view), this->length);
+
+	if (this->descriptor >= 0)
+		close(this->descriptor);
+
+	this->view = nullptr;
+	this->length = 0u;
+	this->descriptor = -1;
+}
+#endif
+
+inline const byte* MappedFile::data() const
+{
+	return this->view;
+}
+
+inline size_t MappedFile::size() const
+{
+	return this->length;
+}
+
+#endif // !MAPPEDFILE
@@ -38,6 +38,28 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 #include <stdlib.h> /* allocations */
 #endif /* LODEPNG_COMPILE_ALLOCATORS */
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+#include <cstring>
+#include <atomic>
+#include <new>
+#include "CppParallelAccelerator.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LODEPNG_X86_SIMD true
+#include <immintrin.h>
+#include "CpuFeatures.h"
+#else
+#define LODEPNG_X86_SIMD false
+#endif
+
+/*MSVC emits any intrinsic without switches, gcc and clang need the ISA enabled per function*/
+#if defined(_MSC_VER) && !defined(__clang__)
+#define LODEPNG_TARGET(isa)
+#else
+#define LODEPNG_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1310) /*Visual Studio: A few warning types are not desired here.*/
 #pragma warning( disable : 4244 ) /*implicit conversions: not warned by gcc -Wall -Wextra and requires too much casts*/
 #pragma warning( disable : 4996 ) /*VS does not like fopen, but fopen_s is not standard C so unusable here*/
@@ -510,12 +532,19 @@ static void writeBitsReversed(LodePNGBitWriter* writer, uint32_t value, size_t n
 
 #ifdef LODEPNG_COMPILE_DECODER
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+struct InflateChain;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 struct LodePNGBitReader{
 	const byte* data;
 	size_t size; /*size of data in bytes*/
 	size_t bitsize; /*size of data in bits, end of valid bp values, should be 8*size*/
 	size_t bp;
 	uint32_t buffer; /*buffer for reading bits. NOTE: 'unsigned' must support at least 32 bits*/
+#if IMSD_SOURCE_CODE_MODIFICATION
+	InflateChain* chain; /*not null when data is a view into input in several pieces, see InflateChain*/
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 } ;
 
 /* data size argument is in bytes. Returns error if size too large causing overflow */
@@ -530,6 +559,9 @@ static uint32_t LodePNGBitReader_init(LodePNGBitReader* reader, const byte* data
 	if (lodepng_addofl(reader->bitsize, 64u, &temp)) return 105;
 	reader->bp = 0;
 	reader->buffer = 0;
+#if IMSD_SOURCE_CODE_MODIFICATION
+	reader->chain = 0;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 	return 0; /*ok*/
 }
 
@@ -633,6 +665,102 @@ static LODEPNG_INLINE uint32_t readBits(LodePNGBitReader* reader, size_t nbits)
 	advanceBits(reader, nbits);
 	return result;
 }
+
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*a piece of the input, like the data of one IDAT chunk*/
+struct InflateSegment {
+	const byte* data;
+	size_t size;
+};
+
+/*bytes a view that does not reach the end of the input keeps ahead of the bit pointer, more than one symbol reads*/
+static constexpr size_t lodepng_inflate_chain_margin = 64u;
+/*bytes copied across a seam, enough for the fast path to run on when the segments are tiny*/
+static constexpr size_t lodepng_inflate_chain_seam = 1024u;
+
+/*
+Input made of segments that are not contiguous in memory, so the IDAT chunks of a PNG need not be joined.
+The bit reader reads a view of it: a segment in place while the bit pointer is far from the segment end,
+else a copy of the bytes from the seam between segments on. Positions count bytes over all segments.
+A view that ends before the input is moved on by inflateChainFollow before it can be read past.
+*/
+struct InflateChain {
+	const InflateSegment* segments;
+	size_t count;
+	size_t total; /*bytes in all segments*/
+	size_t segment; /*the segment the view starts in*/
+	size_t segmentStart; /*position of that segment*/
+	size_t viewStart; /*position of reader->data[0]*/
+	int32_t final; /*the view reaches the end of the input*/
+	byte seam[lodepng_inflate_chain_seam];
+};
+
+static void inflateChainInit(InflateChain* chain, const InflateSegment* segments, size_t count) {
+	chain->segments = segments;
+	chain->count = count;
+	chain->total = 0;
+	for (size_t i = 0; i != count; ++i) chain->total += segments[i].size;
+	chain->segment = 0;
+	chain->segmentStart = 0;
+	chain->viewStart = 0;
+	chain->final = 0;
+}
+
+/*copy size bytes from position pos on, the caller checks that they exist*/
+static void inflateChainCopy(const InflateChain* chain, size_t pos, byte* dst, size_t size) {
+	size_t segment = chain->segment;
+	size_t start = chain->segmentStart;
+	if (pos < start) segment = start = 0;
+	while (size) {
+		const InflateSegment* piece = &chain->segments[segment];
+		if (pos < start + piece->size) {
+			size_t n = start + piece->size - pos;
+			if (n > size) n = size;
+			lodepng_memcpy(dst, (unknown_pointer)(piece->data + (pos - start)), n);
+			dst += n;
+			pos += n;
+			size -= n;
+		}
+		start += piece->size;
+		++segment;
+	}
+}
+
+/*view the input from bit bit of position pos on*/
+static void inflateChainView(LodePNGBitReader* reader, size_t pos, size_t bit) {
+	InflateChain* chain = reader->chain;
+	while (chain->segment + 1u < chain->count && pos >= chain->segmentStart + chain->segments[chain->segment].size) {
+		chain->segmentStart += chain->segments[chain->segment].size;
+		++chain->segment;
+	}
+
+	const InflateSegment* piece = &chain->segments[chain->segment];
+	size_t left = chain->segmentStart + piece->size - pos;
+
+	if (left >= sizeof(chain->seam) || pos + left == chain->total) {
+		reader->data = piece->data + (pos - chain->segmentStart);
+		reader->size = left;
+	}
+	else {
+		reader->size = chain->total - pos;
+		if (reader->size > sizeof(chain->seam)) reader->size = sizeof(chain->seam);
+		inflateChainCopy(chain, pos, chain->seam, reader->size);
+		reader->data = chain->seam;
+	}
+	chain->viewStart = pos;
+	chain->final = pos + reader->size == chain->total;
+	reader->bitsize = reader->size * 8u;
+	reader->bp = bit;
+}
+
+/*move the view on once the bit pointer is near its end, returns 1 if it moved*/
+static LODEPNG_INLINE int32_t inflateChainFollow(LodePNGBitReader* reader) {
+	InflateChain* chain = reader->chain;
+	if (!chain || chain->final || reader->size - (reader->bp >> 3u) >= lodepng_inflate_chain_margin) return 0;
+	inflateChainView(reader, chain->viewStart + (reader->bp >> 3u), reader->bp & 7u);
+	return 1;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 static uint32_t reverseBits(uint32_t bits, uint32_t num) {
@@ -1177,6 +1305,10 @@ static uint32_t getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 	uint32_t* bitlen_cl = 0;
 	HuffmanTree tree_cl; /*the code tree for code length codes (the huffman tree for compressed huffman trees)*/
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+	/*the margin of the view covers the header and the code length code lengths*/
+	inflateChainFollow(reader);
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 	if (reader->bitsize - reader->bp < 14) return 49; /*error: the bit pointer is or will go past the memory*/
 	ensureBits17(reader, 14);
 
@@ -1219,6 +1351,9 @@ static uint32_t getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 		i = 0;
 		while (i < HLIT + HDIST) {
 			uint32_t code;
+#if IMSD_SOURCE_CODE_MODIFICATION
+			inflateChainFollow(reader);
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 			ensureBits25(reader, 22); /* up to 15 bits for huffman code, up to 7 extra bits below*/
 			code = huffmanDecodeSymbol(reader, &tree_cl);
 			if (code <= 15) /*a length code*/ {
@@ -1301,14 +1436,268 @@ static uint32_t getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 	return error;
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*root bits of the combined literal/length table, two literals fit in one entry when their codes add up to this*/
+#define FASTBITS 11u
+
+/*
+Entry of the combined table: bits 0-7 hold the bits to consume, bits 8-9 the kind, bits 16-31 the payload.
+Kind 1 and 2 are one or two literals in bytes 2 and 3, kind 0 a length, end or invalid symbol,
+kind 3 a code longer than FASTBITS that goes through the full tree.
+*/
+#define FAST_SYMBOL 0u
+#define FAST_LITERAL1 1u
+#define FAST_LITERAL2 2u
+#define FAST_LONG 3u
+
+/*bytes kept free at the end of the output, a match of 258 rounded up to the 16 byte copy steps and a literal pair*/
+static constexpr size_t lodepng_inflate_fast_slack = 320;
+
+/*output gathered before a stream passes it on, and the longest distance a match may reach back*/
+static constexpr size_t lodepng_inflate_stream_size = 1u << 20u;
+static constexpr size_t lodepng_inflate_window = 32768u;
+
+/*
+Inflate into a bounded buffer: everything but the last 32K is handed to sink in order and dropped,
+the 32K stay for the back references of later matches.
+*/
+struct InflateStream {
+	uint32_t (*sink)(const byte* data, size_t size, void* context);
+	void* context;
+	size_t passed; /*bytes at the start of out that went to sink already*/
+};
+
+static uint32_t inflateStreamFlush(ucvector* out, InflateStream* stream, size_t keep) {
+	uint32_t error = 0;
+	if (out->size > stream->passed) error = stream->sink(out->data + stream->passed, out->size - stream->passed, stream->context);
+	if (out->size > keep) {
+		memmove(out->data, out->data + out->size - keep, keep);
+		out->size = keep;
+	}
+	stream->passed = out->size;
+	return error;
+}
+
+/*decode one symbol from the low bits of bits, the same lookup as huffmanDecodeSymbol without the bit reader*/
+static LODEPNG_INLINE uint32_t huffmanDecodeBits(uint32_t bits, const HuffmanTree* tree, uint32_t* len) {
+	uint32_t code = bits & ((1u << FIRSTBITS) - 1u);
+	uint32_t l = tree->table_len[code];
+	uint32_t value = tree->table_value[code];
+	if (l <= FIRSTBITS) {
+		*len = l;
+		return value;
+	}
+	value += (bits >> FIRSTBITS) & ((1u << (l - FIRSTBITS)) - 1u);
+	*len = tree->table_len[value];
+	return tree->table_value[value];
+}
+
+static void makeFastTable(uint32_t* table, const HuffmanTree* tree_ll) {
+	for (uint32_t i = 0; i != (1u << FASTBITS); ++i) {
+		uint32_t len1, len2;
+		uint32_t symbol1 = huffmanDecodeBits(i, tree_ll, &len1);
+
+		if (len1 > FASTBITS) {
+			table[i] = FAST_LONG << 8u;
+		}
+		else if (symbol1 > 255) {
+			table[i] = len1 | (FAST_SYMBOL << 8u) | (symbol1 << 16u);
+		}
+		else {
+			uint32_t symbol2 = huffmanDecodeBits(i >> len1, tree_ll, &len2);
+			if (symbol2 <= 255 && len1 + len2 <= FASTBITS) {
+				table[i] = (len1 + len2) | (FAST_LITERAL2 << 8u) | (symbol1 << 16u) | (symbol2 << 24u);
+			}
+			else {
+				table[i] = len1 | (FAST_LITERAL1 << 8u) | (symbol1 << 16u);
+			}
+		}
+	}
+}
+
+static LODEPNG_INLINE uint64_t lodepng_read64le(const byte* p) {
+#if LODEPNG_X86_SIMD
+	uint64_t value;
+	std::memcpy(&value, p, 8); /*x86 is little endian*/
+	return value;
+#else
+	uint64_t value = 0;
+	for (size_t i = 0; i != 8; ++i) value |= (uint64_t)p[i] << (i * 8u);
+	return value;
+#endif
+}
+
+/*copy a match of length bytes from distance back, may write up to 15 bytes past the end*/
+static LODEPNG_INLINE void inflateCopyMatch(byte* dst, size_t distance, size_t length) {
+	const byte* src = dst - distance;
+	byte* end = dst + length;
+
+	if (distance >= 16) {
+		/*every 16 byte step reads only bytes that are already final*/
+		do {
+#if LODEPNG_X86_SIMD
+			_mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#else
+			std::memcpy(dst, src, 16);
+#endif
+			src += 16;
+			dst += 16;
+		} while (dst < end);
+	}
+	else if (distance >= 8) {
+		do {
+			std::memcpy(dst, src, 8);
+			src += 8;
+			dst += 8;
+		} while (dst < end);
+	}
+	else if (distance == 1) {
+		std::memset(dst, *src, length);
+	}
+	else {
+		while (dst != end) *dst++ = *src++;
+	}
+}
+
+/*
+Decode symbols of the current block with a 64-bit bit buffer, as long as 8 more input bytes can be loaded.
+One refill covers the longest symbol sequence (15 + 5 + 15 + 13 bits), so there are no per-field checks.
+The reader is left at the first unused bit, the byte-wise loop in inflateHuffmanBlock takes over from there.
+table is made from tree_ll on the first call that has enough input, chained input calls this once per view.
+*/
+static uint32_t inflateHuffmanFast(ucvector* out, LodePNGBitReader* reader, uint32_t* table, int32_t* table_made,
+	const HuffmanTree* tree_ll, const HuffmanTree* tree_d, size_t max_output_size, int32_t* done, InflateStream* stream) {
+	uint32_t error = 0;
+	const byte* in = reader->data + (reader->bp >> 3u);
+	const byte* inend = reader->data + reader->size;
+	uint64_t bitbuf = 0;
+	uint32_t bitcount = 0;
+
+	if (inend - in < 16) return 0;
+
+	if (!*table_made) {
+		makeFastTable(table, tree_ll);
+		*table_made = 1;
+	}
+
+	/*start on the byte, then drop the bits of it that were already read*/
+	bitbuf = lodepng_read64le(in);
+	bitcount = 56u;
+	in += 7;
+	bitbuf >>= (reader->bp & 7u);
+	bitcount -= (uint32_t)(reader->bp & 7u);
+
+	for (;;) {
+		if (inend - in < 8) break;
+		/*refill to 56-63 bits*/
+		bitbuf |= lodepng_read64le(in) << bitcount;
+		in += (63u - bitcount) >> 3u;
+		bitcount |= 56u;
+
+		if (out->allocsize - out->size < lodepng_inflate_fast_slack) {
+			/*pass the output on instead of growing the buffer further*/
+			if (stream && out->size >= lodepng_inflate_stream_size) {
+				error = inflateStreamFlush(out, stream, lodepng_inflate_window);
+				if (error) break;
+			}
+			if (!ucvector_reserve(out, out->size + lodepng_inflate_fast_slack)) ERROR_BREAK(83); /*alloc fail*/
+		}
+
+		uint32_t entry = table[bitbuf & ((1u << FASTBITS) - 1u)];
+		uint32_t kind = (entry >> 8u) & 3u;
+		uint32_t code_ll, len;
+
+		if (kind == FAST_LITERAL2) {
+			out->data[out->size + 0] = (byte)(entry >> 16u);
+			out->data[out->size + 1] = (byte)(entry >> 24u);
+			out->size += 2;
+			len = entry & 255u;
+			bitbuf >>= len;
+			bitcount -= len;
+		}
+		else if (kind == FAST_LITERAL1) {
+			out->data[out->size++] = (byte)(entry >> 16u);
+			len = entry & 255u;
+			bitbuf >>= len;
+			bitcount -= len;
+		}
+		else {
+			if (kind == FAST_SYMBOL) {
+				code_ll = entry >> 16u;
+				len = entry & 255u;
+			}
+			else {
+				code_ll = huffmanDecodeBits((uint32_t)bitbuf, tree_ll, &len);
+			}
+			bitbuf >>= len;
+			bitcount -= len;
+
+			if (code_ll <= 255) {
+				out->data[out->size++] = (byte)code_ll;
+			}
+			else if (code_ll >= FIRST_LENGTH_CODE_INDEX && code_ll <= LAST_LENGTH_CODE_INDEX) {
+				uint32_t numextrabits = LENGTHEXTRA[code_ll - FIRST_LENGTH_CODE_INDEX];
+				size_t length = LENGTHBASE[code_ll - FIRST_LENGTH_CODE_INDEX] + (size_t)(bitbuf & ((1u << numextrabits) - 1u));
+				bitbuf >>= numextrabits;
+				bitcount -= numextrabits;
+
+				uint32_t code_d = huffmanDecodeBits((uint32_t)bitbuf, tree_d, &len);
+				if (code_d > 29) {
+					if (code_d <= 31) {
+						ERROR_BREAK(18); /*error: invalid distance code (30-31 are never used)*/
+					}
+					else /* if(code_d == INVALIDSYMBOL) */ {
+						ERROR_BREAK(16); /*error: tried to read disallowed huffman symbol*/
+					}
+				}
+				bitbuf >>= len;
+				bitcount -= len;
+
+				numextrabits = DISTANCEEXTRA[code_d];
+				size_t distance = DISTANCEBASE[code_d] + (size_t)(bitbuf & ((1u << numextrabits) - 1u));
+				bitbuf >>= numextrabits;
+				bitcount -= numextrabits;
+
+				if (distance > out->size) ERROR_BREAK(52); /*too long backward distance*/
+				inflateCopyMatch(out->data + out->size, distance, length);
+				out->size += length;
+			}
+			else if (code_ll == 256) {
+				*done = 1;
+				break;
+			}
+			else {
+				ERROR_BREAK(16); /*error: tried to read disallowed huffman symbol*/
+			}
+		}
+
+		if (max_output_size && out->size > max_output_size) ERROR_BREAK(109); /*error, larger than max size*/
+	}
+
+	/*the unused bits in the buffer were loaded but not consumed*/
+	reader->bp = (size_t)(in - reader->data) * 8u - bitcount;
+
+	return error;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 /*inflate a block with dynamic of fixed Huffman tree. btype must be 1 or 2.*/
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static uint32_t inflateHuffmanBlock(ucvector* out, LodePNGBitReader* reader,
 	uint32_t btype, size_t max_output_size) {
+#else
+static uint32_t inflateHuffmanBlock(ucvector* out, LodePNGBitReader* reader,
+	uint32_t btype, size_t max_output_size, InflateStream* stream = 0) {
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	uint32_t error = 0;
 	HuffmanTree tree_ll; /*the huffman tree for literal and length codes*/
 	HuffmanTree tree_d; /*the huffman tree for distance codes*/
 	const size_t reserved_size = 260; /* must be at least 258 for max length, and a few extra for adding a few extra literals */
 	int32_t done = 0;
+#if IMSD_SOURCE_CODE_MODIFICATION
+	uint32_t table[1u << FASTBITS]; /*the fast path lookup of tree_ll*/
+	int32_t table_made = 0;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 
 	if (!ucvector_reserve(out, out->size + reserved_size)) return 83; /*alloc fail*/
 
@@ -1318,10 +1707,29 @@ static uint32_t inflateHuffmanBlock(ucvector* out, LodePNGBitReader* reader,
 	if (btype == 1) error = getTreeInflateFixed(&tree_ll, &tree_d);
 	else /*if(btype == 2)*/ error = getTreeInflateDynamic(&tree_ll, &tree_d, reader);
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+	/*the bulk of the block, the loop below only decodes the last bytes of the input or of a segment*/
+	if (!error) error = inflateHuffmanFast(out, reader, table, &table_made, &tree_ll, &tree_d, max_output_size, &done, stream);
+	if (!error && out->allocsize - out->size < reserved_size) {
+		if (!ucvector_reserve(out, out->size + reserved_size)) error = 83; /*alloc fail*/
+	}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 
 	while (!error && !done) /*decode all symbols until end reached, breaks at end code*/ {
 		/*code_ll is literal, length or end code*/
 		uint32_t code_ll;
+#if IMSD_SOURCE_CODE_MODIFICATION
+		/*chained input moves the view on before each symbol, the fast path takes each new view up to its last bytes*/
+		while (inflateChainFollow(reader)) {
+			error = inflateHuffmanFast(out, reader, table, &table_made, &tree_ll, &tree_d, max_output_size, &done, stream);
+			if (error || done) break;
+			if (out->allocsize - out->size < reserved_size && !ucvector_reserve(out, out->size + reserved_size)) {
+				error = 83; /*alloc fail*/
+				break;
+			}
+		}
+		if (error || done) break;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 		/* ensure enough bits for 2 huffman code reads (15 bits each): if the first is a literal, a second literal is read at once. This
 		appears to be slightly faster, than ensuring 20 bits here for 1 huffman symbol and the potential 5 extra bits for the length symbol.*/
 		ensureBits32(reader, 30);
@@ -1421,6 +1829,32 @@ static uint32_t inflateNoCompression(ucvector* out, LodePNGBitReader* reader,
 	size_t size = reader->size;
 	uint32_t LEN, NLEN, error = 0;
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+	if (reader->chain) {
+		/*the block may span any number of segments, it is copied out of them by position*/
+		InflateChain* chain = reader->chain;
+		byte header[4];
+		size_t pos = chain->viewStart + ((reader->bp + 7u) >> 3u);
+
+		if (pos + 4 >= chain->total) return 52; /*error, bit pointer will jump past memory*/
+		inflateChainCopy(chain, pos, header, 4);
+		pos += 4;
+		LEN = (uint32_t)header[0] + ((uint32_t)header[1] << 8u);
+		NLEN = (uint32_t)header[2] + ((uint32_t)header[3] << 8u);
+
+		if (!settings->ignore_nlen && LEN + NLEN != 65535) {
+			return 21; /*error: NLEN is not one's complement of LEN*/
+		}
+
+		if (!ucvector_resize(out, out->size + LEN)) return 83; /*alloc fail*/
+		if (pos + LEN > chain->total) return 23; /*error: reading outside of in buffer*/
+
+		inflateChainCopy(chain, pos, out->data + out->size - LEN, LEN);
+		inflateChainView(reader, pos + LEN, 0);
+		return error;
+	}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 	/*go to first boundary of byte*/
 	bytepos = (reader->bp + 7u) >> 3u;
 
@@ -1447,6 +1881,7 @@ static uint32_t inflateNoCompression(ucvector* out, LodePNGBitReader* reader,
 	return error;
 }
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static uint32_t lodepng_inflatev(ucvector* out,
 	const byte* in, size_t insize,
 	const LodePNGDecompressSettings* settings) {
@@ -1455,9 +1890,19 @@ static uint32_t lodepng_inflatev(ucvector* out,
 	uint32_t error = LodePNGBitReader_init(&reader, in, insize);
 
 	if (error) return error;
+#else
+/*the blocks of a deflate stream, the reader is set up on one buffer or on an InflateChain*/
+static uint32_t inflateReader(ucvector* out, LodePNGBitReader& reader,
+	const LodePNGDecompressSettings* settings, InflateStream* stream) {
+	uint32_t BFINAL = 0;
+	uint32_t error = 0;
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 
 	while (!BFINAL) {
 		uint32_t BTYPE;
+#if IMSD_SOURCE_CODE_MODIFICATION
+		inflateChainFollow(&reader);
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 		if (reader.bitsize - reader.bp < 3) return 52; /*error, bit pointer will jump past memory*/
 		ensureBits9(&reader, 3);
 		BFINAL = readBits(&reader, 1);
@@ -1465,7 +1910,13 @@ static uint32_t lodepng_inflatev(ucvector* out,
 
 		if (BTYPE == 3) return 20; /*error: invalid BTYPE*/
 		else if (BTYPE == 0) error = inflateNoCompression(out, &reader, settings); /*no compression*/
+#if !IMSD_SOURCE_CODE_MODIFICATION
 		else error = inflateHuffmanBlock(out, &reader, BTYPE, settings->max_output_size); /*compression, BTYPE 01 or 10*/
+#else
+		else error = inflateHuffmanBlock(out, &reader, BTYPE, settings->max_output_size, stream); /*compression, BTYPE 01 or 10*/
+		/*stored blocks and the tail of a huffman block grow the buffer between the flushes of the fast path*/
+		if (!error && stream && out->size >= lodepng_inflate_stream_size) error = inflateStreamFlush(out, stream, lodepng_inflate_window);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 		if (!error && settings->max_output_size && out->size > settings->max_output_size) error = 109;
 		if (error) break;
 	}
@@ -1473,6 +1924,18 @@ static uint32_t lodepng_inflatev(ucvector* out,
 	return error;
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+static uint32_t lodepng_inflatev(ucvector* out,
+	const byte* in, size_t insize,
+	const LodePNGDecompressSettings* settings, InflateStream* stream = 0) {
+	LodePNGBitReader reader;
+	uint32_t error = LodePNGBitReader_init(&reader, in, insize);
+
+	if (error) return error;
+	return inflateReader(out, reader, settings, stream);
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 uint32_t lodepng_inflate(byte** out, size_t* outsize,
 	const byte* in, size_t insize,
 	const LodePNGDecompressSettings* settings) 
@@ -1484,8 +1947,13 @@ uint32_t lodepng_inflate(byte** out, size_t* outsize,
 	return error;
 }
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static unsigned inflatev(ucvector* out, const byte* in, size_t insize,
 	const LodePNGDecompressSettings* settings) {
+#else
+static unsigned inflatev(ucvector* out, const byte* in, size_t insize,
+	const LodePNGDecompressSettings* settings, InflateStream* stream = 0) {
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	if (settings->custom_inflate) {
 		uint32_t error = settings->custom_inflate(&out->data, &out->size, in, insize, settings);
 		out->allocsize = out->size;
@@ -1498,7 +1966,11 @@ static unsigned inflatev(ucvector* out, const byte* in, size_t insize,
 		return error;
 	}
 	else {
+#if !IMSD_SOURCE_CODE_MODIFICATION
 		return lodepng_inflatev(out, in, insize, settings);
+#else
+		return lodepng_inflatev(out, in, insize, settings, stream);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	}
 }
 
@@ -1658,13 +2130,22 @@ sliding window (of windowsize) is used, and all past bytes in that window can be
 the "dictionary". A brute force search through all possible distances would be slow, and
 this hash technique is one out of several ways to speed this up.
 */
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static uint32_t encodeLZ77(uivector* out, Hash* hash,
 	const byte* in, size_t inpos, size_t insize, uint32_t windowsize,
 	uint32_t minmatch, uint32_t nicematch, uint32_t lazymatching) {
+#else
+static uint32_t encodeLZ77(uivector* out, Hash* hash,
+	const byte* in, size_t inpos, size_t insize, uint32_t windowsize,
+	uint32_t minmatch, uint32_t nicematch, uint32_t lazymatching, uint32_t chainlength) {
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	size_t pos;
 	uint32_t i, error = 0;
 	/*for large window lengths, assume the user wants no compression loss. Otherwise, max hash chain length speedup.*/
 	uint32_t maxchainlength = windowsize >= 8192 ? windowsize : windowsize / 8u;
+#if IMSD_SOURCE_CODE_MODIFICATION
+	if (chainlength != 0) maxchainlength = chainlength;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 	uint32_t maxlazymatch = windowsize >= 8192 ? MAX_SUPPORTED_DEFLATE_LENGTH : 64;
 
 	uint32_t usezeros = 1; /*not sure if setting it to false for windowsize < 8192 is better or worse*/
@@ -1824,9 +2305,54 @@ static uint32_t encodeLZ77(uivector* out, Hash* hash,
 	return error;
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*
+Look for matches at distance 1 only, runs of the byte before. Filtered PNG rows are mostly such runs,
+and without hash chains every position is visited once.
+*/
+static uint32_t encodeRLE(uivector* out, const byte* in, size_t inpos, size_t insize, uint32_t minmatch) {
+	size_t pos = inpos;
+	if (minmatch < 3) minmatch = 3;
+
+	while (pos < insize) {
+		size_t length = 0;
+		if (pos > 0) {
+			const byte previous = in[pos - 1];
+			size_t limit = insize - pos;
+			if (limit > MAX_SUPPORTED_DEFLATE_LENGTH) limit = MAX_SUPPORTED_DEFLATE_LENGTH;
+			while (length != limit && in[pos + length] == previous) ++length;
+		}
+
+		if (length >= minmatch) {
+			addLengthDistance(out, length, 1);
+			pos += length;
+		}
+		else {
+			if (!uivector_push_back(out, in[pos])) return 83; /*alloc fail*/
+			++pos;
+		}
+	}
+
+	return 0;
+}
+
+/*the matcher the settings ask for*/
+static uint32_t encodeLZ77Settings(uivector* out, Hash* hash, const byte* in, size_t inpos, size_t insize,
+	const LodePNGCompressSettings* settings) {
+	if (settings->rle) return encodeRLE(out, in, inpos, insize, settings->minmatch);
+	return encodeLZ77(out, hash, in, inpos, insize, settings->windowsize,
+		settings->minmatch, settings->nicematch, settings->lazymatching, settings->maxchainlength);
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 /* /////////////////////////////////////////////////////////////////////////// */
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static uint32_t deflateNoCompression(ucvector* out, const byte* data, size_t datasize) {
+#else
+/*without last no block is marked final, the row encoder appends more blocks later*/
+static uint32_t deflateNoCompression(ucvector* out, const byte* data, size_t datasize, uint32_t last = 1) {
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	/*non compressed deflate block data: 1 bit BFINAL,2 bits BTYPE,(5 bits): it jumps to start of next byte,
 	2 bytes LEN, 2 bytes NLEN, LEN bytes literal DATA*/
 
@@ -1837,7 +2363,11 @@ static uint32_t deflateNoCompression(ucvector* out, const byte* data, size_t dat
 		byte firstbyte;
 		size_t pos = out->size;
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 		BFINAL = (i == numdeflateblocks - 1);
+#else
+		BFINAL = last && (i == numdeflateblocks - 1);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 		BTYPE = 0;
 
 		LEN = 65535;
@@ -1864,6 +2394,7 @@ write the lz77-encoded data, which has lit, len and dist codes, to compressed st
 tree_ll: the tree for lit and len codes.
 tree_d: the tree for distance codes.
 */
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static void writeLZ77data(LodePNGBitWriter* writer, const uivector* lz77_encoded,
 	const HuffmanTree* tree_ll, const HuffmanTree* tree_d) {
 	size_t i = 0;
@@ -1887,6 +2418,70 @@ static void writeLZ77data(LodePNGBitWriter* writer, const uivector* lz77_encoded
 		}
 	}
 }
+#else
+/*
+Same bits as writing the symbols one by one, but they gather in a 64-bit accumulator
+that is stored 4 bytes at a time, and the codes are reversed once per tree instead of per symbol.
+*/
+static void writeLZ77data(LodePNGBitWriter* writer, const uivector* lz77_encoded,
+	const HuffmanTree* tree_ll, const HuffmanTree* tree_d) {
+	uint32_t codes_ll[NUM_DEFLATE_CODE_SYMBOLS];
+	uint32_t codes_d[NUM_DISTANCE_SYMBOLS];
+	ucvector* data = writer->data;
+	uint64_t acc = 0;
+	uint32_t accbits = writer->bp & 7u;
+
+	for (uint32_t i = 0; i != tree_ll->numcodes; ++i) codes_ll[i] = reverseBits(tree_ll->codes[i], tree_ll->lengths[i]);
+	for (uint32_t i = 0; i != tree_d->numcodes; ++i) codes_d[i] = reverseBits(tree_d->codes[i], tree_d->lengths[i]);
+
+	/*a literal takes at most 15 bits, a length/distance group of 4 values at most 48*/
+	if (!ucvector_reserve(data, data->size + lz77_encoded->size * 2u + 16u)) return;
+
+	/*continue the partly filled last byte*/
+	if (accbits) acc = data->data[--data->size];
+	byte* out = data->data + data->size;
+
+	for (size_t i = 0; i != lz77_encoded->size; ++i) {
+		uint32_t val = lz77_encoded->data[i];
+		acc |= (uint64_t)codes_ll[val] << accbits;
+		accbits += tree_ll->lengths[val];
+
+		if (val > 256) /*for a length code, 3 more things have to be added*/ {
+			uint32_t n_length_extra_bits = LENGTHEXTRA[val - FIRST_LENGTH_CODE_INDEX];
+			acc |= (uint64_t)lz77_encoded->data[++i] << accbits;
+			accbits += n_length_extra_bits;
+
+			if (accbits >= 32u) {
+				for (uint32_t b = 0; b != 4; ++b) out[b] = (byte)(acc >> (b * 8u));
+				out += 4;
+				acc >>= 32u;
+				accbits -= 32u;
+			}
+
+			uint32_t distance_code = lz77_encoded->data[++i];
+			acc |= (uint64_t)codes_d[distance_code] << accbits;
+			accbits += tree_d->lengths[distance_code];
+			acc |= (uint64_t)lz77_encoded->data[++i] << accbits;
+			accbits += DISTANCEEXTRA[distance_code];
+		}
+
+		if (accbits >= 32u) {
+			for (uint32_t b = 0; b != 4; ++b) out[b] = (byte)(acc >> (b * 8u));
+			out += 4;
+			acc >>= 32u;
+			accbits -= 32u;
+		}
+	}
+
+	/*only the position inside the last byte matters to the writer*/
+	writer->bp = (byte)(accbits & 7u);
+	for (; accbits > 0; accbits = accbits > 8u ? accbits - 8u : 0u) {
+		*out++ = (byte)acc;
+		acc >>= 8u;
+	}
+	data->size = (size_t)(out - data->data);
+}
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 
 /*Deflate for a block of type "dynamic", that is, with freely, optimally, created huffman trees*/
 static uint32_t deflateDynamic(LodePNGBitWriter* writer, Hash* hash,
@@ -1950,8 +2545,12 @@ static uint32_t deflateDynamic(LodePNGBitWriter* writer, Hash* hash,
 		lodepng_memset(frequencies_cl, 0, NUM_CODE_LENGTH_CODES * sizeof(*frequencies_cl));
 
 		if (settings->use_lz77) {
+#if !IMSD_SOURCE_CODE_MODIFICATION
 			error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings->windowsize,
 				settings->minmatch, settings->nicematch, settings->lazymatching);
+#else
+			error = encodeLZ77Settings(&lz77_encoded, hash, data, datapos, dataend, settings);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 			if (error) break;
 		}
 		else {
@@ -2140,8 +2739,12 @@ static uint32_t deflateFixed(LodePNGBitWriter* writer, Hash* hash,
 		if (settings->use_lz77) /*LZ77 encoded*/ {
 			uivector lz77_encoded;
 			uivector_init(&lz77_encoded);
+#if !IMSD_SOURCE_CODE_MODIFICATION
 			error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings->windowsize,
 				settings->minmatch, settings->nicematch, settings->lazymatching);
+#else
+			error = encodeLZ77Settings(&lz77_encoded, hash, data, datapos, dataend, settings);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 			if (!error) writeLZ77data(writer, &lz77_encoded, &tree_ll, &tree_d);
 			uivector_cleanup(&lz77_encoded);
 		}
@@ -2161,6 +2764,110 @@ static uint32_t deflateFixed(LodePNGBitWriter* writer, Hash* hash,
 	return error;
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*blocks per parallel chunk at least, fewer and the per-chunk hash setup and dictionary priming dominate*/
+static constexpr size_t lodepng_deflate_min_chunk_blocks = 4;
+
+/*
+Feed the window in front of datapos into a fresh hash, as if it had been encoded before.
+The chunk then can reference the previous bytes like a preset dictionary.
+*/
+static void hash_prime(Hash* hash, const byte* in, size_t datapos, uint32_t windowsize) {
+	size_t pos = datapos > windowsize ? datapos - windowsize : 0;
+	uint32_t numzeros = 0;
+
+	for (; pos != datapos; ++pos) {
+		uint32_t hashval = getHash(in, datapos, pos);
+		if (hashval == 0) {
+			if (numzeros == 0) numzeros = countZeros(in, datapos, pos);
+			else if (pos + numzeros > datapos || in[pos + numzeros - 1] != 0) --numzeros;
+		}
+		else {
+			numzeros = 0;
+		}
+		updateHashChain(hash, pos & (windowsize - 1), hashval, numzeros);
+	}
+}
+
+/*
+Deflate [start, end) on its own hash and bit writer. A chunk that is not the last ends with
+an empty stored block (a sync flush), so it stops on a byte boundary and the next one can be appended.
+*/
+static uint32_t deflateChunk(ucvector* out, const byte* in, size_t start, size_t end, size_t blocksize,
+	const LodePNGCompressSettings* settings, uint32_t last) {
+	uint32_t error;
+	Hash hash;
+	LodePNGBitWriter writer;
+
+	LodePNGBitWriter_init(&writer, out);
+
+	error = hash_init(&hash, settings->windowsize);
+	if (!error) hash_prime(&hash, in, start, settings->windowsize);
+
+	for (size_t pos = start; pos < end && !error; pos += blocksize) {
+		size_t blockend = pos + blocksize;
+		if (blockend > end) blockend = end;
+		uint32_t final = last && blockend == end;
+
+		if (settings->btype == 1) error = deflateFixed(&writer, &hash, in, pos, blockend, settings, final);
+		else error = deflateDynamic(&writer, &hash, in, pos, blockend, settings, final);
+	}
+
+	hash_cleanup(&hash);
+
+	if (!error && !last) {
+		writeBits(&writer, 0, 3); /*BFINAL 0, BTYPE 00, the rest of the byte is padding*/
+		size_t size = out->size;
+		if (!ucvector_resize(out, size + 4)) return 83; /*alloc fail*/
+		out->data[size + 0] = 0; out->data[size + 1] = 0; /*LEN*/
+		out->data[size + 2] = 255; out->data[size + 3] = 255; /*NLEN*/
+	}
+
+	return error;
+}
+
+/*
+Split [begin, insize) into runs of whole deflate blocks, one run per thread, and append their streams in order.
+The block boundaries are the same as in the serial encoder, only the hash history before each run is
+limited to the primed window. Unless last is set the stream ends with a sync flush, to be continued.
+*/
+static uint32_t deflateParallel(ucvector* out, const byte* in, size_t begin, size_t insize, size_t blocksize,
+	size_t blocksPerChunk, const LodePNGCompressSettings* settings, uint32_t last) {
+	const size_t chunkSize = blocksize * blocksPerChunk;
+	const size_t chunks = (insize - begin + chunkSize - 1) / chunkSize;
+	std::vector<ucvector> parts(chunks, ucvector(nullptr, 0));
+	std::atomic<uint32_t> error{ 0u };
+
+	CppThreadPool::Instance().RunChunks(chunks, 1, [&](size_t first, size_t end) {
+		for (size_t i = first; i != end && !error; ++i) {
+			const size_t start = begin + i * chunkSize;
+			const size_t stop = start + chunkSize < insize ? start + chunkSize : insize;
+			uint32_t chunkError = deflateChunk(&parts[i], in, start, stop, blocksize, settings, last && i == chunks - 1);
+			if (chunkError) error = chunkError;
+		}
+		});
+
+	if (!error) {
+		size_t total = out->size;
+		for (const ucvector& part : parts) total += part.size;
+
+		if (ucvector_reserve(out, total)) {
+			for (const ucvector& part : parts) {
+				lodepng_memcpy(out->data + out->size, part.data, part.size);
+				out->size += part.size;
+			}
+		}
+		else {
+			error = 83; /*alloc fail*/
+		}
+	}
+
+	for (ucvector& part : parts) lodepng_free(part.data);
+
+	return error;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 static uint32_t lodepng_deflatev(ucvector* out, const byte* in, size_t insize,
 	const LodePNGCompressSettings* settings) {
 	uint32_t error = 0;
@@ -2183,6 +2890,16 @@ static uint32_t lodepng_deflatev(ucvector* out, const byte* in, size_t insize,
 	numdeflateblocks = (insize + blocksize - 1) / blocksize;
 	if (numdeflateblocks == 0) numdeflateblocks = 1;
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+	if (settings->btype == 2) {
+		const size_t threads = CppThreadPool::Instance().GetNumThreads();
+		size_t blocksPerChunk = (numdeflateblocks + threads - 1) / threads;
+		if (blocksPerChunk < lodepng_deflate_min_chunk_blocks) blocksPerChunk = lodepng_deflate_min_chunk_blocks;
+
+		if (blocksPerChunk < numdeflateblocks) return deflateParallel(out, in, 0, insize, blocksize, blocksPerChunk, settings, 1);
+	}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 	error = hash_init(&hash, settings->windowsize);
 
 	if (!error) {
@@ -2232,6 +2949,7 @@ static uint32_t deflate(byte** out, size_t* outsize,
 /* / Adler32                                                                / */
 /* ////////////////////////////////////////////////////////////////////////// */
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static uint32_t update_adler32(uint32_t adler, const byte* data, uint32_t len) {
 	uint32_t s1 = adler & 0xffffu;
 	uint32_t s2 = (adler >> 16u) & 0xffffu;
@@ -2252,10 +2970,145 @@ static uint32_t update_adler32(uint32_t adler, const byte* data, uint32_t len) {
 	return (s2 << 16u) | s1;
 }
 
-/*Return the adler32 of the bytes data[0..len-1]*/
-static inline uint32_t adler32(const byte* data, uint32_t len) {
-	return update_adler32(1u, data, len);
-}
+#else
+static uint32_t update_adler32_scalar(uint32_t adler, const byte* data, uint32_t len) {
+	uint32_t s1 = adler & 0xffffu;
+	uint32_t s2 = (adler >> 16u) & 0xffffu;
+
+	while (len != 0u) {
+		uint32_t i;
+		/*at least 5552 sums can be done before the sums overflow, saving a lot of module divisions*/
+		uint32_t amount = len > 5552u ? 5552u : len;
+		len -= amount;
+		for (i = 0; i != amount; ++i) {
+			s1 += (*data++);
+			s2 += s1;
+		}
+		s1 %= 65521u;
+		s2 %= 65521u;
+	}
+
+	return (s2 << 16u) | s1;
+}
+
+#if LODEPNG_X86_SIMD
+/*
+Both sums of 32-byte blocks at once: s1 gets the byte sums from psadbw,
+s2 gets the bytes weighted 32..1 from pmaddubsw, plus 32 * s1 for every block before it.
+The modulo is only taken every 5552 bytes, where s2 could first overflow.
+*/
+static constexpr uint32_t lodepng_adler32_block = 32u;
+static constexpr uint32_t lodepng_adler32_nmax_blocks = 5552u / lodepng_adler32_block;
+
+LODEPNG_TARGET("ssse3")
+static uint32_t update_adler32_ssse3(uint32_t adler, const byte* data, size_t blocks) {
+	uint32_t s1 = adler & 0xffffu;
+	uint32_t s2 = (adler >> 16u) & 0xffffu;
+
+	const __m128i tapHigh = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+	const __m128i tapLow = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi16(1);
+
+	while (blocks != 0u) {
+		uint32_t n = blocks > lodepng_adler32_nmax_blocks ? lodepng_adler32_nmax_blocks : static_cast<uint32_t>(blocks);
+		blocks -= n;
+
+		__m128i prefix = _mm_cvtsi32_si128(static_cast<int32_t>(s1 * n));
+		__m128i sum1 = zero;
+		__m128i sum2 = _mm_cvtsi32_si128(static_cast<int32_t>(s2));
+
+		for (; n != 0u; --n, data += lodepng_adler32_block) {
+			const __m128i bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+			const __m128i bytes2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16u));
+
+			prefix = _mm_add_epi32(prefix, sum1);
+
+			sum1 = _mm_add_epi32(sum1, _mm_sad_epu8(bytes1, zero));
+			sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tapHigh), ones));
+
+			sum1 = _mm_add_epi32(sum1, _mm_sad_epu8(bytes2, zero));
+			sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tapLow), ones));
+		}
+
+		sum2 = _mm_add_epi32(sum2, _mm_slli_epi32(prefix, 5));
+
+		sum1 = _mm_add_epi32(sum1, _mm_shuffle_epi32(sum1, _MM_SHUFFLE(2, 3, 0, 1)));
+		sum1 = _mm_add_epi32(sum1, _mm_shuffle_epi32(sum1, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum2 = _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, _MM_SHUFFLE(2, 3, 0, 1)));
+		sum2 = _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		s1 = (s1 + static_cast<uint32_t>(_mm_cvtsi128_si32(sum1))) % 65521u;
+		s2 = static_cast<uint32_t>(_mm_cvtsi128_si32(sum2)) % 65521u;
+	}
+
+	return (s2 << 16u) | s1;
+}
+
+LODEPNG_TARGET("avx2")
+static uint32_t update_adler32_avx2(uint32_t adler, const byte* data, size_t blocks) {
+	uint32_t s1 = adler & 0xffffu;
+	uint32_t s2 = (adler >> 16u) & 0xffffu;
+
+	const __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+		16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ones = _mm256_set1_epi16(1);
+
+	while (blocks != 0u) {
+		uint32_t n = blocks > lodepng_adler32_nmax_blocks ? lodepng_adler32_nmax_blocks : static_cast<uint32_t>(blocks);
+		blocks -= n;
+
+		__m256i prefix = _mm256_setr_epi32(static_cast<int32_t>(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+		__m256i sum1 = zero;
+		__m256i sum2 = _mm256_setr_epi32(static_cast<int32_t>(s2), 0, 0, 0, 0, 0, 0, 0);
+
+		for (; n != 0u; --n, data += lodepng_adler32_block) {
+			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+
+			prefix = _mm256_add_epi32(prefix, sum1);
+			sum1 = _mm256_add_epi32(sum1, _mm256_sad_epu8(bytes, zero));
+			sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, tap), ones));
+		}
+
+		sum2 = _mm256_add_epi32(sum2, _mm256_slli_epi32(prefix, 5));
+
+		__m128i low1 = _mm_add_epi32(_mm256_castsi256_si128(sum1), _mm256_extracti128_si256(sum1, 1));
+		__m128i low2 = _mm_add_epi32(_mm256_castsi256_si128(sum2), _mm256_extracti128_si256(sum2, 1));
+
+		low1 = _mm_add_epi32(low1, _mm_shuffle_epi32(low1, _MM_SHUFFLE(2, 3, 0, 1)));
+		low1 = _mm_add_epi32(low1, _mm_shuffle_epi32(low1, _MM_SHUFFLE(1, 0, 3, 2)));
+		low2 = _mm_add_epi32(low2, _mm_shuffle_epi32(low2, _MM_SHUFFLE(2, 3, 0, 1)));
+		low2 = _mm_add_epi32(low2, _mm_shuffle_epi32(low2, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		s1 = (s1 + static_cast<uint32_t>(_mm_cvtsi128_si32(low1))) % 65521u;
+		s2 = static_cast<uint32_t>(_mm_cvtsi128_si32(low2)) % 65521u;
+	}
+
+	return (s2 << 16u) | s1;
+}
+#endif /* LODEPNG_X86_SIMD */
+
+static uint32_t update_adler32(uint32_t adler, const byte* data, uint32_t len) {
+#if LODEPNG_X86_SIMD
+	static const uint32_t level = CpuFeatures::Get().avx2 ? 2u : (CpuFeatures::Get().ssse3 ? 1u : 0u);
+
+	if (level != 0u && len >= lodepng_adler32_block) {
+		const size_t blocks = len / lodepng_adler32_block;
+		adler = (level == 2u) ? update_adler32_avx2(adler, data, blocks) : update_adler32_ssse3(adler, data, blocks);
+		data += blocks * lodepng_adler32_block;
+		len -= static_cast<uint32_t>(blocks * lodepng_adler32_block);
+	}
+#endif /* LODEPNG_X86_SIMD */
+
+	return update_adler32_scalar(adler, data, len);
+}
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
+
+/*Return the adler32 of the bytes data[0..len-1]*/
+static inline uint32_t adler32(const byte* data, uint32_t len) {
+	return update_adler32(1u, data, len);
+}
 
 /* ////////////////////////////////////////////////////////////////////////// */
 /* / Zlib                                                                   / */
@@ -2263,10 +3116,58 @@ static inline uint32_t adler32(const byte* data, uint32_t len) {
 
 #ifdef LODEPNG_COMPILE_DECODER
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*sits between inflate and the caller's sink to checksum the data on its way out*/
+struct ZlibStream {
+	InflateStream* outer;
+	uint32_t adler;
+};
+
+static uint32_t zlibStreamSink(const byte* data, size_t size, void* context) {
+	ZlibStream* zlib = (ZlibStream*)context;
+	zlib->adler = update_adler32(zlib->adler, data, (uint32_t)size);
+	return zlib->outer->sink(data, size, zlib->outer->context);
+}
+
+/*check the two zlib header bytes*/
+static uint32_t zlibHeaderCheck(const byte* in) {
+	if ((in[0] * 256 + in[1]) % 31 != 0) {
+		/*error: 256 * in[0] + in[1] must be a multiple of 31, the FCHECK value is supposed to be made that way*/
+		return 24;
+	}
+	/*only compression method 8: inflate with sliding window of 32k is supported by the PNG spec*/
+	if ((in[0] & 15) != 8 || ((in[0] >> 4) & 15) > 7) return 25;
+	/*the specification of PNG says about the zlib stream: "The additional flags shall not specify a preset dictionary."*/
+	if ((in[1] >> 5) & 1) return 26;
+	return 0;
+}
+
+/*one buffer with the bytes of all segments, for the custom decoders that take contiguous input only*/
+static byte* inflateChainJoin(const InflateSegment* segments, size_t count, size_t* size) {
+	byte* joined;
+	*size = 0;
+	for (size_t i = 0; i != count; ++i) *size += segments[i].size;
+	joined = (byte*)lodepng_malloc(*size ? *size : 1u);
+	if (!joined) return 0;
+	for (size_t i = 0, pos = 0; i != count; pos += segments[i].size, ++i) {
+		lodepng_memcpy(joined + pos, (unknown_pointer)segments[i].data, segments[i].size);
+	}
+	return joined;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static uint32_t lodepng_zlib_decompressv(ucvector* out,
 	const byte* in, size_t insize,
 	const LodePNGDecompressSettings* settings) {
+#else
+/*with a stream, out only holds the last window when this returns, the data went to stream->sink*/
+static uint32_t lodepng_zlib_decompressv(ucvector* out,
+	const byte* in, size_t insize,
+	const LodePNGDecompressSettings* settings, InflateStream* stream = 0) {
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	uint32_t error = 0;
+#if !IMSD_SOURCE_CODE_MODIFICATION
 	uint32_t CM, CINFO, FDICT;
 
 	if (insize < 2) return 53; /*error, size of zlib data too small*/
@@ -2300,10 +3201,80 @@ static uint32_t lodepng_zlib_decompressv(ucvector* out,
 		uint32_t checksum = adler32(out->data, (uint32_t)(out->size));
 		if (checksum != ADLER32) return 58; /*error, adler checksum not correct, data must be corrupted*/
 	}
+#else
+	if (insize < 2) return 53; /*error, size of zlib data too small*/
+	error = zlibHeaderCheck(in);
+	if (error) return error;
+
+	if (stream) {
+		ZlibStream zlib = { stream, 1u };
+		InflateStream inner = { zlibStreamSink, &zlib, 0 };
+
+		error = inflatev(out, in + 2, insize - 2, settings, &inner);
+		if (!error) error = inflateStreamFlush(out, &inner, 0);
+		if (error) return error;
+
+		if (!settings->ignore_adler32 && lodepng_read32bitInt(&in[insize - 4]) != zlib.adler) return 58; /*error, adler checksum not correct*/
+		return 0;
+	}
+
+	error = inflatev(out, in + 2, insize - 2, settings);
+	if (error) return error;
+
+	if (!settings->ignore_adler32) {
+		uint32_t ADLER32 = lodepng_read32bitInt(&in[insize - 4]);
+		uint32_t checksum = adler32(out->data, (uint32_t)(out->size));
+		if (checksum != ADLER32) return 58; /*error, adler checksum not correct, data must be corrupted*/
+	}
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 
 	return 0; /*no error*/
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*lodepng_zlib_decompressv on a stream split into segments, inflated from where they lie*/
+static uint32_t zlibDecompressChain(ucvector* out, const InflateSegment* segments, size_t count,
+	const LodePNGDecompressSettings* settings, InflateStream* stream = 0) {
+	uint32_t error;
+	InflateChain chain;
+	LodePNGBitReader reader;
+	byte bytes[4];
+
+	if (count <= 1) return lodepng_zlib_decompressv(out, count ? segments[0].data : 0, count ? segments[0].size : 0, settings, stream);
+	if (settings->custom_inflate) {
+		size_t size;
+		byte* joined = inflateChainJoin(segments, count, &size);
+		if (!joined) return 83; /*alloc fail*/
+		error = lodepng_zlib_decompressv(out, joined, size, settings, stream);
+		lodepng_free(joined);
+		return error;
+	}
+
+	inflateChainInit(&chain, segments, count);
+	if (chain.total < 2) return 53; /*error, size of zlib data too small*/
+	inflateChainCopy(&chain, 0, bytes, 2);
+	error = zlibHeaderCheck(bytes);
+	if (error) return error;
+
+	error = LodePNGBitReader_init(&reader, 0, chain.total);
+	if (error) return error;
+	reader.chain = &chain;
+	inflateChainView(&reader, 2, 0);
+
+	ZlibStream zlib = { stream, 1u };
+	InflateStream inner = { zlibStreamSink, &zlib, 0 };
+	error = inflateReader(out, reader, settings, stream ? &inner : 0);
+	if (!error && stream) error = inflateStreamFlush(out, &inner, 0);
+	if (error) return error;
+
+	if (!settings->ignore_adler32) {
+		uint32_t checksum = stream ? zlib.adler : adler32(out->data, (uint32_t)(out->size));
+		inflateChainCopy(&chain, chain.total - 4, bytes, 4);
+		if (lodepng_read32bitInt(bytes) != checksum) return 58; /*error, adler checksum not correct, data must be corrupted*/
+	}
+	return 0; /*no error*/
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 
 uint32_t lodepng_zlib_decompress(byte** out, size_t* outsize,
 	const byte* in, size_t insize,
@@ -2343,10 +3314,84 @@ static uint32_t zlib_decompress(byte** out, size_t* outsize, size_t expected_siz
 	return error;
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*zlib_decompress on a stream split into segments, a custom zlib gets them joined*/
+static uint32_t zlib_decompress(byte** out, size_t* outsize, size_t expected_size,
+	const InflateSegment* segments, size_t count, const LodePNGDecompressSettings* settings) {
+	uint32_t error;
+	if (count <= 1) return zlib_decompress(out, outsize, expected_size, count ? segments[0].data : 0, count ? segments[0].size : 0, settings);
+	if (settings->custom_zlib) {
+		size_t size;
+		byte* joined = inflateChainJoin(segments, count, &size);
+		if (!joined) return 83; /*alloc fail*/
+		error = zlib_decompress(out, outsize, expected_size, joined, size, settings);
+		lodepng_free(joined);
+	}
+	else {
+		ucvector v(*out, *outsize);
+		if (expected_size) {
+			/*reserve the memory to avoid intermediate reallocations*/
+			ucvector_resize(&v, *outsize + expected_size);
+			v.size = *outsize;
+		}
+		error = zlibDecompressChain(&v, segments, count, settings);
+		*out = v.data;
+		*outsize = v.size;
+	}
+	return error;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 #ifdef LODEPNG_COMPILE_ENCODER
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*bytes per adler32 task*/
+static constexpr size_t lodepng_adler32_chunk = 1u << 20u;
+
+/*the adler32 of A followed by B, from the adler32 of both and the length of B*/
+static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) {
+	const uint32_t base = 65521u;
+	const uint32_t rem = (uint32_t)(len2 % base);
+	uint32_t sum1 = adler1 & 0xffffu;
+	uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % base);
+
+	sum1 += (adler2 & 0xffffu) + base - 1u;
+	sum2 += ((adler1 >> 16u) & 0xffffu) + ((adler2 >> 16u) & 0xffffu) + base - rem;
+	if (sum1 >= base) sum1 -= base;
+	if (sum1 >= base) sum1 -= base;
+	if (sum2 >= (base << 1u)) sum2 -= (base << 1u);
+	if (sum2 >= base) sum2 -= base;
+
+	return (sum2 << 16u) | sum1;
+}
+
+/*adler32 of the chunks on the thread pool, folded together in order*/
+static uint32_t adler32_parallel(const byte* data, size_t len) {
+	const size_t chunks = (len + lodepng_adler32_chunk - 1) / lodepng_adler32_chunk;
+	if (chunks < 2 || CppThreadPool::Instance().GetNumThreads() < 2) return adler32(data, (uint32_t)len);
+
+	std::vector<uint32_t> sums(chunks);
+
+	CppThreadPool::Instance().RunChunks(chunks, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i != end; ++i) {
+			const size_t start = i * lodepng_adler32_chunk;
+			const size_t size = start + lodepng_adler32_chunk < len ? lodepng_adler32_chunk : len - start;
+			sums[i] = adler32(data + start, (uint32_t)size);
+		}
+		});
+
+	uint32_t adler = sums[0];
+	for (size_t i = 1; i != chunks; ++i) {
+		const size_t start = i * lodepng_adler32_chunk;
+		adler = adler32_combine(adler, sums[i], start + lodepng_adler32_chunk < len ? lodepng_adler32_chunk : len - start);
+	}
+
+	return adler;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 uint32_t lodepng_zlib_compress(byte** out, size_t* outsize,
 	const byte* in, size_t insize,
 	const LodePNGCompressSettings* settings) 
@@ -2367,7 +3412,11 @@ uint32_t lodepng_zlib_compress(byte** out, size_t* outsize,
 	}
 
 	if (!error) {
+#if !IMSD_SOURCE_CODE_MODIFICATION
 		uint32_t ADLER32 = adler32(in, (uint32_t)insize);
+#else
+		uint32_t ADLER32 = adler32_parallel(in, insize);
+#endif
 		/*zlib data: 1 byte CMF (CM+CINFO), 1 byte FLG, deflate data, 4 byte ADLER32 checksum of the Decompressed data*/
 		uint32_t CMF = 120; /*0b01111000: CM 8, CINFO 7. With CINFO 7, any window size up to 32768 can be used.*/
 		uint32_t FLEVEL = 0;
@@ -2436,13 +3485,21 @@ void lodepng_compress_settings_init(LodePNGCompressSettings* settings) {
 	settings->minmatch = 3;
 	settings->nicematch = 128;
 	settings->lazymatching = 1;
+#if IMSD_SOURCE_CODE_MODIFICATION
+	settings->maxchainlength = 0;
+	settings->rle = 0;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 
 	settings->custom_zlib = 0;
 	settings->custom_deflate = 0;
 	settings->custom_context = nullptr;
 }
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 const LodePNGCompressSettings lodepng_default_compress_settings = { 2, 1, DEFAULT_WINDOWSIZE, 3, 128, 1, 0, 0, 0 };
+#else
+const LodePNGCompressSettings lodepng_default_compress_settings = { 2, 1, DEFAULT_WINDOWSIZE, 3, 128, 1, 0, 0, 0, 0, 0 };
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 
 
 #endif /*LODEPNG_COMPILE_ENCODER*/
@@ -2477,6 +3534,7 @@ const LodePNGDecompressSettings lodepng_default_decompress_settings = { 0, 0, 0,
 
 
 #ifndef LODEPNG_NO_COMPILE_CRC
+#if !IMSD_SOURCE_CODE_MODIFICATION
 /* CRC polynomial: 0xedb88320 */
 static uint32_t lodepng_crc32_table[256] = {
 		   0u, 1996959894u, 3993919788u, 2567524794u,  124634137u, 1886057615u, 3915621685u, 2657392035u,
@@ -2523,6 +3581,162 @@ uint32_t lodepng_crc32(const byte* data, size_t length)
 	}
 	return r ^ 0xffffffffu;
 }
+#else
+/*table k advances a byte through k more zero bytes, so eight bytes are folded with eight lookups*/
+struct LodePNGCrc32Slices {
+	uint32_t table[8][256];
+};
+
+static constexpr LodePNGCrc32Slices lodepng_crc32_make_slices() {
+	LodePNGCrc32Slices slices{};
+
+	for (uint32_t n = 0u; n < 256u; ++n) {
+		uint32_t c = n;
+		for (uint32_t bit = 0u; bit < 8u; ++bit) c = (c & 1u) ? (0xedb88320u ^ (c >> 1u)) : (c >> 1u);
+		slices.table[0][n] = c;
+	}
+
+	for (uint32_t k = 1u; k < 8u; ++k) {
+		for (uint32_t n = 0u; n < 256u; ++n) {
+			const uint32_t previous = slices.table[k - 1u][n];
+			slices.table[k][n] = (previous >> 8u) ^ slices.table[0][previous & 0xffu];
+		}
+	}
+	return slices;
+}
+
+static constexpr LodePNGCrc32Slices lodepng_crc32_slices = lodepng_crc32_make_slices();
+
+/*r is the running register, not inverted*/
+static uint32_t lodepng_crc32_slice8(uint32_t r, const byte* data, size_t length) {
+	const auto& t = lodepng_crc32_slices.table;
+
+	for (; length >= 8u; length -= 8u, data += 8u) {
+		uint32_t low, high;
+		std::memcpy(&low, data, 4u);
+		std::memcpy(&high, data + 4u, 4u);
+		low ^= r;
+
+		r = t[7][low & 0xffu] ^ t[6][(low >> 8u) & 0xffu] ^ t[5][(low >> 16u) & 0xffu] ^ t[4][low >> 24u] ^
+			t[3][high & 0xffu] ^ t[2][(high >> 8u) & 0xffu] ^ t[1][(high >> 16u) & 0xffu] ^ t[0][high >> 24u];
+	}
+
+	for (; length > 0u; --length, ++data) {
+		r = t[0][(r ^ *data) & 0xffu] ^ (r >> 8u);
+	}
+	return r;
+}
+
+#if LODEPNG_X86_SIMD
+/*
+Folds four 128-bit lanes with carry-less multiplies, then Barrett-reduces to 32 bits
+(Gopal et al., "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ").
+length must be at least 64 and a multiple of 16, r is the running register like above.
+*/
+LODEPNG_TARGET("pclmul,sse4.1")
+static uint32_t lodepng_crc32_pclmul(uint32_t r, const byte* data, size_t length) {
+	alignas(16) static const uint64_t k1k2[2] = { 0x0154442bd4u, 0x01c6e41596u };
+	alignas(16) static const uint64_t k3k4[2] = { 0x01751997d0u, 0x00ccaa009eu };
+	alignas(16) static const uint64_t k5k0[2] = { 0x0163cd6124u, 0x0000000000u };
+	alignas(16) static const uint64_t poly[2] = { 0x01db710641u, 0x01f7011641u };
+
+	__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00u));
+	__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10u));
+	__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20u));
+	__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30u));
+	__m128i x0, x5, x6, x7, x8;
+
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int32_t>(r)));
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+	data += 64u;
+	length -= 64u;
+
+	/*four independent folds per 64 bytes*/
+	for (; length >= 64u; length -= 64u, data += 64u) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00u)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10u)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20u)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30u)));
+	}
+
+	/*fold the four lanes into one*/
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	for (; length >= 16u; length -= 16u, data += 16u) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data))), x5);
+	}
+
+	/*128 to 64 bits*/
+	const __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/*Barrett reduction to 32 bits*/
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+#endif /* LODEPNG_X86_SIMD */
+
+/*Return the CRC of the bytes buf[0..len-1].*/
+uint32_t lodepng_crc32(const byte* data, size_t length)
+{
+	uint32_t r = 0xff'ff'ff'ffu;
+
+#if LODEPNG_X86_SIMD
+	static const bool pclmul = CpuFeatures::Get().pclmul && CpuFeatures::Get().sse41;
+
+	/*chunk headers and small chunks are not worth the setup*/
+	if (pclmul && length >= 64u) {
+		const size_t folded = length & ~static_cast<size_t>(15u);
+		r = lodepng_crc32_pclmul(r, data, folded);
+		data += folded;
+		length -= folded;
+	}
+#endif /* LODEPNG_X86_SIMD */
+
+	r = lodepng_crc32_slice8(r, data, length);
+	return r ^ 0xffffffffu;
+}
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 #else /* !LODEPNG_NO_COMPILE_CRC */
 uint32_t lodepng_crc32(const byte* data, size_t length);
 #endif /* !LODEPNG_NO_COMPILE_CRC */
@@ -3221,6 +4435,7 @@ static void addColorBits(byte* out, size_t index, uint32_t bits, uint32_t in) {
 	if (p == 0) out[index * bits / 8u] = in;
 	else out[index * bits / 8u] |= in;
 }
+#if !IMSD_SOURCE_CODE_MODIFICATION
 /*
 One node of a color tree
 This is the data structure used to count the number of unique colors and to get a palette
@@ -3283,6 +4498,67 @@ static uint32_t color_tree_add(ColorTree* tree,
 	tree->index = (int32_t)index;
 	return 0;
 }
+#else
+/*
+Set of up to 257 RGBA colors with their palette index, used to count the colors of an image and to find
+the palette index of a color. Open addressing in one fixed block, no allocation per color like the
+16-ary trie it replaces. The color_tree names are kept for the callers.
+*/
+#define COLOR_TREE_SLOTS 1024u /*more than twice the 257 colors that are ever added*/
+
+struct ColorTree
+{
+	uint32_t keys[COLOR_TREE_SLOTS]; /*RGBA packed, R in the low byte*/
+	int32_t index[COLOR_TREE_SLOTS]; /*the payload, -1 for an empty slot*/
+};
+
+static LODEPNG_INLINE uint32_t color_tree_key(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	return (uint32_t)r | ((uint32_t)g << 8u) | ((uint32_t)b << 16u) | ((uint32_t)a << 24u);
+}
+
+/*first slot to probe, the multiplicative hash spreads the top bits over the table*/
+static LODEPNG_INLINE uint32_t color_tree_slot(uint32_t key) {
+	return (key * 2654435761u) >> 22u;
+}
+
+static void color_tree_init(ColorTree* tree) {
+	lodepng_memset(tree->index, 0xff, sizeof(tree->index));
+}
+
+static void color_tree_cleanup(ColorTree* tree) {
+	(void)tree; /*nothing allocated*/
+}
+
+/*returns -1 if color not present, its index otherwise*/
+static int32_t color_tree_get(ColorTree* tree, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	const uint32_t key = color_tree_key(r, g, b, a);
+	for (uint32_t slot = color_tree_slot(key);; slot = (slot + 1u) & (COLOR_TREE_SLOTS - 1u)) {
+		if (tree->index[slot] < 0) return -1;
+		if (tree->keys[slot] == key) return tree->index[slot];
+	}
+}
+
+#ifdef LODEPNG_COMPILE_ENCODER
+static int32_t color_tree_has(ColorTree* tree, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	return color_tree_get(tree, r, g, b, a) >= 0;
+}
+#endif /*LODEPNG_COMPILE_ENCODER*/
+
+/*Index should be >= 0 (it's signed to be compatible with using -1 for "doesn't exist").
+Adding a color again replaces its index, like the trie did for duplicate palette entries.
+Returns error code, or 0 if ok*/
+static uint32_t color_tree_add(ColorTree* tree,
+	uint8_t r, uint8_t g, uint8_t b, uint8_t a, uint32_t index) {
+	const uint32_t key = color_tree_key(r, g, b, a);
+	uint32_t slot = color_tree_slot(key);
+	for (uint32_t probes = 0; tree->index[slot] >= 0 && tree->keys[slot] != key; slot = (slot + 1u) & (COLOR_TREE_SLOTS - 1u)) {
+		if (++probes == COLOR_TREE_SLOTS) return 83; /*full, callers stop at 257 colors*/
+	}
+	tree->keys[slot] = key;
+	tree->index[slot] = (int32_t)index;
+	return 0;
+}
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 
 /*put a pixel, given its RGBA color, into image of any color type*/
 static uint32_t rgba8ToPixel(byte* out, size_t i,
@@ -4420,29 +5696,217 @@ static uint32_t unfilterScanline(byte* recon, const byte* scanline, const byte*
 	return 0;
 }
 
-static uint32_t unfilter(byte* out, const byte* in, uint32_t w, uint32_t h, uint32_t bpp) {
-	/*
-	For PNG filter method 0
-	this function unfilters a single image (e.g. without interlacing this is called once, with Adam7 seven times)
-	out must have enough bytes allocated already, in must have the scanlines + 1 filtertype byte per scanline
-	w and h are image dimensions or dimensions of reduced image, bpp is bits per pixel
-	in and out are allowed to be the same memory address (but aren't the same size since in has the extra filter bytes)
-	*/
+#if IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD
+/*
+Row kernels for whole-byte pixels, picked once per image by unfilter.
+Sub, Average and Paeth depend on the pixel to the left, so they step one pixel of bpp bytes at a time,
+but do all channels of that pixel at once. Up has no such dependency and runs over full registers.
+The pixel left of the first one and its upper neighbour count as 0, which reproduces the scalar first-pixel rules.
+*/
+typedef void (*LodePNGUnfilterRow)(byte* recon, const byte* scanline, const byte* precon, size_t length);
 
-	uint32_t y;
+struct LodePNGUnfilterKernels {
+	LodePNGUnfilterRow sub;
+	LodePNGUnfilterRow up;
+	LodePNGUnfilterRow average;
+	LodePNGUnfilterRow paeth;
+};
+
+/*pixels are moved through general registers, a partial copy through memory would stall the store forwarding*/
+template<size_t bpp>
+LODEPNG_TARGET("sse4.1")
+static inline __m128i unfilterLoadPixel(const byte* data) {
+	if constexpr (bpp == 8) {
+		return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+	}
+	else if constexpr (bpp == 6) {
+		uint32_t low;
+		uint16_t high;
+		std::memcpy(&low, data, 4u);
+		std::memcpy(&high, data + 4u, 2u);
+		return _mm_insert_epi16(_mm_cvtsi32_si128(static_cast<int32_t>(low)), high, 2);
+	}
+	else if constexpr (bpp == 4) {
+		uint32_t value;
+		std::memcpy(&value, data, 4u);
+		return _mm_cvtsi32_si128(static_cast<int32_t>(value));
+	}
+	else {
+		uint16_t low;
+		std::memcpy(&low, data, 2u);
+		return _mm_cvtsi32_si128(static_cast<int32_t>(low | (static_cast<uint32_t>(data[2]) << 16u)));
+	}
+}
+
+template<size_t bpp>
+LODEPNG_TARGET("sse4.1")
+static inline void unfilterStorePixel(byte* data, const __m128i& pixel) {
+	if constexpr (bpp == 8) {
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(data), pixel);
+	}
+	else if constexpr (bpp == 6) {
+		const uint32_t low = static_cast<uint32_t>(_mm_cvtsi128_si32(pixel));
+		const uint16_t high = static_cast<uint16_t>(_mm_extract_epi16(pixel, 2));
+		std::memcpy(data, &low, 4u);
+		std::memcpy(data + 4u, &high, 2u);
+	}
+	else if constexpr (bpp == 4) {
+		const uint32_t value = static_cast<uint32_t>(_mm_cvtsi128_si32(pixel));
+		std::memcpy(data, &value, 4u);
+	}
+	else {
+		const uint32_t value = static_cast<uint32_t>(_mm_cvtsi128_si32(pixel));
+		std::memcpy(data, &value, 2u);
+		data[2] = static_cast<byte>(value >> 16u);
+	}
+}
+
+template<size_t bpp>
+LODEPNG_TARGET("sse4.1")
+static void unfilterSubSSE41(byte* recon, const byte* scanline, const byte*, size_t length) {
+	__m128i a = _mm_setzero_si128();
+
+	for (size_t i = 0; i != length; i += bpp) {
+		a = _mm_add_epi8(unfilterLoadPixel<bpp>(scanline + i), a);
+		unfilterStorePixel<bpp>(recon + i, a);
+	}
+}
+
+template<size_t bpp>
+LODEPNG_TARGET("sse4.1")
+static void unfilterAverageSSE41(byte* recon, const byte* scanline, const byte* precon, size_t length) {
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i a = _mm_setzero_si128();
+
+	for (size_t i = 0; i != length; i += bpp) {
+		const __m128i b = unfilterLoadPixel<bpp>(precon + i);
+		/*pavgb rounds up, taking the lost low bit back gives the floor*/
+		const __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+
+		a = _mm_add_epi8(unfilterLoadPixel<bpp>(scanline + i), average);
+		unfilterStorePixel<bpp>(recon + i, a);
+	}
+}
+
+template<size_t bpp>
+LODEPNG_TARGET("sse4.1")
+static void unfilterPaethSSE41(byte* recon, const byte* scanline, const byte* precon, size_t length) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a = zero;
+	__m128i c = zero;
+
+	for (size_t i = 0; i != length; i += bpp) {
+		const __m128i b = _mm_unpacklo_epi8(unfilterLoadPixel<bpp>(precon + i), zero);
+
+		const __m128i pa = _mm_abs_epi16(_mm_sub_epi16(b, c));
+		const __m128i pb = _mm_abs_epi16(_mm_sub_epi16(a, c));
+		const __m128i pc = _mm_abs_epi16(_mm_sub_epi16(_mm_add_epi16(a, b), _mm_add_epi16(c, c)));
+		const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+		/*a wins ties, then b, like paethPredictor*/
+		__m128i predictor = _mm_blendv_epi8(c, b, _mm_cmpeq_epi16(smallest, pb));
+		predictor = _mm_blendv_epi8(predictor, a, _mm_cmpeq_epi16(smallest, pa));
+
+		const __m128i x = _mm_unpacklo_epi8(unfilterLoadPixel<bpp>(scanline + i), zero);
+		a = _mm_and_si128(_mm_add_epi16(x, predictor), _mm_set1_epi16(0xff));
+		c = b;
+
+		unfilterStorePixel<bpp>(recon + i, _mm_packus_epi16(a, a));
+	}
+}
+
+LODEPNG_TARGET("sse2")
+static void unfilterUpSSE2(byte* recon, const byte* scanline, const byte* precon, size_t length) {
+	size_t i = 0;
+	for (; i + 16u <= length; i += 16u) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scanline + i));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(precon + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(recon + i), _mm_add_epi8(x, b));
+	}
+	for (; i != length; ++i) recon[i] = scanline[i] + precon[i];
+}
+
+LODEPNG_TARGET("avx2")
+static void unfilterUpAVX2(byte* recon, const byte* scanline, const byte* precon, size_t length) {
+	size_t i = 0;
+	for (; i + 32u <= length; i += 32u) {
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scanline + i));
+		const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(precon + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(recon + i), _mm256_add_epi8(x, b));
+	}
+	for (; i != length; ++i) recon[i] = scanline[i] + precon[i];
+}
+
+template<size_t bpp>
+static LodePNGUnfilterKernels unfilterKernelsSSE41(LodePNGUnfilterRow up) {
+	return LodePNGUnfilterKernels{ &unfilterSubSSE41<bpp>, up, &unfilterAverageSSE41<bpp>, &unfilterPaethSSE41<bpp> };
+}
+
+/*returns 0 if the scalar code should run, for bytewidth other than 3, 4, 6 and 8 or without SSE4.1*/
+static const LodePNGUnfilterKernels* unfilterKernels(size_t bytewidth) {
+	static const bool sse41 = CpuFeatures::Get().sse41 && CpuFeatures::Get().ssse3;
+	static const LodePNGUnfilterRow up = CpuFeatures::Get().avx2 ? &unfilterUpAVX2 : &unfilterUpSSE2;
+	static const LodePNGUnfilterKernels kernels3 = unfilterKernelsSSE41<3>(up);
+	static const LodePNGUnfilterKernels kernels4 = unfilterKernelsSSE41<4>(up);
+	static const LodePNGUnfilterKernels kernels6 = unfilterKernelsSSE41<6>(up);
+	static const LodePNGUnfilterKernels kernels8 = unfilterKernelsSSE41<8>(up);
+
+	if (!sse41) return 0;
+
+	switch (bytewidth) {
+	case 3: return &kernels3;
+	case 4: return &kernels4;
+	case 6: return &kernels6;
+	case 8: return &kernels8;
+	default: return 0;
+	}
+}
+
+static uint32_t unfilterScanlineKernels(const LodePNGUnfilterKernels* kernels, byte* recon, const byte* scanline, const byte* precon,
+	size_t bytewidth, byte filterType, size_t length) {
+	if (kernels) {
+		switch (filterType) {
+		case 1: kernels->sub(recon, scanline, precon, length); return 0;
+		case 2: if (precon) { kernels->up(recon, scanline, precon, length); return 0; } break;
+		case 3: if (precon) { kernels->average(recon, scanline, precon, length); return 0; } break;
+		case 4: if (precon) { kernels->paeth(recon, scanline, precon, length); return 0; } break;
+		default: break;
+		}
+	}
+	return unfilterScanline(recon, scanline, precon, bytewidth, filterType, length);
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD */
+
+static uint32_t unfilter(byte* out, const byte* in, uint32_t w, uint32_t h, uint32_t bpp) {
+	/*
+	For PNG filter method 0
+	this function unfilters a single image (e.g. without interlacing this is called once, with Adam7 seven times)
+	out must have enough bytes allocated already, in must have the scanlines + 1 filtertype byte per scanline
+	w and h are image dimensions or dimensions of reduced image, bpp is bits per pixel
+	in and out are allowed to be the same memory address (but aren't the same size since in has the extra filter bytes)
+	*/
+
+	uint32_t y;
 	byte* prevline = 0;
 
 	/*bytewidth is used for filtering, is 1 when bpp < 8, number of bytes per pixel otherwise*/
 	size_t bytewidth = (bpp + 7u) / 8u;
 	/*the width of a scanline in bytes, not including the filter type*/
 	size_t linebytes = lodepng_get_raw_size_idat(w, 1, bpp) - 1u;
+#if IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD
+	const LodePNGUnfilterKernels* kernels = unfilterKernels(bytewidth);
+#endif
 
 	for (y = 0; y < h; ++y) {
 		size_t outindex = linebytes * y;
 		size_t inindex = (1 + linebytes) * y; /*the extra filterbyte added to each row*/
 		byte filterType = in[inindex];
 
+#if IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD
+		CERROR_TRY_RETURN(unfilterScanlineKernels(kernels, &out[outindex], &in[inindex + 1], prevline, bytewidth, filterType, linebytes));
+#else
 		CERROR_TRY_RETURN(unfilterScanline(&out[outindex], &in[inindex + 1], prevline, bytewidth, filterType, linebytes));
+#endif
 
 		prevline = &out[outindex];
 	}
@@ -5000,12 +6464,174 @@ uint32_t lodepng_inspect_chunk(LodePNGState* state, size_t pos,
 }
 
 /*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*
+State of lodepng_decode_rows. The inflated bytes are cut into scanlines, each is unfiltered against
+the one before and converted into the band, which goes to the callback once it is full.
+*/
+struct RowDecoder {
+	LodePNGRowCallback callback;
+	void* context;
+	uint32_t bandrows;
+
+	const LodePNGState* state;
+	uint32_t w, h;
+	uint32_t y; /*scanlines unfiltered so far*/
+	uint32_t convert;
+	size_t bytewidth, linebytes, rawlinebytes;
+#if LODEPNG_X86_SIMD
+	const LodePNGUnfilterKernels* kernels;
+#endif
+
+	byte* line; /*a scanline split between two inflate outputs, filter type byte first*/
+	size_t linesize; /*bytes of line gathered*/
+	byte* prev; /*the unfiltered scanline above, when it is not in the band*/
+	byte* cur; /*the unfiltered scanline before its conversion*/
+	const byte* precon;
+	byte* band;
+	uint32_t bandcount;
+};
+
+static uint32_t rowDecoderLine(RowDecoder* rows, const byte* scanline) {
+	uint32_t error;
+	byte* bandline = rows->band + rows->bandcount * rows->rawlinebytes;
+	/*without conversion the scanline is unfiltered straight into the band*/
+	byte* recon = rows->convert ? rows->cur : bandline;
+
+#if LODEPNG_X86_SIMD
+	error = unfilterScanlineKernels(rows->kernels, recon, scanline + 1, rows->precon, rows->bytewidth, scanline[0], rows->linebytes);
+#else
+	error = unfilterScanline(recon, scanline + 1, rows->precon, rows->bytewidth, scanline[0], rows->linebytes);
+#endif
+	if (error) return error;
+
+	if (rows->convert) {
+		error = lodepng_convert(bandline, recon, &rows->state->info_raw, &rows->state->info_png.color, rows->w, 1);
+		if (error) return error;
+		rows->cur = rows->prev;
+		rows->prev = recon;
+	}
+	rows->precon = recon;
+
+	++rows->y;
+	if (++rows->bandcount == rows->bandrows || rows->y == rows->h) {
+		if (rows->callback(rows->band, rows->y - rows->bandcount, rows->bandcount, rows->context)) return 116;
+		rows->bandcount = 0;
+
+		/*the band gets overwritten, keep the scanline the next one is unfiltered against*/
+		if (!rows->convert) {
+			lodepng_memcpy(rows->prev, (unknown_pointer)rows->precon, rows->linebytes);
+			rows->precon = rows->prev;
+		}
+	}
+	return 0;
+}
+
+static uint32_t rowDecoderSink(const byte* data, size_t size, void* context) {
+	RowDecoder* rows = (RowDecoder*)context;
+	const size_t scanlinebytes = rows->linebytes + 1u;
+
+	while (size) {
+		const byte* scanline = data;
+		if (rows->y == rows->h) return 91; /*more data than the image has scanlines*/
+
+		if (rows->linesize == 0 && size >= scanlinebytes) {
+			/*whole scanlines are unfiltered where they lie in the inflate buffer*/
+			data += scanlinebytes;
+			size -= scanlinebytes;
+		}
+		else {
+			size_t take = scanlinebytes - rows->linesize;
+			if (take > size) take = size;
+			lodepng_memcpy(rows->line + rows->linesize, (unknown_pointer)data, take);
+			rows->linesize += take;
+			data += take;
+			size -= take;
+			if (rows->linesize != scanlinebytes) break;
+			rows->linesize = 0;
+			scanline = rows->line;
+		}
+
+		uint32_t error = rowDecoderLine(rows, scanline);
+		if (error) return error;
+	}
+	return 0;
+}
+
+static uint32_t rowDecoderRun(RowDecoder* rows, const LodePNGState* state, uint32_t w, uint32_t h,
+	const InflateSegment* idat, size_t idatcount) {
+	uint32_t error = 0;
+	uint32_t bpp = lodepng_get_bpp(&state->info_png.color);
+
+	rows->state = state;
+	rows->w = w;
+	rows->h = h;
+	rows->y = 0;
+	rows->convert = state->decoder.color_convert && !lodepng_color_mode_equal(&state->info_raw, &state->info_png.color);
+	rows->bytewidth = (bpp + 7u) / 8u;
+	rows->linebytes = lodepng_get_raw_size_idat(w, 1, bpp) - 1u;
+	rows->rawlinebytes = rows->convert ? lodepng_get_raw_size(w, 1, &state->info_raw) : rows->linebytes;
+#if LODEPNG_X86_SIMD
+	rows->kernels = unfilterKernels(rows->bytewidth);
+#endif
+	rows->linesize = 0;
+	rows->precon = 0;
+	rows->bandcount = 0;
+	if (rows->bandrows > h) rows->bandrows = h;
+
+	rows->line = (byte*)lodepng_malloc(rows->linebytes + 1u);
+	rows->prev = (byte*)lodepng_malloc(rows->linebytes);
+	rows->cur = (byte*)lodepng_malloc(rows->linebytes);
+	rows->band = (byte*)lodepng_malloc(rows->bandrows * rows->rawlinebytes);
+	if (!rows->line || !rows->prev || !rows->cur || !rows->band) error = 83; /*alloc fail*/
+
+	if (!error) {
+		if (state->decoder.zlibsettings.custom_zlib) {
+			/*a custom zlib only works on the whole stream*/
+			byte* scanlines = 0;
+			size_t scanlines_size = 0;
+			error = zlib_decompress(&scanlines, &scanlines_size, 0, idat, idatcount, &state->decoder.zlibsettings);
+			if (!error) error = rowDecoderSink(scanlines, scanlines_size, rows);
+			lodepng_free(scanlines);
+		}
+		else {
+			ucvector window(nullptr, 0);
+			InflateStream stream = { rowDecoderSink, rows, 0 };
+			error = zlibDecompressChain(&window, idat, idatcount, &state->decoder.zlibsettings, &stream);
+			lodepng_free(window.data);
+		}
+	}
+	if (!error && (rows->y != h || rows->linesize)) error = 91; /*decompressed size doesn't match prediction*/
+
+	lodepng_free(rows->line);
+	lodepng_free(rows->prev);
+	lodepng_free(rows->cur);
+	lodepng_free(rows->band);
+	return error;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
+#if !IMSD_SOURCE_CODE_MODIFICATION
 static void decodeGeneric(byte** out, uint32_t* w, uint32_t* h,
 	LodePNGState* state,
 	const byte* in, size_t insize) {
+#else
+/*
+dest, if not null, receives the image instead of a new allocation and must hold the raw size of info_png.color.
+rows, if not null, gets the image row by row through rowDecoderRun and out stays empty.
+*/
+static void decodeGeneric(byte** out, uint32_t* w, uint32_t* h,
+	LodePNGState* state,
+	const byte* in, size_t insize, byte* dest = nullptr, RowDecoder* rows = nullptr) {
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	byte IEND = 0;
 	const byte* chunk;
+#if !IMSD_SOURCE_CODE_MODIFICATION
 	byte* idat; /*the data from idat chunks, zlib compressed*/
+#else
+	InflateSegment* idat; /*where the data of each idat chunk lies in the input, it is inflated from there*/
+	size_t idatcount = 0, idatcapacity = 0;
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	size_t idatsize = 0;
 	byte* scanlines = 0;
 	size_t scanlines_size = 0, expected_size = 0;
@@ -5029,9 +6655,13 @@ static void decodeGeneric(byte** out, uint32_t* w, uint32_t* h,
 		CERROR_RETURN(state->error, 92); /*overflow possible due to amount of pixels*/
 	}
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 	/*the input filesize is a safe upper bound for the sum of idat chunks size*/
 	idat = (byte*)lodepng_malloc(insize);
 	if (!idat) CERROR_RETURN(state->error, 83); /*alloc fail*/
+#else
+	idat = 0;
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 
 	chunk = &in[33]; /*first byte of the first chunk after the header*/
 
@@ -5068,7 +6698,20 @@ static void decodeGeneric(byte** out, uint32_t* w, uint32_t* h,
 			size_t newsize;
 			if (lodepng_addofl(idatsize, chunkLength, &newsize)) CERROR_BREAK(state->error, 95);
 			if (newsize > insize) CERROR_BREAK(state->error, 95);
+#if !IMSD_SOURCE_CODE_MODIFICATION
 			lodepng_memcpy(idat + idatsize, (unknown_pointer)data, chunkLength);
+#else
+			if (idatcount == idatcapacity) {
+				size_t capacity = idatcapacity ? idatcapacity * 2u : 8u;
+				InflateSegment* grown = (InflateSegment*)lodepng_realloc(idat, capacity * sizeof(InflateSegment));
+				if (!grown) CERROR_BREAK(state->error, 83); /*alloc fail*/
+				idat = grown;
+				idatcapacity = capacity;
+			}
+			idat[idatcount].data = data;
+			idat[idatcount].size = chunkLength;
+			++idatcount;
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 			idatsize += chunkLength;
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
 			critical_pos = 3;
@@ -5172,6 +6815,14 @@ static void decodeGeneric(byte** out, uint32_t* w, uint32_t* h,
 		state->error = 106; /* error: PNG file must have PLTE chunk if color type is palette */
 	}
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+	if (rows) {
+		if (!state->error) state->error = rowDecoderRun(rows, state, *w, *h, idat, idatcount);
+		lodepng_free(idat);
+		return;
+	}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 	if (!state->error) {
 		/*predict output size, to allocate exact size for output buffer to avoid more dynamic allocation.
 		If the decompressed size does not match the prediction, the image must be corrupt.*/
@@ -5192,18 +6843,31 @@ static void decodeGeneric(byte** out, uint32_t* w, uint32_t* h,
 			expected_size += lodepng_get_raw_size_idat((*w + 0), (*h + 0) >> 1, bpp);
 		}
 
+#if !IMSD_SOURCE_CODE_MODIFICATION
 		state->error = zlib_decompress(&scanlines, &scanlines_size, expected_size, idat, idatsize, &state->decoder.zlibsettings);
+#else
+		state->error = zlib_decompress(&scanlines, &scanlines_size, expected_size, idat, idatcount, &state->decoder.zlibsettings);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 	}
 	if (!state->error && scanlines_size != expected_size) state->error = 91; /*decompressed size doesn't match prediction*/
 	lodepng_free(idat);
 
 	if (!state->error) {
 		outsize = lodepng_get_raw_size(*w, *h, &state->info_png.color);
+#if !IMSD_SOURCE_CODE_MODIFICATION
 		*out = (unsigned char*)lodepng_malloc(outsize);
+#else
+		*out = dest ? dest : (unsigned char*)lodepng_malloc(outsize);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 		if (!*out) state->error = 83; /*alloc fail*/
 	}
 	if (!state->error) {
+#if !IMSD_SOURCE_CODE_MODIFICATION
 		lodepng_memset(*out, 0, outsize);
+#else
+		/*unfilter and deinterlace write every byte, only the bit packing of bpp < 8 ORs into out*/
+		if (lodepng_get_bpp(&state->info_png.color) < 8) lodepng_memset(*out, 0, outsize);
+#endif /* !IMSD_SOURCE_CODE_MODIFICATION */
 		state->error = postProcessScanlines(*out, scanlines, *w, *h, &state->info_png);
 	}
 	lodepng_free(scanlines);
@@ -5248,6 +6912,86 @@ uint32_t lodepng_decode(byte** out, uint32_t* w, uint32_t* h,
 	return state->error;
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+uint32_t lodepng_decode_size(size_t* outsize, uint32_t w, uint32_t h, const LodePNGState* state)
+{
+	int32_t direct = !state->decoder.color_convert || lodepng_color_mode_equal(&state->info_raw, &state->info_png.color);
+
+	*outsize = 0;
+	if (lodepng_pixel_overflow(w, h, &state->info_png.color, &state->info_raw)) return 92; /*overflow possible due to amount of pixels*/
+	*outsize = lodepng_get_raw_size(w, h, direct ? &state->info_png.color : &state->info_raw);
+	return 0;
+}
+
+uint32_t lodepng_decode_into(byte* out, size_t outsize, uint32_t* w, uint32_t* h,
+	LodePNGState* state,
+	const byte* in, size_t insize)
+{
+	byte* decoded = nullptr;
+	size_t needed;
+	uint32_t direct;
+
+	*w = *h = 0;
+	state->error = lodepng_inspect(w, h, state, in, insize);
+	if (state->error) return state->error;
+
+	direct = !state->decoder.color_convert || lodepng_color_mode_equal(&state->info_raw, &state->info_png.color);
+	if (!direct && !(state->info_raw.colortype == LodePNGColorType::LCT_RGB || state->info_raw.colortype == LodePNGColorType::LCT_RGBA)
+		&& !(state->info_raw.bitdepth == 8)) {
+		return 56; /*unsupported color mode conversion*/
+	}
+	state->error = lodepng_decode_size(&needed, *w, *h, state);
+	if (state->error) return state->error;
+	if (outsize < needed) {
+		CERROR_RETURN_ERROR(state->error, 114); /*output buffer too small*/
+	}
+
+	if (direct) {
+		decodeGeneric(&decoded, w, h, state, in, insize, out);
+		if (!state->error && !state->decoder.color_convert) {
+			state->error = lodepng_color_mode_copy(&state->info_raw, &state->info_png.color);
+		}
+	}
+	else {
+		/*the conversion needs the image in the png color type first, only that one is allocated*/
+		decodeGeneric(&decoded, w, h, state, in, insize);
+		if (!state->error) state->error = lodepng_convert(out, decoded, &state->info_raw, &state->info_png.color, *w, *h);
+		lodepng_free(decoded);
+	}
+	return state->error;
+}
+
+uint32_t lodepng_decode_rows(uint32_t* w, uint32_t* h,
+	LodePNGState* state,
+	const byte* in, size_t insize,
+	uint32_t bandrows, LodePNGRowCallback callback, void* context)
+{
+	byte* unused = nullptr;
+	RowDecoder rows;
+
+	*w = *h = 0;
+	state->error = lodepng_inspect(w, h, state, in, insize);
+	if (state->error) return state->error;
+
+	if (state->info_png.interlace_method != 0) CERROR_RETURN_ERROR(state->error, 115); /*Adam7 can't be unfiltered row by row*/
+	if (state->decoder.color_convert && !lodepng_color_mode_equal(&state->info_raw, &state->info_png.color)
+		&& !(state->info_raw.colortype == LodePNGColorType::LCT_RGB || state->info_raw.colortype == LodePNGColorType::LCT_RGBA)
+		&& !(state->info_raw.bitdepth == 8)) {
+		return 56; /*unsupported color mode conversion*/
+	}
+
+	rows.callback = callback;
+	rows.context = context;
+	rows.bandrows = bandrows ? bandrows : 1u;
+
+	decodeGeneric(&unused, w, h, state, in, insize, nullptr, &rows);
+	if (!state->error && !state->decoder.color_convert) {
+		state->error = lodepng_color_mode_copy(&state->info_raw, &state->info_png.color);
+	}
+	return state->error;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 uint32_t lodepng_decode_memory(byte** out, uint32_t* w, uint32_t* h,
 	const byte* in, size_t insize,
 	LodePNGColorType colortype, uint32_t bitdepth)
@@ -5745,6 +7489,137 @@ static size_t ilog2i(size_t i) {
 	return i * l + ((i - (1u << l)) << 1u);
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*
+LFS_MINSUM score of one filtered row: bytes as they are for filter type 0, otherwise as signed magnitudes.
+For s >= 128 the magnitude 255 - s is s with all bits flipped, so xor with the sign mask and psadbw add it up.
+*/
+static size_t filterScoreSumScalar(const byte* line, size_t length, bool isSigned) {
+	size_t sum = 0;
+	for (size_t x = 0; x != length; ++x) {
+		byte s = line[x];
+		sum += (isSigned && s >= 128) ? (255U - s) : s;
+	}
+	return sum;
+}
+
+#if LODEPNG_X86_SIMD
+LODEPNG_TARGET("sse2")
+static size_t filterScoreSumSSE2(const byte* line, size_t length, bool isSigned) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i signMask = isSigned ? _mm_set1_epi8(-1) : zero;
+	__m128i sum = zero;
+	size_t x = 0;
+
+	for (; x + 16u <= length; x += 16u) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line + x));
+		v = _mm_xor_si128(v, _mm_and_si128(_mm_cmpgt_epi8(zero, v), signMask));
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+	}
+
+	uint64_t lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+	return static_cast<size_t>(lanes[0] + lanes[1]) + filterScoreSumScalar(line + x, length - x, isSigned);
+}
+
+LODEPNG_TARGET("avx2")
+static size_t filterScoreSumAVX2(const byte* line, size_t length, bool isSigned) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i signMask = isSigned ? _mm256_set1_epi8(-1) : zero;
+	__m256i sum = zero;
+	size_t x = 0;
+
+	for (; x + 32u <= length; x += 32u) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line + x));
+		v = _mm256_xor_si256(v, _mm256_and_si256(_mm256_cmpgt_epi8(zero, v), signMask));
+		sum = _mm256_add_epi64(sum, _mm256_sad_epu8(v, zero));
+	}
+
+	uint64_t lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+	return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + filterScoreSumScalar(line + x, length - x, isSigned);
+}
+#endif /* LODEPNG_X86_SIMD */
+
+static size_t filterScoreSum(const byte* line, size_t length, bool isSigned) {
+#if LODEPNG_X86_SIMD
+	static const auto score = CpuFeatures::Get().avx2 ? &filterScoreSumAVX2 : &filterScoreSumSSE2;
+	return score(line, length, isSigned);
+#else
+	return filterScoreSumScalar(line, length, isSigned);
+#endif
+}
+
+/*
+LFS_MINSUM and LFS_ENTROPY choose a filter per row from that row and the unfiltered row above it only,
+so blocks of rows are handed to the thread pool and the choices are the same as row by row.
+*/
+static uint32_t filterAdaptive(byte* out, const byte* in, uint32_t h, size_t linebytes, size_t bytewidth,
+	LodePNGFilterStrategy strategy) {
+	CppThreadPool& pool = CppThreadPool::Instance();
+
+	/*enough blocks to balance the threads, but still long runs of rows per block*/
+	const size_t blocks = static_cast<size_t>(pool.GetNumThreads()) << 2u;
+	size_t rowsPerBlock = (h + blocks - 1u) / blocks;
+	if (rowsPerBlock < 8u) rowsPerBlock = 8u;
+
+	std::atomic<uint32_t> error{ 0u };
+
+	pool.RunChunks(h, rowsPerBlock, [&](size_t begin, size_t end) {
+		byte* attempts = (byte*)lodepng_malloc(linebytes * 5u);
+		uint32_t count[256];
+
+		if (!attempts) {
+			error = 83; /*alloc fail*/
+			return;
+		}
+
+		for (size_t y = begin; y != end; ++y) {
+			const byte* prevline = y ? &in[(y - 1u) * linebytes] : 0;
+			size_t bestScore = 0;
+			byte type, bestType = 0;
+
+			/*try the 5 filter types*/
+			for (type = 0; type != 5; ++type) {
+				byte* attempt = attempts + type * linebytes;
+				size_t score = 0;
+				filterScanline(attempt, &in[y * linebytes], prevline, linebytes, bytewidth, type);
+
+				if (strategy == LodePNGFilterStrategy::LFS_MINSUM) {
+					score = filterScoreSum(attempt, linebytes, type != 0);
+
+					/*smallest sum wins, the first type on ties*/
+					if (type == 0 || score < bestScore) {
+						bestType = type;
+						bestScore = score;
+					}
+				}
+				else {
+					lodepng_memset(count, 0, 256 * sizeof(*count));
+					for (size_t x = 0; x != linebytes; ++x) ++count[attempt[x]];
+					++count[type]; /*the filter type itself is part of the scanline*/
+					for (size_t x = 0; x != 256; ++x) score += ilog2i(count[x]);
+
+					/*largest sum wins, the first type on ties*/
+					if (type == 0 || score > bestScore) {
+						bestType = type;
+						bestScore = score;
+					}
+				}
+			}
+
+			/*the first byte of a scanline will be the filter type*/
+			out[y * (linebytes + 1)] = bestType;
+			lodepng_memcpy(&out[y * (linebytes + 1) + 1], attempts + bestType * linebytes, linebytes);
+		}
+
+		lodepng_free(attempts);
+		});
+
+	return error.load();
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 static uint32_t filter(byte* out, const byte* in, uint32_t w, uint32_t h,
 	const LodePNGColorMode* color, const LodePNGEncoderSettings* settings) {
 	/*
@@ -5792,6 +7667,7 @@ static uint32_t filter(byte* out, const byte* in, uint32_t w, uint32_t h,
 			prevline = &in[inindex];
 		}
 	}
+#if !IMSD_SOURCE_CODE_MODIFICATION
 	else if (strategy == LodePNGFilterStrategy::LFS_MINSUM) {
 		/*adaptive filtering*/
 		byte* attempt[5]; /*five filtering attempts, one for each filter type*/
@@ -5881,6 +7757,11 @@ static uint32_t filter(byte* out, const byte* in, uint32_t w, uint32_t h,
 
 		for (type = 0; type != 5; ++type) lodepng_free(attempt[type]);
 	}
+#else
+	else if (strategy == LodePNGFilterStrategy::LFS_MINSUM || strategy == LodePNGFilterStrategy::LFS_ENTROPY) {
+		error = filterAdaptive(out, in, h, linebytes, bytewidth, strategy);
+	}
+#endif
 	else if (strategy == LodePNGFilterStrategy::LFS_PREDEFINED) {
 		for (y = 0; y != h; ++y) {
 			size_t outindex = (1 + linebytes) * y; /*the extra filterbyte added to each row*/
@@ -6165,6 +8046,9 @@ uint32_t lodepng_encode(byte** out, size_t* outsize,
 	if (state->encoder.auto_convert) {
 		LodePNGColorStats stats;
 		lodepng_color_stats_init(&stats);
+#if IMSD_SOURCE_CODE_MODIFICATION
+		if (!state->encoder.auto_convert_palette) stats.allow_palette = 0;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
 		if (info_png->iccp_defined &&
 			isGrayICCProfile(info_png->iccp_profile, info_png->iccp_profile_size)) {
@@ -6388,6 +8272,221 @@ cleanup:
 	return state->error;
 }
 
+#if IMSD_SOURCE_CODE_MODIFICATION
+struct LodePNGRowEncoder {
+	LodePNGState* state = nullptr;
+	LodePNGWriteCallback write = nullptr;
+	void* context = nullptr;
+
+	uint32_t w = 0, h = 0;
+	uint32_t y = 0; /*rows added so far*/
+	uint32_t convert = 0;
+	size_t linebytes = 0, rawlinebytes = 0;
+
+	ucvector lines = ucvector(nullptr, 0); /*the last row of the previous add, then the new rows, in info_png.color*/
+	ucvector filtered = ucvector(nullptr, 0); /*the window compressed already, then the filtered rows still to compress*/
+	ucvector out = ucvector(nullptr, 0); /*file bytes not written yet*/
+	byte* saved = nullptr; /*the filtered row that filtering the kept row again overwrites*/
+	size_t window = 0; /*bytes of the window at the start of filtered*/
+	size_t keep = 0; /*window size kept after a flush: the deflate window, at least one scanline*/
+	size_t blocksize = 0, flushsize = 0;
+	uint32_t adler = 1u;
+	uint32_t started = 0; /*the zlib header was written*/
+};
+
+static void rowEncoderFree(LodePNGRowEncoder* encoder) {
+	lodepng_free(encoder->lines.data);
+	lodepng_free(encoder->filtered.data);
+	lodepng_free(encoder->out.data);
+	lodepng_free(encoder->saved);
+	delete encoder;
+}
+
+/*
+Compress the pending rows into one IDAT chunk and write it after whatever waits in out.
+The deflate stream of a chunk that is not the last ends with a sync flush, the next one continues it
+with the window primed from the kept filtered bytes, the same way deflateParallel joins its runs.
+*/
+static uint32_t rowEncoderFlush(LodePNGRowEncoder* encoder, uint32_t last) {
+	const LodePNGCompressSettings* settings = &encoder->state->encoder.zlibsettings;
+	const size_t pending = encoder->filtered.size - encoder->window;
+	ucvector idat(nullptr, 0);
+	uint32_t error = 0;
+
+	/*room for the length and type, they and the CRC are filled in once the size is known*/
+	if (!ucvector_resize(&idat, 8)) return 83; /*alloc fail*/
+
+	if (!encoder->started) {
+		/*CMF 120: deflate with a 32K window, FLG 1: no dictionary, the check bits*/
+		if (!ucvector_resize(&idat, 10)) error = 83; /*alloc fail*/
+		else {
+			idat.data[8] = 120;
+			idat.data[9] = 1;
+		}
+		encoder->started = 1;
+	}
+
+	if (error) {}
+	else if (pending == 0) {
+		/*an empty final block with the fixed tree, nothing else is left to end the stream with*/
+		if (last && !ucvector_resize(&idat, idat.size + 2)) error = 83; /*alloc fail*/
+		else if (last) {
+			idat.data[idat.size - 2] = 3;
+			idat.data[idat.size - 1] = 0;
+		}
+	}
+	else if (settings->btype == 0) {
+		error = deflateNoCompression(&idat, encoder->filtered.data + encoder->window, pending, last);
+	}
+	else {
+		const size_t threads = CppThreadPool::Instance().GetNumThreads();
+		const size_t blocks = (pending + encoder->blocksize - 1) / encoder->blocksize;
+		size_t blocksPerChunk = (blocks + threads - 1) / threads;
+		if (blocksPerChunk < lodepng_deflate_min_chunk_blocks) blocksPerChunk = lodepng_deflate_min_chunk_blocks;
+
+		error = deflateParallel(&idat, encoder->filtered.data, encoder->window, encoder->filtered.size,
+			encoder->blocksize, blocksPerChunk, settings, last);
+	}
+
+	if (!error && last) {
+		if (!ucvector_resize(&idat, idat.size + 4)) error = 83; /*alloc fail*/
+		else lodepng_set32bitInt(idat.data + idat.size - 4, encoder->adler);
+	}
+	if (!error) {
+		if (!ucvector_resize(&idat, idat.size + 4)) error = 83; /*alloc fail*/
+	}
+	if (!error) {
+		lodepng_set32bitInt(idat.data, (uint32_t)(idat.size - 12));
+		lodepng_memcpy(idat.data + 4, (unknown_pointer)"IDAT", 4);
+		lodepng_chunk_generate_crc(idat.data);
+
+		if (encoder->out.size && encoder->write(encoder->out.data, encoder->out.size, encoder->context)) error = 118;
+		encoder->out.size = 0;
+		if (!error && encoder->write(idat.data, idat.size, encoder->context)) error = 118;
+	}
+	lodepng_free(idat.data);
+
+	if (!error) {
+		/*slide the window: the last bytes stay as history for the next chunk*/
+		size_t keep = encoder->filtered.size < encoder->keep ? encoder->filtered.size : encoder->keep;
+		memmove(encoder->filtered.data, encoder->filtered.data + encoder->filtered.size - keep, keep);
+		encoder->filtered.size = keep;
+		encoder->window = keep;
+	}
+	return error;
+}
+
+uint32_t lodepng_row_encoder_begin(LodePNGRowEncoder** encoder, uint32_t w, uint32_t h,
+	LodePNGState* state, LodePNGWriteCallback write, void* context)
+{
+	const LodePNGColorMode* color = &state->info_png.color;
+	LodePNGRowEncoder* rows;
+	uint32_t error;
+
+	*encoder = nullptr;
+
+	if (color->colortype == LodePNGColorType::LCT_PALETTE && (color->palettesize == 0 || color->palettesize > 256)) {
+		return 68; /*invalid palette size, it is only allowed to be 1-256*/
+	}
+	if (state->encoder.zlibsettings.btype > 2) return 61; /*error: invalid btype*/
+	if (state->info_png.interlace_method != 0) return 115; /*Adam7 can't be filtered row by row*/
+	error = checkColorValidity(color->colortype, color->bitdepth);
+	if (error) return error;
+	error = checkColorValidity(state->info_raw.colortype, state->info_raw.bitdepth);
+	if (error) return error;
+
+	rows = new (std::nothrow) LodePNGRowEncoder;
+	if (!rows) return 83; /*alloc fail*/
+
+	rows->state = state;
+	rows->write = write;
+	rows->context = context;
+	rows->w = w;
+	rows->h = h;
+	rows->convert = !lodepng_color_mode_equal(&state->info_raw, color);
+	rows->linebytes = lodepng_get_raw_size_idat(w, 1, lodepng_get_bpp(color)) - 1u;
+	rows->rawlinebytes = lodepng_get_raw_size(w, 1, &state->info_raw);
+	rows->keep = state->encoder.zlibsettings.windowsize;
+	if (rows->keep < rows->linebytes + 1u) rows->keep = rows->linebytes + 1u;
+
+	/*the block size lodepng_deflatev would pick for the whole image, one run of blocks per thread and flush*/
+	rows->blocksize = ((size_t)h * (rows->linebytes + 1u)) / 8u + 8;
+	if (rows->blocksize < 65536) rows->blocksize = 65536;
+	if (rows->blocksize > 262144) rows->blocksize = 262144;
+	rows->flushsize = rows->blocksize * lodepng_deflate_min_chunk_blocks * CppThreadPool::Instance().GetNumThreads();
+
+	rows->saved = (byte*)lodepng_malloc(rows->linebytes + 1u);
+	if (!rows->saved) error = 83; /*alloc fail*/
+
+	if (!error) error = writeSignature(&rows->out);
+	if (!error) error = addChunk_IHDR(&rows->out, w, h, color->colortype, color->bitdepth, 0);
+	if (!error && color->colortype == LodePNGColorType::LCT_PALETTE) error = addChunk_PLTE(&rows->out, color);
+	if (!error) error = addChunk_tRNS(&rows->out, color);
+
+	if (error) rowEncoderFree(rows);
+	else *encoder = rows;
+	return error;
+}
+
+uint32_t lodepng_row_encoder_add(LodePNGRowEncoder* encoder, const byte* rows, uint32_t count)
+{
+	const LodePNGState* state = encoder->state;
+	const size_t scanlinebytes = encoder->linebytes + 1u;
+	/*the last row of the previous add goes through the filter again as the row above the new ones*/
+	const size_t kept = encoder->y ? 1u : 0u;
+	uint32_t error = 0;
+
+	if (count > encoder->h - encoder->y) return 117;
+	if (count == 0) return 0;
+
+	if (!ucvector_resize(&encoder->lines, (kept + count) * encoder->linebytes)) return 83; /*alloc fail*/
+	for (uint32_t i = 0; i != count && !error; ++i) {
+		byte* line = encoder->lines.data + (kept + i) * encoder->linebytes;
+		const byte* raw = rows + i * encoder->rawlinebytes;
+
+		if (encoder->convert) {
+			/*so the padding bits at the end of a row are always zero*/
+			if (lodepng_get_bpp(&state->info_png.color) < 8) lodepng_memset(line, 0, encoder->linebytes);
+			error = lodepng_convert(line, raw, &state->info_png.color, &state->info_raw, encoder->w, 1);
+		}
+		else lodepng_memcpy(line, (unknown_pointer)raw, encoder->linebytes);
+	}
+	if (error) return error;
+
+	/*the filtered kept row lands on its first filtering, which is already part of the stream, and is put back*/
+	const size_t start = encoder->filtered.size - kept * scanlinebytes;
+	if (!ucvector_resize(&encoder->filtered, encoder->filtered.size + count * scanlinebytes)) return 83; /*alloc fail*/
+	byte* filtered = encoder->filtered.data + start;
+
+	if (kept) lodepng_memcpy(encoder->saved, filtered, scanlinebytes);
+	error = filter(filtered, encoder->lines.data, encoder->w, (uint32_t)(kept + count), &state->info_png.color, &state->encoder);
+	if (kept) lodepng_memcpy(filtered, encoder->saved, scanlinebytes);
+	if (error) return error;
+
+	encoder->adler = adler32_combine(encoder->adler,
+		adler32_parallel(filtered + kept * scanlinebytes, count * scanlinebytes), count * scanlinebytes);
+
+	memmove(encoder->lines.data, encoder->lines.data + (kept + count - 1u) * encoder->linebytes, encoder->linebytes);
+	encoder->lines.size = encoder->linebytes;
+	encoder->y += count;
+
+	if (encoder->filtered.size - encoder->window >= encoder->flushsize) error = rowEncoderFlush(encoder, 0);
+	return error;
+}
+
+uint32_t lodepng_row_encoder_finish(LodePNGRowEncoder* encoder)
+{
+	uint32_t error = encoder->y == encoder->h ? 0 : 117;
+
+	if (!error) error = rowEncoderFlush(encoder, 1);
+	if (!error) error = addChunk_IEND(&encoder->out);
+	if (!error && encoder->write(encoder->out.data, encoder->out.size, encoder->context)) error = 118;
+
+	rowEncoderFree(encoder);
+	return error;
+}
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
+
 uint32_t lodepng_encode_memory(byte** out, size_t* outsize,
 	const byte* image, uint32_t w, uint32_t h,
 	LodePNGColorType colortype, uint32_t bitdepth)
@@ -6448,6 +8547,9 @@ void lodepng_encoder_settings_init(LodePNGEncoderSettings* settings) {
 	settings->filter_palette_zero = 1;
 	settings->filter_strategy = LodePNGFilterStrategy::LFS_MINSUM;
 	settings->auto_convert = 1;
+#if IMSD_SOURCE_CODE_MODIFICATION
+	settings->auto_convert_palette = 1;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 	settings->force_palette = 0;
 	settings->predefined_filters = 0;
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
@@ -6587,6 +8689,13 @@ CSTR lodepng_error_text(uint32_t code)
 		/*max ICC size limit can be configured in LodePNGDecoderSettings. This error prevents
 		unreasonable memory consumption when decoding due to impossibly large ICC profile*/
 	case 113: return "ICC profile unreasonably large";
+#if IMSD_SOURCE_CODE_MODIFICATION
+	case 114: return "output buffer given to lodepng_decode_into is smaller than the decoded image";
+	case 115: return "Adam7 interlaced images can't be decoded or encoded row by row";
+	case 116: return "the row callback stopped decoding";
+	case 117: return "the row encoder got more or fewer rows than the image height";
+	case 118: return "the write callback stopped encoding";
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 	}
 	return "unknown error code";
 }
@@ -347,6 +347,10 @@ struct LodePNGCompressSettings /*deflate = compress*/ {
 	uint32_t minmatch; /*minimum lz77 length. 3 is normally best, 6 can be better for some PNGs. Default: 0*/
 	uint32_t nicematch; /*stop searching if >= this length found. Set to 258 for best compression. Default: 128*/
 	uint32_t lazymatching; /*use lazy matching: better compression but a bit slower. Default: true*/
+#if IMSD_SOURCE_CODE_MODIFICATION
+	uint32_t maxchainlength; /*hash chain steps per position, 0 derives it from windowsize. Default: 0*/
+	uint32_t rle; /*only match runs at distance 1, no hash chains: much faster, less compression. Default: false*/
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 
 	/*use custom zlib encoder instead of built in one (default: null)*/
 	uint32_t(*custom_zlib)(byte**, size_t*,
@@ -768,6 +772,11 @@ struct LodePNGEncoderSettings {
 	LodePNGCompressSettings zlibsettings; /*settings for the zlib encoder, such as window size, ...*/
 
 	uint32_t auto_convert; /*automatically choose output PNG color type. Default: true*/
+#if IMSD_SOURCE_CODE_MODIFICATION
+	/*if false, auto_convert never picks a palette and skips counting the colors,
+	for images the caller knows to have many. Default: true*/
+	uint32_t auto_convert_palette;
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 
 	/*If true, follows the official PNG heuristic: if the PNG uses a palette or lower than
 	8 bit depth, set all filters to zero. Otherwise use the filter_strategy. Note that to
@@ -835,6 +844,43 @@ information is placed in the info_png field of the LodePNGState.
 uint32_t lodepng_inspect(uint32_t* w, uint32_t* h,
 	LodePNGState* state,
 	const byte* in, size_t insize);
+
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*
+The bytes lodepng_decode_into needs for a w * h image with the color modes of state, for the w and h
+given by lodepng_inspect. The header is not checked for sizes lodepng can't work with until the image
+is decoded, this makes the same check first and returns error 92 (outsize 0) if they could overflow.
+*/
+uint32_t lodepng_decode_size(size_t* outsize, uint32_t w, uint32_t h, const LodePNGState* state);
+
+/*
+Same as lodepng_decode, but writes the pixels into a buffer owned by the caller instead
+of allocating one. Size it with lodepng_decode_size, a smaller outsize gives error 114.
+Without color conversion the scanlines are unfiltered straight into out, otherwise the
+conversion writes into out, so no extra copy of the image is made either way.
+*/
+uint32_t lodepng_decode_into(byte* out, size_t outsize, uint32_t* w, uint32_t* h,
+	LodePNGState* state,
+	const byte* in, size_t insize);
+
+/*
+Receives count rows of the image starting at row y, stored one after another. Each row starts on a
+byte, so it is ceil(w * bpp / 8) bytes long for the bpp of info_raw. Return nonzero to stop decoding.
+*/
+typedef uint32_t (*LodePNGRowCallback)(const byte* rows, uint32_t y, uint32_t count, void* context);
+
+/*
+Same as lodepng_decode, but the image never exists in memory at once: IDAT is inflated into a
+bounded buffer, unfiltered one scanline at a time and handed to callback in bands of bandrows rows
+(the last band may be shorter). Memory use depends on the width and bandrows, not on the height.
+Only non-interlaced images can be decoded this way, Adam7 gives error 115.
+A nonzero return of callback stops decoding with error 116.
+*/
+uint32_t lodepng_decode_rows(uint32_t* w, uint32_t* h,
+	LodePNGState* state,
+	const byte* in, size_t insize,
+	uint32_t bandrows, LodePNGRowCallback callback, void* context);
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 /*
@@ -857,6 +903,28 @@ uint32_t lodepng_inspect_chunk(LodePNGState* state, size_t pos,
 uint32_t lodepng_encode(byte** out, size_t* outsize,
 	const byte* image, uint32_t w, uint32_t h,
 	LodePNGState* state);
+
+#if IMSD_SOURCE_CODE_MODIFICATION
+/*receives the next size bytes of the PNG file. Return nonzero to stop encoding.*/
+typedef uint32_t (*LodePNGWriteCallback)(const byte* data, size_t size, void* context);
+
+/*
+Encoder that takes the image a few rows at a time and writes the PNG as it goes, for images
+that don't fit in memory. Filtered rows are compressed and written as an IDAT chunk each time a few
+MB have gathered, so memory use depends on the width, not on the height.
+Since the pixels are not known up front, info_png.color is written as it is set (auto_convert is
+ignored), the image is never interlaced and only IHDR, PLTE, tRNS, IDAT and IEND are written.
+lodepng_row_encoder_add takes rows in info_raw, each starting on a byte as in LodePNGRowCallback.
+The state must stay alive until lodepng_row_encoder_finish, which writes the end of the file and
+always frees the encoder; it gives error 117 if fewer than h rows were added.
+*/
+struct LodePNGRowEncoder;
+
+uint32_t lodepng_row_encoder_begin(LodePNGRowEncoder** encoder, uint32_t w, uint32_t h,
+	LodePNGState* state, LodePNGWriteCallback write, void* context);
+uint32_t lodepng_row_encoder_add(LodePNGRowEncoder* encoder, const byte* rows, uint32_t count);
+uint32_t lodepng_row_encoder_finish(LodePNGRowEncoder* encoder);
+#endif /* IMSD_SOURCE_CODE_MODIFICATION */
 #endif /*LODEPNG_COMPILE_ENCODER*/
 
 /*
@@ -22,6 +22,13 @@ if you use this software In a product, the confirmation in the product documenta
 so you should also comply with the requirements of its header declaration
 */
 
+#include <algorithm>
+#include <cctype>
+#include <cwctype>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include "MappedFile.h"
 #include "png.h"
 
 #ifndef FUNC_LIMIT
@@ -45,31 +52,332 @@ static uint32_t fnv1a32(T* buff, size_t len, uint32_t init = 0x811C9DC5)
 	return hash;
 }
 
+//'*' matches any run of characters and '?' a single one, case is ignored like the Windows shell does
+static bool wildcardMatch(const wchar_t* pattern, const wchar_t* name)
+{
+	const wchar_t* starPattern = nullptr;
+	const wchar_t* starName = nullptr;
+
+	while (*name != L'\0')
+	{
+		if (*pattern == L'*')
+		{
+			starPattern = ++pattern;
+			starName = name;
+		}
+		else
+			if (*pattern == L'?' || std::towlower(*pattern) == std::towlower(*name))
+			{
+				++pattern;
+				++name;
+			}
+			else
+				if (starPattern != nullptr)
+				{
+					pattern = starPattern;
+					name = ++starName;
+				}
+				else
+					return false;
+	}
+
+	while (*pattern == L'*')
+		++pattern;
+
+	return *pattern == L'\0';
+}
+
+static bool isPngExtension(const std::filesystem::path& file)
+{
+	std::wstring extension = file.extension().wstring();
+
+	for (auto& c : extension)
+		c = static_cast<wchar_t>(std::towlower(c));
+
+	return extension == L".png";
+}
+
+//the decoded rows a streamed pipeline still needs and the encoder its bands go to
+struct StreamBands
+{
+	const std::vector<PngProcessingTools::PipelineStep>* pipeline = nullptr;
+	LodePNGRowEncoder* encoder = nullptr;
+
+	uint32_t width = 0u;
+	uint32_t height = 0u;
+	uint32_t halo = 0u;
+	uint32_t bandRows = 0u;
+
+	std::vector<byte> rows;//RGBA rows from rowsBegin to the last decoded one
+	uint32_t rowsBegin = 0u;
+	uint32_t outBegin = 0u;//the first row not encoded yet
+
+	uint32_t encoderError = 0u;
+	bool failed = false;
+};
+
+//a band runs once the rows its halo reaches below it are decoded, only its own rows are encoded
+static uint32_t streamRows(const byte* rows, uint32_t y, uint32_t count, void* context)
+{
+	StreamBands& bands = *static_cast<StreamBands*>(context);
+	const size_t rowBytes = static_cast<size_t>(bands.width) << 2u;
+	const uint32_t decoded = y + count;
+
+	bands.rows.insert(bands.rows.end(), rows, rows + rowBytes * count);
+
+	while (bands.outBegin < bands.height)
+	{
+		const uint32_t outEnd = min(bands.outBegin + bands.bandRows, bands.height);
+		const uint32_t bandEnd = min(outEnd + bands.halo, bands.height);
+		const uint32_t bandBegin = (bands.outBegin > bands.halo) ? bands.outBegin - bands.halo : 0u;
+
+		if (bandEnd > decoded)
+			break;
+
+		TextureData band;
+		band.resize(bands.width, bandEnd - bandBegin);
+		std::memcpy(band.image.data(), bands.rows.data() + (bandBegin - bands.rowsBegin) * rowBytes, band.image.size());
+
+		if (!PngProcessingTools::runPipeline(band, *bands.pipeline))
+		{
+			bands.failed = true;
+			return 1u;
+		}
+
+		bands.encoderError = lodepng_row_encoder_add(bands.encoder, band.image.data() + (bands.outBegin - bandBegin) * rowBytes, outEnd - bands.outBegin);
+		if (bands.encoderError)
+			return bands.encoderError;
+
+		bands.outBegin = outEnd;
+
+		//keep what the halo of the next band reaches back to
+		const uint32_t keepBegin = (outEnd > bands.halo) ? outEnd - bands.halo : 0u;
+		if (keepBegin > bands.rowsBegin)
+		{
+			bands.rows.erase(bands.rows.begin(), bands.rows.begin() + (keepBegin - bands.rowsBegin) * rowBytes);
+			bands.rowsBegin = keepBegin;
+		}
+	}
+	return 0u;
+}
+
+static uint32_t streamWrite(const byte* data, size_t size, void* context)
+{
+	std::ofstream& file = *static_cast<std::ofstream*>(context);
+	file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+	return file ? 0u : 1u;
+}
+
+bool PngProcessingTools::readCubeFile(const std::filesystem::path& cubefile, ColorCube& cube)
+{
+	std::ifstream file(cubefile);
+	if (!file)
+	{
+		std::cout << "Can't open the cube file:" << cubefile << std::endl;
+		return false;
+	}
+
+	float32_t domainMin[3] = { 0.0f, 0.0f, 0.0f };
+	float32_t domainMax[3] = { 1.0f, 1.0f, 1.0f };
+	uint32_t size = 0u;
+	size_t points = 0u;
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		std::istringstream iss(line);
+		std::string keyword;
+
+		if (!(iss >> keyword) || keyword.front() == '#')
+			continue;
+
+		//the keywords come first, the table is every line that starts with a number
+		const char first = keyword.front();
+		if (std::isdigit(static_cast<unsigned char>(first)) || first == '-' || first == '+' || first == '.')
+		{
+			if (points == 0u)
+			{
+				if (size < ColorCube::minSize || size > ColorCube::maxSize)
+				{
+					std::cout << "The cube file has no LUT_3D_SIZE from " << ColorCube::minSize << " to " << ColorCube::maxSize << ",Wrong!" << std::endl;
+					return false;
+				}
+
+				if (!(domainMin[0] < domainMax[0] && domainMin[1] < domainMax[1] && domainMin[2] < domainMax[2]))
+				{
+					std::cout << "The cube domain is empty,Wrong!" << std::endl;
+					return false;
+				}
+
+				cube.resize(size);
+				cube.setDomain(domainMin, domainMax);
+			}
+
+			float32_t R = 0.0f, G = 0.0f, B = 0.0f;
+			std::istringstream values(line);
+
+			if (points >= cube.lattice.size() || !(values >> R >> G >> B))
+			{
+				std::cout << "Bad cube table line " << (points + 1u) << ":" << line << ",Wrong!" << std::endl;
+				return false;
+			}
+
+			cube.lattice[points++] = RGBAColor_32f(R, G, B, 0.0f) * maxColorPix;
+		}
+		else
+			if (keyword == "LUT_3D_SIZE")
+			{
+				iss >> size;
+			}
+			else
+				if (keyword == "DOMAIN_MIN")
+				{
+					iss >> domainMin[0] >> domainMin[1] >> domainMin[2];
+				}
+				else
+					if (keyword == "DOMAIN_MAX")
+					{
+						iss >> domainMax[0] >> domainMax[1] >> domainMax[2];
+					}
+					else
+						if (keyword == "LUT_3D_INPUT_RANGE")
+						{
+							iss >> domainMin[0] >> domainMax[0];
+							domainMin[1] = domainMin[2] = domainMin[0];
+							domainMax[1] = domainMax[2] = domainMax[0];
+						}
+						else
+							if (keyword == "LUT_1D_SIZE")
+							{
+								std::cout << "1D cube files are not supported,Wrong!" << std::endl;
+								return false;
+							}
+		//TITLE and unknown keywords are skipped
+	}
+
+	if (points == 0u || points != cube.lattice.size())
+	{
+		std::cout << "The cube file has " << points << " points, LUT_3D_SIZE " << size << " needs " << (static_cast<size_t>(size) * size * size) << ",Wrong!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool PngProcessingTools::writeCubeFile(const ColorCube& cube, const std::wstring& cubename, const std::string& title)
+{
+	std::ofstream file(std::filesystem::path(cubename), std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Can't write the cube file:" << AdaptString::toString(cubename) << std::endl;
+		return false;
+	}
+
+	//baked cubes always span 0 to 1
+	file << "TITLE \"" << title << "\"\n"
+		<< "LUT_3D_SIZE " << cube.size << '\n'
+		<< "DOMAIN_MIN 0.0 0.0 0.0\n"
+		<< "DOMAIN_MAX 1.0 1.0 1.0\n"
+		<< std::fixed << std::setprecision(6);
+
+	for (const RGBAColor_32f& point : cube.lattice)
+	{
+		file << point.R * ColorPixTofloat << ' ' << point.G * ColorPixTofloat << ' ' << point.B * ColorPixTofloat << '\n';
+	}
+
+	file.close();
+	return static_cast<bool>(file);
+}
+
 void PngProcessingTools::importFile(TextureData& data, std::filesystem::path& pngfile)
+{
+	if (!decodeFile(data, pngfile))
+		exit(0);
+}
+
+bool PngProcessingTools::decodeFile(TextureData& data, const std::filesystem::path& pngfile)
 {
 	auto path = AdaptString::toString(pngfile.wstring());
 
 	clockTimer timer;
 
+	MappedFile mapped;
+	byte* buffer = nullptr;
+	size_t bufferSize = 0u;
+
+	LodePNGState state;
+	lodepng_state_init(&state);
+	state.info_raw.colortype = LodePNGColorType::LCT_RGBA;
+	state.info_raw.bitdepth = 8u;
+#ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
+	state.decoder.read_text_chunks = 0u;
+	state.decoder.remember_unknown_chunks = 0u;
+#endif
+
 	timer.TimerStart();
-	uint32_t error = lodepng::decode(data.image, data.width, data.height, path);
+	uint32_t error = 0u;
+	const byte* input = nullptr;
+	size_t inputSize = 0u;
+
+	//decode from the mapped file, reading it into memory is left for files that can't be mapped
+	if (mapped.Open(pngfile))
+	{
+		input = mapped.data();
+		inputSize = mapped.size();
+	}
+	else
+	{
+		error = lodepng_load_file(&buffer, &bufferSize, path.c_str());
+		input = buffer;
+		inputSize = bufferSize;
+	}
+
+	//size the aligned buffer from the header, then let lodepng write the RGBA pixels straight into it.
+	//the header is checked before anything is allocated, a failed allocation is reported like lodepng's own (83)
+	uint32_t width = 0u, height = 0u;
+	size_t decodeSize = 0u;
+	if (!error)
+		error = lodepng_inspect(&width, &height, &state, input, inputSize);
+	if (!error)
+		error = lodepng_decode_size(&decodeSize, width, height, &state);
+
+	if (!error)
+	{
+		try
+		{
+			data.resize(width, height, 4u);
+		}
+		catch (const std::bad_alloc&)
+		{
+			error = 83u;
+		}
+	}
+	if (!error)
+		error = lodepng_decode_into(data.image.data(), data.image.size(), &data.width, &data.height, &state, input, inputSize);
+
+	if (error)
+		data.clear();
+
+	mapped.Close();
+	free(buffer);
+	lodepng_state_cleanup(&state);
 	timer.TimerStop();
 
 	//if there's an error, display it
 	if (error)
 	{
 		std::cout << "Decoder error " << error << ": " << lodepng_error_text(error) << std::endl;
-		exit(0);
+		return false;
 	}
 
 	std::cout << "=> decode time used:" << timer.getTime() << "(second)" << std::endl;
+	return true;
 }
 
-void PngProcessingTools::exportFile(TextureData& result, std::wstring& resultname, const LodePNGColorType& colorType, const uint32_t& bitdepth)
+void PngProcessingTools::exportFile(TextureData& result, std::wstring& resultname, const LodePNGColorType& colorType, const uint32_t& bitdepth, const EncoderHints& hints)
 {
 	if ((static_cast<size_t>(result.width) * result.height) > (0xFF'FF'FF'FFu >> 2u))
 	{
-		exportFile(result.image.data(), result.width, result.height, resultname, colorType, bitdepth);//run raw byte export
+		exportFile(result.image.data(), result.width, result.height, resultname, colorType, bitdepth, hints);//run raw byte export
 	}
 	else
 	{
@@ -78,7 +386,7 @@ void PngProcessingTools::exportFile(TextureData& result, std::wstring& resultnam
 		auto path = AdaptString::toString(resultname);
 
 		timer.TimerStart();
-		uint32_t error = lodepng::encode(path, result.image, result.width, result.height, colorType, bitdepth);
+		uint32_t error = encodeFile(path, result.image.data(), result.width, result.height, colorType, bitdepth, hints);
 		timer.TimerStop();
 
 		if (error)
@@ -92,7 +400,7 @@ void PngProcessingTools::exportFile(TextureData& result, std::wstring& resultnam
 	}
 }
 
-void PngProcessingTools::exportFile(const byte* result, const uint32_t& width, const uint32_t& height, std::wstring& resultname, const LodePNGColorType& colorType, const uint32_t& bitdepth)
+void PngProcessingTools::exportFile(const byte* result, const uint32_t& width, const uint32_t& height, std::wstring& resultname, const LodePNGColorType& colorType, const uint32_t& bitdepth, const EncoderHints& hints)
 {
 	if ((static_cast<size_t>(width) * height) > (0xFF'FF'FF'FFu >> 2u))
 	{
@@ -110,9 +418,9 @@ void PngProcessingTools::exportFile(const byte* result, const uint32_t& width, c
 
 			allthreads.reserve(splitNum);
 
-			auto exportSplitSlice = [&width, &colorType, &bitdepth](const byte* resultPart, uint32_t heightPart, std::wstring resultNamePart)
+			auto exportSplitSlice = [&width, &colorType, &bitdepth, &hints](const byte* resultPart, uint32_t heightPart, std::wstring resultNamePart)
 				{
-					exportFile(resultPart, width, heightPart, resultNamePart, colorType, bitdepth);
+					exportFile(resultPart, width, heightPart, resultNamePart, colorType, bitdepth, hints);
 				};
 
 			for (size_t Current = 0u, currentSlice = 1u, size = ((static_cast<size_t>(width) * height) << 2u); Current < size; Current += byteSplitInterval, ++currentSlice)
@@ -149,7 +457,7 @@ void PngProcessingTools::exportFile(const byte* result, const uint32_t& width, c
 		auto path = AdaptString::toString(resultname);
 
 		timer.TimerStart();
-		uint32_t error = lodepng::encode(path, result, width, height, colorType, bitdepth);
+		uint32_t error = encodeFile(path, result, width, height, colorType, bitdepth, hints);
 		timer.TimerStop();
 
 		if (error)
@@ -163,6 +471,131 @@ void PngProcessingTools::exportFile(const byte* result, const uint32_t& width, c
 	}
 }
 
+EncoderHints EncoderHints::Grey(const uint32_t& bitdepth)
+{
+	EncoderHints hints;
+	hints.known = true;
+	hints.colorType = LodePNGColorType::LCT_GREY;
+	hints.bitdepth = bitdepth;
+	return hints;
+}
+
+EncoderHints EncoderHints::ManyColors()
+{
+	EncoderHints hints;
+	hints.manyColors = true;
+	return hints;
+}
+
+uint32_t PngProcessingTools::encodeFile(const std::string& path, const byte* result, const uint32_t& width, const uint32_t& height,
+	const LodePNGColorType& colorType, const uint32_t& bitdepth, const EncoderHints& hints)
+{
+	lodepng::State state;
+	state.info_raw.colortype = colorType;
+	state.info_raw.bitdepth = bitdepth;
+	state.info_png.color.colortype = colorType;
+	state.info_png.color.bitdepth = bitdepth;
+	applyCompressionLevel(compressionLevel, state.encoder);
+
+	if (hints.known)
+	{
+		state.encoder.auto_convert = 0;
+		state.info_png.color.colortype = hints.colorType;
+		state.info_png.color.bitdepth = hints.bitdepth;
+
+		for (size_t i = 0; i + 3u < hints.palette.size(); i += 4u)
+		{
+			lodepng_palette_add(&state.info_png.color, hints.palette[i], hints.palette[i + 1u], hints.palette[i + 2u], hints.palette[i + 3u]);
+		}
+	}
+	else
+		if (hints.manyColors)
+		{
+			state.encoder.auto_convert_palette = 0;
+		}
+
+	std::vector<byte> buffer;
+	uint32_t error = lodepng::encode(buffer, result, width, height, state);
+
+	if (!error)
+		error = lodepng::save_file(buffer, path);
+
+	return error;
+}
+
+void PngProcessingTools::setCompressionLevel(const CompressionLevel& level)
+{
+	compressionLevel = level;
+}
+
+PngProcessingTools::CompressionLevel PngProcessingTools::getCompressionLevel()
+{
+	return compressionLevel;
+}
+
+void PngProcessingTools::setStreaming(const bool& enable)
+{
+	streaming = enable;
+}
+
+bool PngProcessingTools::getStreaming()
+{
+	return streaming;
+}
+
+void PngProcessingTools::applyCompressionLevel(const CompressionLevel& level, LodePNGEncoderSettings& settings)
+{
+	lodepng_encoder_settings_init(&settings);
+
+	switch (level)
+	{
+	case CompressionLevel::store:
+		//the stats pass for auto convert would cost more than the deflate
+		settings.zlibsettings.btype = 0;
+		settings.filter_strategy = LodePNGFilterStrategy::LFS_ZERO;
+		settings.auto_convert = 0;
+		break;
+
+	case CompressionLevel::rle:
+		//up turns repeated rows into zero runs, no per row trial needed
+		settings.zlibsettings.rle = 1;
+		settings.zlibsettings.lazymatching = 0;
+		settings.filter_strategy = LodePNGFilterStrategy::LFS_TWO;
+		break;
+
+	case CompressionLevel::fast:
+		settings.zlibsettings.lazymatching = 0;
+		settings.zlibsettings.maxchainlength = 8u;
+		settings.zlibsettings.nicematch = 32u;
+		break;
+
+	case CompressionLevel::best:
+		settings.zlibsettings.windowsize = 32768u;
+		settings.zlibsettings.nicematch = 258u;
+		break;
+
+	case CompressionLevel::normal:
+	default:
+		break;
+	}
+}
+
+bool PngProcessingTools::parseCompressionLevel(const std::string& text, CompressionLevel& level)
+{
+	static const char* names[] = { "store", "rle", "fast", "normal", "best" };
+
+	for (uint8_t i = 0; i < 5u; ++i)
+	{
+		if (text == names[i] || (text.size() == 1u && text[0] == static_cast<char>('0' + i)))
+		{
+			level = static_cast<CompressionLevel>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void PngProcessingTools::help()
 {
 #if !FUNC_LIMIT
@@ -171,6 +604,7 @@ void PngProcessingTools::help()
 		<< "Startup parameters--->\n"
 		<< "[    Default Zoom    ]: z     \n"
 		<< "[    Bicubic Zoom    ]: Z     \n"
+		<< "[  Area Minification ]: a     \n"
 		<< "[   Laplace Sharpen  ]: s     \n"
 		<< "[GaussLaplace Sharpen]: S     \n"
 		<< "[    Tone Mapping    ]: t or T\n"
@@ -185,6 +619,8 @@ void PngProcessingTools::help()
 		<< "[ Hexadecimalization ]: h     \n"
 		<< "[   HSL Adjustment   ]: H     \n"
 		<< "[Interlaced Scanning ]: i     \n"
+		<< "[   Color Cube LUT   ]: l     \n"
+		<< "[  Color Cube Bake   ]: L     \n"
 		<< "[Vividness Adjustment]: v     \n"
 		<< "[ Natual Vivid Adjust]: V     \n"
 		<< "[      Block Cut     ]: c     \n"
@@ -192,6 +628,7 @@ void PngProcessingTools::help()
 		<< "[       Mosaic       ]: m     \n"
 		<< "[   Mixed Pictures   ]: M     \n"
 		<< "[  (En-De)cryption   ]: e or E\n"
+		<< "[      Pipeline      ]: P     \n"
 		<< '\n'
 		<< "Input Sample-->\n"
 		<< "./pngProcessor.exe filename.png z[default zoom] 1.0[zoom ratio:DF] 0.5[edge threshold:DF] 1[Exponent:DF]\n"
@@ -205,6 +642,11 @@ void PngProcessingTools::help()
 		<< "[zoom ratio(from 0.001 to 32.0)]\n"
 		<< "[formula factor(from -3.0 to -0.1)]\n"
 		<< '\n'
+		<< "./pngProcessor.exe filename.png a[area minification] 0.25[zoom ratio:DF] 1[filter:DF]\n"
+		<< "[area minification]\n"
+		<< "[zoom ratio(from 0.001 to 1.0)]\n"
+		<< "[filter(0:area average, 1:lanczos-3)]\n"
+		<< '\n'
 		<< "./pngProcessor.exe filename.png t[tone mapping] 2.0[lumming ratio:DF]\n"
 		<< "[tone mapping]\n"
 		<< "[lumming ratio(from 0.1 to 16.0)]\n"
@@ -239,6 +681,14 @@ void PngProcessingTools::help()
 		<< "./pngProcessor.exe filename.png i[Interlaced Scanning]\n"
 		<< "[Interlaced Scanning]\n"
 		<< '\n'
+		<< "./pngProcessor.exe filename.png l[color cube] look.cube[cube file]\n"
+		<< "[color cube: a 3D LUT in the .cube format, tetrahedral interpolation]\n"
+		<< '\n'
+		<< "./pngProcessor.exe filename.png L[color cube bake] 33[cube size:DF] H:30,1.2,1 V:0.3[steps]\n"
+		<< "[color cube bake: the steps become one cube, saved as .cube next to the result]\n"
+		<< "[cube size(from 2 to 256, 17 or 33 are usual)]\n"
+		<< "[steps(t T v V H r R, written like pipeline steps, alpha changes are not saved in the .cube)]\n"
+		<< '\n'
 		<< "./pngProcessor.exe filename.png v[vividness Adjustment] 0.2[vivid ratio:DF]\n"
 		<< "[vividness Adjustment]\n"
 		<< "[vivid ratio(from -1.0 to 254.0)]\n"
@@ -287,7 +737,24 @@ void PngProcessingTools::help()
 		<< "[Vertical Interval(>0)]"
 		<< "./pngProcessor.exe filename.png e[Encryption] 1234567[excrtption key:DF]\n"
 		<< "[Encryption]\n"
-		<< "[excrtption key(>0)]"
+		<< "[excrtption key(>0)]\n"
+		<< '\n'
+		<< "./pngProcessor.exe filename.png P[pipeline] s:15 t:1.5 H:0,1.1,0.9[steps]\n"
+		<< "[pipeline]\n"
+		<< "[steps(mode:param1,param2,param3 in order, missing params use DF)]\n"
+		<< "[modes(z Z a s S t T r R v V H f F m, l:file.cube)]\n"
+		<< '\n'
+		<< "./pngProcessor.exe folder t 1.5 | \"folder/*.png\" P s:15 t:1.5 | @list.txt v 0.2\n"
+		<< "[batch: a folder, a wildcard filename or @ a text file with one path per line]\n"
+		<< "[any mode usable as a pipeline step, or P with its steps]\n"
+		<< '\n'
+		<< "./pngProcessor.exe filename.png t 1.5 --level=fast\n"
+		<< "[--level: png compression of the results, anywhere in the command line]\n"
+		<< "[level(0 to 4 or store, rle, fast, normal:DF, best)]\n"
+		<< '\n'
+		<< "./pngProcessor.exe filename.png P s:15 t:1.5 --stream\n"
+		<< "[--stream: decode, process and encode in row bands, memory is bounded by the band height]\n"
+		<< "[modes(s S t T r R v V H f F l) and non-interlaced input, on by itself above 1GB of pixels]"
 		<< std::endl;
 #endif // FUNC_LIMIT
 }
@@ -315,6 +782,32 @@ void PngProcessingTools::commandStartUps(int32_t argCount, STR argValues[])
 
 	timer.TimerStart();
 
+	//options may stand anywhere, the positional parameters keep their order
+	std::vector<STR> arguments;
+	for (int32_t i = 0; i < argCount; ++i)
+	{
+		const std::string argument = argValues[i];
+
+		if (i > 0 && argument.rfind("--level=", 0) == 0)
+		{
+			CompressionLevel level = CompressionLevel::normal;
+
+			if (parseCompressionLevel(argument.substr(8u), level))
+				setCompressionLevel(level);
+			else
+				std::cout << "Unknown compression level:" << argument.substr(8u) << ", normal is used.\n";
+		}
+		else
+			if (i > 0 && argument == "--stream")
+			{
+				setStreaming(true);
+			}
+			else
+				arguments.push_back(argValues[i]);
+	}
+	argCount = static_cast<int32_t>(arguments.size());
+	argValues = arguments.data();
+
 	if (argCount == 1)
 	{
 		std::cout << "No image or parameters entered!\n";
@@ -353,6 +846,91 @@ void PngProcessingTools::commandStartUps(int32_t argCount, STR argValues[])
 			iss >> target;
 		};
 
+#if !FUNC_LIMIT
+	//a single mode becomes one pipeline step with its parameters
+	auto GetSteps = [&mode, &argCount, &argValues]() {
+		std::vector<std::string> steps;
+
+		if (mode == (char)Mode::Pipeline)
+		{
+			for (int32_t i = 3; i < argCount; ++i)
+			{
+				steps.emplace_back(argValues[i]);
+			}
+		}
+		else
+		{
+			std::string step(1u, mode);
+
+			for (int32_t i = 3; i < argCount; ++i)
+			{
+				step.append((i == 3) ? ":" : ",").append(argValues[i]);
+			}
+			steps.push_back(step);
+		}
+		return steps;
+		};
+
+	if (isBatchInput(pngfile))
+	{
+		std::vector<std::string> steps = GetSteps();
+
+		auto files = collectBatchFiles(pngfile);
+		const size_t failures = PngProcessingTools::batchProgram(files, steps);
+
+		timer.TimerStop();
+
+		std::cout << "End processing . . .\n"
+			<< "Time used:" << timer.getTime() << "(second).\n" << std::endl;
+
+		if (failures)
+			exit(1);
+		return;
+	}
+
+	//a streamable single mode on a big image or with --stream runs as a one step pipeline
+	if (mode != (char)Mode::Pipeline)
+	{
+		std::vector<std::string> steps = GetSteps();
+		std::vector<PipelineStep> pipeline(1u);
+		bool parsed = false;
+
+		try
+		{
+			parsed = parsePipelineStep(steps.front(), pipeline.front());
+		}
+		catch (const std::exception&)
+		{
+			parsed = false;
+		}
+
+		//the cube file of l has been read here, why it failed is already reported
+		if (!parsed && mode == (char)Mode::colorCube && argCount > 3)
+			exit(0);
+
+		if (parsed && pipelineHalo(pipeline) >= 0 && shouldStream(pngfile, pipeline))
+		{
+			//the name stays the one of the single mode, only the color type can't be picked from the whole image
+			std::cout << "Streaming:\n"
+				<< "Adoption step:" << pipeline.front().mode << " " << pipeline.front().param[0] << "," << pipeline.front().param[1] << "," << pipeline.front().param[2] << '\n'
+				<< "The result is written as RGBA8, the color type is not reduced when streaming.\n"
+				<< "Start processing . . ." << std::endl;
+
+			if (!streamPipeline(pipeline, pngfile, singleResultName(pipeline.front(), steps.front(), pngfile)))
+			{
+				std::cout << "Something wrong in convert." << std::endl;
+				exit(0);
+			}
+
+			timer.TimerStop();
+
+			std::cout << "End processing . . .\n"
+				<< "Time used:" << timer.getTime() << "(second).\n" << std::endl;
+			return;
+		}
+	}
+#endif
+
 	switch (mode)
 	{
 #if !FUNC_LIMIT
@@ -415,6 +993,23 @@ void PngProcessingTools::commandStartUps(int32_t argCount, STR argValues[])
 		PngProcessingTools::zoomProgramBicubicConvolution(param1, pngfile, param2);
 		break;
 
+	case (int)Mode::areaMinification:
+		param1 = 0.25f;
+		exponent = (uint32_t)ImageProcessingTools::MinifyFilter::lanczos3;
+
+		if (argCount > 3)
+		{
+			GetParam(3, param1);
+
+			if (argCount > 4)
+			{
+				GetParam(4, exponent);
+			}
+		}
+
+		PngProcessingTools::zoomProgramMinification(param1, pngfile, exponent);
+		break;
+
 	case (int)Mode::sharpen:
 		param1 = 15.0f;
 
@@ -642,12 +1237,66 @@ void PngProcessingTools::commandStartUps(int32_t argCount, STR argValues[])
 	case (int)Mode::InterlacedScanning:
 		PngProcessingTools::interlacedScanningProgram(pngfile);
 		break;
-#endif
-	case (int)Mode::encryption:
-	case (int)Mode::Encryption:
-		if (argCount > 3)
+
+	case (int)Mode::colorCube:
+		if (argCount <= 3)
 		{
-			GetParam(3, keywords);
+			std::cout << "No cube file,Wrong!" << std::endl;
+			exit(0);
+		}
+
+		pngfile2 = argValues[3];
+		PngProcessingTools::colorCubeProgram(pngfile2, pngfile);
+		break;
+
+	case (int)Mode::ColorCube:
+	{
+		exponent = 33u;
+
+		if (argCount > 3)
+		{
+			GetParam(3, exponent);
+		}
+
+		std::vector<std::string> steps;
+
+		for (int32_t i = 4; i < argCount; ++i)
+		{
+			steps.emplace_back(argValues[i]);
+		}
+
+		if (steps.empty())
+		{
+			std::cout << "No steps to bake,Wrong!" << std::endl;
+			exit(0);
+		}
+		PngProcessingTools::colorCubeBakeProgram(exponent, steps, pngfile);
+		break;
+	}
+
+	case (int)Mode::Pipeline:
+	{
+		std::vector<std::string> steps;
+
+		for (int32_t i = 3; i < argCount; ++i)
+		{
+			steps.emplace_back(argValues[i]);
+		}
+
+		if (steps.empty())
+		{
+			std::cout << "No pipeline steps,Wrong!" << std::endl;
+			exit(0);
+		}
+		PngProcessingTools::pipelineProgram(steps, pngfile);
+		break;
+	}
+#endif
+	case (int)Mode::encryption:
+	case (int)Mode::Encryption:
+		if (argCount > 3)
+		{
+			GetParam(3, keywords);
 			key = fnv1a32(keywords.data(), keywords.length(), key);
 		}
 
@@ -684,7 +1333,7 @@ void PngProcessingTools::zoomProgramDefault(float32_t& zoomRatio, std::filesyste
 	TextureData image, result;
 	importFile(image, pngfile);
 
-	zoomRatio = Max(1.0f / Max(1.0f, image.width, image.height), zoomRatio);//the real scale
+	zoomRatio = Max(1.0f / Max(1.0f, static_cast<float32_t>(image.width), static_cast<float32_t>(image.height)), zoomRatio);//the real scale
 	std::cout << "Real adoption zoom factor:" << zoomRatio << '\n';
 
 	if (ImageProcessingTools::Zoom_Default(image, result, zoomRatio, threshold, exponent))
@@ -698,15 +1347,8 @@ void PngProcessingTools::zoomProgramDefault(float32_t& zoomRatio, std::filesyste
 			.append(L"_Exponent_Mode_").append(std::to_wstring((uint32_t)exponent))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(result.getRGBA_uint8().data()), result.width, result.height, resultname);
-#else
-		//load result into stream to save to file
-		result.loadRGBAtoByteStream();
-		result.clearRGBA_uint8();
-
-		exportFile(result, resultname);
-#endif
+		//interpolation leaves far more than 256 colors
+		exportFile(result, resultname, LodePNGColorType::LCT_RGBA, 8u, EncoderHints::ManyColors());
 	}
 	else
 	{
@@ -733,7 +1375,7 @@ void PngProcessingTools::zoomProgramBicubicConvolution(float32_t& zoomRatio, std
 	TextureData image, result;
 	importFile(image, pngfile);
 
-	zoomRatio = Max(1.0f / Max(1.0f, image.width, image.height), zoomRatio);//the real scale
+	zoomRatio = Max(1.0f / Max(1.0f, static_cast<float32_t>(image.width), static_cast<float32_t>(image.height)), zoomRatio);//the real scale
 	std::cout << "Real adoption zoom factor:" << zoomRatio << '\n';
 
 	if (ImageProcessingTools::Zoom_BicubicConvolutionSampling4x4(image, result, zoomRatio, a))
@@ -746,15 +1388,49 @@ void PngProcessingTools::zoomProgramBicubicConvolution(float32_t& zoomRatio, std
 			.append(L"_bicubicFactor_").append(std::to_wstring(a))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(result.getRGBA_uint8().data()), result.width, result.height, resultname);
-#else
-		//load result into stream to save to file
-		result.loadRGBAtoByteStream();
-		result.clearRGBA_uint8();
+		//interpolation leaves far more than 256 colors
+		exportFile(result, resultname, LodePNGColorType::LCT_RGBA, 8u, EncoderHints::ManyColors());
+	}
+	else
+	{
+		std::cout << "Something wrong in convert." << std::endl;
+		exit(0);
+	}
+}
 
-		exportFile(result, resultname);
-#endif
+void PngProcessingTools::zoomProgramMinification(float32_t& zoomRatio, std::filesystem::path& pngfile, uint32_t& filter)
+{
+	std::cout << "Area Minification:\n"
+		<< "Input zoom factor:" << zoomRatio << '\n';
+
+	Clamp(zoomRatio, 0.0000001f, 1.0f);
+	std::cout << "Adoption zoom factor:" << zoomRatio << '\n';
+
+	std::cout << "Input filter:" << filter << '\n';
+
+	Clamp(filter, 0u, 1u);
+
+	std::cout << "Adoption filter:" << ((filter == (uint32_t)MinifyFilter::lanczos3) ? "Lanczos-3" : "Area average") << '\n'
+		<< "Start processing . . ." << std::endl;
+
+	TextureData image, result;
+	importFile(image, pngfile);
+
+	zoomRatio = Max(1.0f / Max(1.0f, static_cast<float32_t>(image.width), static_cast<float32_t>(image.height)), zoomRatio);//the real scale
+	std::cout << "Real adoption zoom factor:" << zoomRatio << '\n';
+
+	if (ImageProcessingTools::Zoom_Minification(image, result, zoomRatio, (MinifyFilter)filter))
+	{
+		image.clear();
+
+		std::wstring resultname;
+		resultname.append(pngfile.parent_path()).append(L"/").append(pngfile.stem())
+			.append(L"_Minify_x").append(std::to_wstring(zoomRatio))
+			.append((filter == (uint32_t)MinifyFilter::lanczos3) ? L"_lanczos3" : L"_area")
+			.append(pngfile.extension());
+
+		//interpolation leaves far more than 256 colors
+		exportFile(result, resultname, LodePNGColorType::LCT_RGBA, 8u, EncoderHints::ManyColors());
 	}
 	else
 	{
@@ -785,15 +1461,7 @@ void PngProcessingTools::laplaceSharpenProgram(float32_t& sharpenRatio, std::fil
 			.append(L"_L_sharpen_x").append(std::to_wstring(sharpenRatio))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(result.getRGBA_uint8().data()), result.width, result.height, resultname);
-#else
-		//load result into stream to save to file
-		result.loadRGBAtoByteStream();
-		result.clearRGBA_uint8();
-
 		exportFile(result, resultname);
-#endif
 	}
 	else
 	{
@@ -824,15 +1492,7 @@ void PngProcessingTools::gaussLaplaceSharpenProgram(float32_t& sharpenRatio, std
 			.append(L"_GL_sharpen_x").append(std::to_wstring(sharpenRatio))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(result.getRGBA_uint8().data()), result.width, result.height, resultname);
-#else
-		//load result into stream to save to file
-		result.loadRGBAtoByteStream();
-		result.clearRGBA_uint8();
-
 		exportFile(result, resultname);
-#endif
 	}
 	else
 	{
@@ -861,15 +1521,7 @@ void PngProcessingTools::hdrToneMappingColorProgram(float32_t& lumRatio, std::fi
 			.append(L"_toneMapping_x").append(std::to_wstring(lumRatio))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(image.getRGBA_uint8().data()), image.width, image.height, resultname);
-#else
-		//load result into stream to save to file
-		image.loadRGBAtoByteStream();
-		image.clearRGBA_uint8();
-
 		exportFile(image, resultname);
-#endif
 	}
 	else
 	{
@@ -893,15 +1545,7 @@ void PngProcessingTools::reverseColorProgram(std::filesystem::path& pngfile)
 			.append(L"_reverse")
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(image.getRGBA_uint8().data()), image.width, image.height, resultname);
-#else
-		//load result into stream to save to file
-		image.loadRGBAtoByteStream();
-		image.clearRGBA_uint8();
-
 		exportFile(image, resultname);
-#endif
 	}
 	else
 	{
@@ -950,7 +1594,7 @@ void PngProcessingTools::channelGrayColorProgram(std::filesystem::path& pngfile)
 
 	if (ImageProcessingTools::ChannelGrayScale(image, imageR, imageG, imageB))
 	{
-		image.clearImage();
+		image.clear();
 
 		std::wstring resultnameR;
 		std::wstring resultnameG;
@@ -1012,15 +1656,7 @@ void PngProcessingTools::vividnessAdjustmentColorProgram(float32_t& VividRatio,
 			.append(L"_vivid_x").append(std::to_wstring(VividRatio))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(image.getRGBA_uint8().data()), image.width, image.height, resultname);
-#else
-		//load result into stream to save to file
-		image.loadRGBAtoByteStream();
-		image.clearRGBA_uint8();
-
 		exportFile(image, resultname);
-#endif
 	}
 	else
 	{
@@ -1049,15 +1685,7 @@ void PngProcessingTools::natualvividnessAdjustmentColorProgram(float32_t& VividR
 			.append(L"_natualVivid_x").append(std::to_wstring(VividRatio))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(image.getRGBA_uint8().data()), image.width, image.height, resultname);
-#else
-		//load result into stream to save to file
-		image.loadRGBAtoByteStream();
-		image.clearRGBA_uint8();
-
 		exportFile(image, resultname);
-#endif
 	}
 	else
 	{
@@ -1088,7 +1716,7 @@ void PngProcessingTools::binarizationColorProgram(float32_t& threshold, std::fil
 			.append(L"_binarization_").append(std::to_wstring(threshold))
 			.append(pngfile.extension());
 
-		exportFile(result.image.data(), result.width, result.height, resultname, LodePNGColorType::LCT_GREY);
+		exportFile(result.image.data(), result.width, result.height, resultname, LodePNGColorType::LCT_GREY, 8u, EncoderHints::Grey(1u));
 	}
 	else
 	{
@@ -1119,7 +1747,7 @@ void PngProcessingTools::quaternizationColorProgram(float32_t& threshold, std::f
 			.append(L"_quaternization_").append(std::to_wstring(threshold))
 			.append(pngfile.extension());
 
-		exportFile(result.image.data(), result.width, result.height, resultname, LodePNGColorType::LCT_GREY);
+		exportFile(result.image.data(), result.width, result.height, resultname, LodePNGColorType::LCT_GREY, 8u, EncoderHints::Grey(2u));
 	}
 	else
 	{
@@ -1145,7 +1773,7 @@ void PngProcessingTools::hexadecimalizationColorProgram(std::filesystem::path& p
 			.append(L"_hexadecimalization")
 			.append(pngfile.extension());
 
-		exportFile(result.image.data(), result.width, result.height, resultname, LodePNGColorType::LCT_GREY);
+		exportFile(result.image.data(), result.width, result.height, resultname, LodePNGColorType::LCT_GREY, 8u, EncoderHints::Grey(4u));
 	}
 	else
 	{
@@ -1362,15 +1990,7 @@ void PngProcessingTools::surfaceBlurfilterProgram(float32_t& threshold, std::fil
 			.append(L"_radius_").append(std::to_wstring(radius))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(result.getRGBA_uint8().data()), result.width, result.height, resultname);
-#else
-		//load result into stream to save to file
-		result.loadRGBAtoByteStream();
-		result.clearRGBA_uint8();
-
 		exportFile(result, resultname);
-#endif
 	}
 	else
 	{
@@ -1418,15 +2038,7 @@ void PngProcessingTools::sobelEdgeEnhancementProgram(float32_t& strength, std::f
 			.append(L"_strength_").append(std::to_wstring(strength))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(result.getRGBA_uint8().data()), result.width, result.height, resultname);
-#else
-		//load result into stream to save to file
-		result.loadRGBAtoByteStream();
-		result.clearRGBA_uint8();
-
 		exportFile(result, resultname);
-#endif
 	}
 	else
 	{
@@ -1455,15 +2067,7 @@ void PngProcessingTools::mosaicPixelationProgram(uint32_t& sideLength, std::file
 			.append(L"_mosaic_").append(std::to_wstring(sideLength))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(image.getRGBA_uint8().data()), image.width, image.height, resultname);
-#else
-		//load result into stream to save to file
-		image.loadRGBAtoByteStream();
-		image.clearRGBA_uint8();
-
 		exportFile(image, resultname);
-#endif
 	}
 	else
 	{
@@ -1553,15 +2157,7 @@ void PngProcessingTools::pixelToRGB8_3x3Program(float32_t& brightness, std::file
 			.append(L"_rgb3x3").append(std::to_wstring(brightness))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(result.getRGBA_uint8().data()), result.width, result.height, resultname);
-#else
-		//load result into stream to save to file
-		result.loadRGBAtoByteStream();
-		result.clearRGBA_uint8();
-
 		exportFile(result, resultname);
-#endif
 	}
 	else
 	{
@@ -1622,15 +2218,7 @@ void PngProcessingTools::encryption_xorProgram(uint32_t& xorKey, std::filesystem
 			.append(L"_encryption_key_").append(useDefaultXorKey ? L"default" : std::to_wstring(xorKey))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(image.getRGBA_uint8().data()), image.width, image.height, resultname);
-#else
-		//load result into stream to save to file
-		image.loadRGBAtoByteStream();
-		image.clearRGBA_uint8();
-
 		exportFile(image, resultname);
-#endif
 	}
 	else
 	{
@@ -1661,19 +2249,818 @@ void PngProcessingTools::hslAdjustMentProgram(float32_t& hueChange, float32_t& s
 			.append(L"_hsl_h_").append(std::to_wstring(hueChange)).append(L"_s_").append(std::to_wstring(saturationRatio)).append(L"_l_").append(std::to_wstring(lightnessRatio))
 			.append(pngfile.extension());
 
-#if LITTLE_ENDIAN
-		exportFile(reinterpret_cast<byte*>(image.getRGBA_uint8().data()), image.width, image.height, resultname);
-#else
-		//load result into stream to save to file
-		image.loadRGBAtoByteStream();
-		image.clearRGBA_uint8();
+		exportFile(image, resultname);
+	}
+	else
+	{
+		std::cout << "Something wrong in convert." << std::endl;
+		exit(0);
+	}
+}
+
+void PngProcessingTools::colorCubeProgram(std::filesystem::path& cubefile, std::filesystem::path& pngfile)
+{
+	std::cout << "Color Cube:\n"
+		<< "Input cube file:" << cubefile << std::endl;
+
+	ColorCube cube;
+	if (!readCubeFile(cubefile, cube))
+		exit(0);
+
+	std::cout << "Adoption cube size:" << cube.size << "\n"
+		<< "Start processing . . ." << std::endl;
+
+	TextureData image;
+	importFile(image, pngfile);
+
+	if (ImageProcessingTools::ColorCubeTransform(image, cube))
+	{
+		std::wstring resultname;
+		resultname.append(pngfile.parent_path()).append(L"/").append(pngfile.stem())
+			.append(L"_cube_").append(cubefile.stem().wstring())
+			.append(pngfile.extension());
 
 		exportFile(image, resultname);
+	}
+	else
+	{
+		std::cout << "Something wrong in convert." << std::endl;
+		exit(0);
+	}
+}
+
+void PngProcessingTools::colorCubeBakeProgram(uint32_t& cubeSize, std::vector<std::string>& steps, std::filesystem::path& pngfile)
+{
+	std::cout << "Color Cube Bake:\n"
+		<< "Input cube size:" << cubeSize << std::endl;
+
+	Clamp(cubeSize, ColorCube::minSize, ColorCube::maxSize);
+	std::cout << "Adoption cube size:" << cubeSize << std::endl;
+
+	std::vector<PipelineStep> pipeline;
+	std::wstring stepsName;
+	parsePipeline(steps, pipeline, stepsName);
+
+	std::vector<PointOperation> chain(pipeline.size());
+	for (size_t i = 0u; i < pipeline.size(); ++i)
+	{
+		if (!pointOperationOf(pipeline[i], chain[i]))
+		{
+			std::cout << "Only t T v V H r R steps can be baked:" << steps[i] << ",Wrong!" << std::endl;
+			exit(0);
+		}
+	}
+
+	std::cout << "Start processing . . ." << std::endl;
+
+	const ColorCube cube = ImageProcessingTools::PointOperationCube(chain, cubeSize);
+
+	std::wstring basename;
+	basename.append(pngfile.parent_path()).append(L"/").append(pngfile.stem())
+		.append(L"_cube_").append(std::to_wstring(cubeSize)).append(stepsName);
+
+	//the .cube can grade other images with l, or a batch of them
+	std::wstring cubename = basename + L".cube";
+	if (!writeCubeFile(cube, cubename, AdaptString::toString(pngfile.stem().wstring() + stepsName)))
+		exit(0);
+
+	std::cout << "=> Cube filename:" << AdaptString::toString(cubename) << std::endl;
+
+	TextureData image;
+	importFile(image, pngfile);
+
+	if (ImageProcessingTools::ColorCubeTransform(image, cube))
+	{
+		std::wstring resultname = basename;
+		resultname.append(pngfile.extension());
+
+		exportFile(image, resultname);
+	}
+	else
+	{
+		std::cout << "Something wrong in convert." << std::endl;
+		exit(0);
+	}
+}
+
+bool PngProcessingTools::parsePipelineStep(const std::string& text, PipelineStep& step)
+{
+	if (text.empty())
+		return false;
+
+	step.mode = text.front();
+
+	//l:file.cube, all of the text after ':' is the path
+	if (step.mode == (char)Mode::colorCube)
+	{
+		if (text.size() < 3u || text[1] != ':')
+			return false;
+
+		auto cube = std::make_shared<ColorCube>();
+		if (!readCubeFile(std::filesystem::path(text.substr(2u)), *cube))
+			return false;
+
+		step.cube = cube;
+		return true;
+	}
+
+	//the same defaults as the single modes
+	switch (step.mode)
+	{
+	case (int)Mode::zoom:
+		step.param[0] = 0.5f; step.param[1] = 1.0f; step.param[2] = 1.0f;
+		break;
+	case (int)Mode::Zoom:
+		step.param[0] = 2.0f; step.param[1] = -0.5f;
+		break;
+	case (int)Mode::areaMinification:
+		step.param[0] = 0.25f; step.param[1] = (float32_t)ImageProcessingTools::MinifyFilter::lanczos3;
+		break;
+	case (int)Mode::sharpen:
+	case (int)Mode::Sharpen:
+		step.param[0] = 15.0f;
+		break;
+	case (int)Mode::toneMapping:
+	case (int)Mode::ToneMapping:
+		step.param[0] = 1.0f;
+		break;
+	case (int)Mode::reverseColor:
+	case (int)Mode::ReverseColor:
+		break;
+	case (int)Mode::vividness:
+	case (int)Mode::Vividness:
+		step.param[0] = 0.2f;
+		break;
+	case (int)Mode::HSLAdjustment:
+		step.param[0] = 0.0f; step.param[1] = 1.0f; step.param[2] = 1.0f;
+		break;
+	case (int)Mode::filter:
+		step.param[0] = 0.0f; step.param[1] = 1.0f; step.param[2] = 1.0f;
+		break;
+	case (int)Mode::Filter:
+		step.param[0] = 0.5f; step.param[1] = 1.0f;
+		break;
+	case (int)Mode::mosaicPixelation:
+		step.param[0] = 4.0f;
+		break;
+	default:
+		return false;
+	}
+
+	if (text.size() > 1u)
+	{
+		if (text[1] != ':')
+			return false;
+
+		std::istringstream iss(text.substr(2u));
+		std::string item;
+
+		for (size_t i = 0u; (i < 3u) && std::getline(iss, item, ','); ++i)
+		{
+			if (!item.empty())
+				step.param[i] = std::stof(item);
+		}
+	}
+
+	//the same limits as the single modes
+	switch (step.mode)
+	{
+	case (int)Mode::zoom:
+		Clamp(step.param[0], 0.0000001f, 32.0f);
+		Clamp(step.param[1], 0.0f, 1.0f);
+		Clamp(step.param[2], 1.0f, 3.0f);
+		break;
+	case (int)Mode::Zoom:
+		Clamp(step.param[0], 0.0000001f, 32.0f);
+		Clamp(step.param[1], -3.0f, -0.1f);
+		break;
+	case (int)Mode::areaMinification:
+		Clamp(step.param[0], 0.0000001f, 1.0f);
+		Clamp(step.param[1], 0.0f, 1.0f);
+		break;
+	case (int)Mode::sharpen:
+	case (int)Mode::Sharpen:
+		Clamp(step.param[0], 1.0f, 1000.0f);
+		break;
+	case (int)Mode::toneMapping:
+	case (int)Mode::ToneMapping:
+		Clamp(step.param[0], 0.1f, 16.0f);
+		break;
+	case (int)Mode::vividness:
+		Clamp(step.param[0], -1.0f, 254.0f);
+		break;
+	case (int)Mode::Vividness:
+		Clamp(step.param[0], -1.0f, 1.0f);
+		break;
+	case (int)Mode::HSLAdjustment:
+		Clamp(step.param[0], -360.0f, 360.0f);
+		step.param[1] = Max(step.param[1], 0.0f);
+		step.param[2] = Max(step.param[2], 0.0f);
+		break;
+	case (int)Mode::filter:
+		Clamp(step.param[0], 0.0f, 1.0f);
+		Clamp(step.param[1], 0.0f, 1.0f);
+		if (step.param[0] >= step.param[1])
+		{
+			step.param[0] = 0.0f;
+			step.param[1] = 1.0f;
+		}
+		Clamp(step.param[2], 0.05f, 10.0f);
+		break;
+	case (int)Mode::Filter:
+		Clamp(step.param[0], ColorPixTofloat, 1.0f);
+		Clamp(step.param[1], 1.0f, 24.0f);
+		break;
+	case (int)Mode::mosaicPixelation:
+		Clamp(step.param[0], 2.0f, 512.0f);
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+void PngProcessingTools::parsePipeline(std::vector<std::string>& steps, std::vector<PipelineStep>& pipeline, std::wstring& stepsName)
+{
+	pipeline.resize(steps.size());
+
+	for (size_t i = 0u; i < steps.size(); ++i)
+	{
+		bool parsed = false;
+
+		try
+		{
+			parsed = parsePipelineStep(steps[i], pipeline[i]);
+		}
+		catch (const std::exception&)
+		{
+			parsed = false;
+		}
+
+		if (!parsed)
+		{
+			std::cout << "Unknown pipeline step:" << steps[i] << ",Wrong!" << std::endl;
+			exit(0);
+		}
+
+		const PipelineStep& step = pipeline[i];
+
+		//a path has no place in a filename, the stem of the cube file stands for it
+		if (step.mode == (char)Mode::colorCube)
+		{
+			const std::filesystem::path cubefile(steps[i].substr(2u));
+			std::cout << "Adoption step " << (i + 1u) << ':' << step.mode << " " << cubefile << " size " << step.cube->size << '\n';
+
+			stepsName.append(L"_l_").append(cubefile.stem().wstring());
+			continue;
+		}
+
+		std::cout << "Adoption step " << (i + 1u) << ':' << step.mode
+			<< " " << step.param[0] << "," << step.param[1] << "," << step.param[2] << '\n';
+
+		//':' is not allowed in a filename
+		stepsName.append(L"_");
+		for (const char& c : steps[i])
+		{
+			if (c != ':')
+				stepsName.push_back((c == ',') ? L'_' : static_cast<wchar_t>(c));
+		}
+	}
+}
+
+bool PngProcessingTools::runPipeline(TextureData& image, const std::vector<PipelineStep>& pipeline)
+{
+	TextureData result;
+
+	//consecutive point-wise steps are collected and run as one pass
+	std::vector<PointOperation> chain;
+
+	auto FlushChain = [&chain, &image]() {
+		if (!chain.empty())
+		{
+			bool done = ImageProcessingTools::PointOperationChain(image, chain);
+			chain.clear();
+			return done;
+		}
+		return true;
+		};
+
+	bool done = true;
+
+	for (const PipelineStep& step : pipeline)
+	{
+		PointOperation operation;
+
+		if (pointOperationOf(step, operation))
+		{
+			chain.push_back(operation);
+			continue;
+		}
+
+		done = FlushChain();
+
+		//the real scale depends on the size reached so far
+		const float32_t minScale = 1.0f / Max(1.0f, static_cast<float32_t>(image.width), static_cast<float32_t>(image.height));
+
+		switch (step.mode)
+		{
+		case (int)Mode::zoom:
+			done = done && ImageProcessingTools::Zoom_Default(image, result, Max(minScale, step.param[0]), step.param[1], (Exponent)static_cast<uint32_t>(step.param[2]));
+			std::swap(image, result);
+			break;
+		case (int)Mode::Zoom:
+			done = done && ImageProcessingTools::Zoom_BicubicConvolutionSampling4x4(image, result, Max(minScale, step.param[0]), step.param[1]);
+			std::swap(image, result);
+			break;
+		case (int)Mode::areaMinification:
+			done = done && ImageProcessingTools::Zoom_Minification(image, result, Max(minScale, step.param[0]), (MinifyFilter)static_cast<uint32_t>(step.param[1]));
+			std::swap(image, result);
+			break;
+		case (int)Mode::sharpen:
+			done = done && ImageProcessingTools::SharpenLaplace3x3(image, result, step.param[0]);
+			std::swap(image, result);
+			break;
+		case (int)Mode::Sharpen:
+			done = done && ImageProcessingTools::SharpenGaussLaplace5x5(image, result, step.param[0]);
+			std::swap(image, result);
+			break;
+		case (int)Mode::filter:
+			done = done && ImageProcessingTools::SobelEdgeEnhancement(image, result, step.param[0], step.param[1], step.param[2]);
+			std::swap(image, result);
+			break;
+		case (int)Mode::Filter:
+			done = done && ImageProcessingTools::SurfaceBlur(image, result, static_cast<int32_t>(step.param[1]), step.param[0]);
+			std::swap(image, result);
+			break;
+		case (int)Mode::mosaicPixelation:
+			done = done && ImageProcessingTools::MosaicPixelation(image, static_cast<uint32_t>(step.param[0]));
+			break;
+		case (int)Mode::colorCube:
+			done = done && ImageProcessingTools::ColorCubeTransform(image, *step.cube);
+			break;
+		default:
+			break;
+		}
+
+		if (!done)
+			return false;
+	}
+
+	return FlushChain();
+}
+
+bool PngProcessingTools::pointOperationOf(const PipelineStep& step, PointOperation& operation)
+{
+	switch (step.mode)
+	{
+	case (int)Mode::toneMapping:
+	case (int)Mode::ToneMapping:
+		operation.kind = PointOperation::Kind::toneMapping;
+		break;
+	case (int)Mode::vividness:
+		operation.kind = PointOperation::Kind::vividness;
+		break;
+	case (int)Mode::Vividness:
+		operation.kind = PointOperation::Kind::natualVividness;
+		break;
+	case (int)Mode::HSLAdjustment:
+		operation.kind = PointOperation::Kind::hslAdjustment;
+		break;
+	case (int)Mode::reverseColor:
+	case (int)Mode::ReverseColor:
+		operation.kind = PointOperation::Kind::reverseColor;
+		break;
+	default:
+		return false;
+	}
+
+	std::copy(step.param, step.param + 3, operation.param);
+	return true;
+}
+
+int32_t PngProcessingTools::pipelineHalo(const std::vector<PipelineStep>& pipeline)
+{
+	int32_t halo = 0;
+
+	for (const PipelineStep& step : pipeline)
+	{
+		switch (step.mode)
+		{
+		case (int)Mode::toneMapping:
+		case (int)Mode::ToneMapping:
+		case (int)Mode::vividness:
+		case (int)Mode::Vividness:
+		case (int)Mode::HSLAdjustment:
+		case (int)Mode::reverseColor:
+		case (int)Mode::ReverseColor:
+		case (int)Mode::colorCube:
+			break;
+		case (int)Mode::sharpen:
+		case (int)Mode::filter:
+			halo += 1;
+			break;
+		case (int)Mode::Sharpen:
+			halo += 2;
+			break;
+		case (int)Mode::Filter:
+			halo += static_cast<int32_t>(step.param[1]);
+			break;
+		default:
+			//zoom, minification and mosaic don't map output rows to nearby input rows
+			return -1;
+		}
+	}
+	return halo;
+}
+
+bool PngProcessingTools::shouldStream(const std::filesystem::path& pngfile, const std::vector<PipelineStep>& pipeline)
+{
+	if (pipelineHalo(pipeline) < 0)
+	{
+		if (streaming)
+			std::cout << "These steps can't be streamed, the image is processed whole." << std::endl;
+		return false;
+	}
+
+	//signature and IHDR are all lodepng_inspect needs
+	byte header[33] = {};
+	std::ifstream file(pngfile, std::ios::binary);
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+	uint32_t width = 0u, height = 0u;
+	LodePNGState state;
+	lodepng_state_init(&state);
+	uint32_t error = lodepng_inspect(&width, &height, &state, header, static_cast<size_t>(file.gcount()));
+	const uint32_t interlace = state.info_png.interlace_method;
+	lodepng_state_cleanup(&state);
+
+	if (error)
+		return false;
+
+	if (interlace != 0u)
+	{
+		if (streaming)
+			std::cout << "Adam7 interlaced images can't be streamed, the image is processed whole." << std::endl;
+		return false;
+	}
+
+	return streaming || ((static_cast<size_t>(width) * height) << 2u) > streamThreshold;
+}
+
+std::wstring PngProcessingTools::singleResultName(const PipelineStep& step, const std::string& text, const std::filesystem::path& pngfile)
+{
+	std::wstring resultname;
+	resultname.append(pngfile.parent_path()).append(L"/").append(pngfile.stem());
+
+	switch (step.mode)
+	{
+	case (int)Mode::sharpen:
+		resultname.append(L"_L_sharpen_x").append(std::to_wstring(step.param[0]));
+		break;
+	case (int)Mode::Sharpen:
+		resultname.append(L"_GL_sharpen_x").append(std::to_wstring(step.param[0]));
+		break;
+	case (int)Mode::toneMapping:
+	case (int)Mode::ToneMapping:
+		resultname.append(L"_toneMapping_x").append(std::to_wstring(step.param[0]));
+		break;
+	case (int)Mode::reverseColor:
+	case (int)Mode::ReverseColor:
+		resultname.append(L"_reverse");
+		break;
+	case (int)Mode::vividness:
+		resultname.append(L"_vivid_x").append(std::to_wstring(step.param[0]));
+		break;
+	case (int)Mode::Vividness:
+		resultname.append(L"_natualVivid_x").append(std::to_wstring(step.param[0]));
+		break;
+	case (int)Mode::HSLAdjustment:
+		resultname.append(L"_hsl_h_").append(std::to_wstring(step.param[0])).append(L"_s_").append(std::to_wstring(step.param[1])).append(L"_l_").append(std::to_wstring(step.param[2]));
+		break;
+	case (int)Mode::filter:
+		resultname.append(L"_sobelEdge_min_").append(std::to_wstring(step.param[0]))
+			.append(L"_max_").append(std::to_wstring(step.param[1]))
+			.append(L"_strength_").append(std::to_wstring(step.param[2]));
+		break;
+	case (int)Mode::Filter:
+		resultname.append(L"_surfaceBlur_").append(std::to_wstring(step.param[0]))
+			.append(L"_radius_").append(std::to_wstring(static_cast<int32_t>(step.param[1])));
+		break;
+	case (int)Mode::colorCube:
+		resultname.append(L"_cube_").append(std::filesystem::path(text.substr(2u)).stem().wstring());
+		break;
+	default:
+		break;
+	}
+	return resultname.append(pngfile.extension());
+}
+
+bool PngProcessingTools::streamPipeline(const std::vector<PipelineStep>& pipeline, const std::filesystem::path& pngfile, const std::wstring& resultname)
+{
+	auto path = AdaptString::toString(pngfile.wstring());
+	auto resultpath = AdaptString::toString(resultname);
+
+	clockTimer timer;
+	timer.TimerStart();
+
+	MappedFile mapped;
+	byte* buffer = nullptr;
+	size_t bufferSize = 0u;
+	uint32_t error = 0u;
+	const byte* input = nullptr;
+	size_t inputSize = 0u;
+
+	if (mapped.Open(pngfile))
+	{
+		input = mapped.data();
+		inputSize = mapped.size();
+	}
+	else
+	{
+		error = lodepng_load_file(&buffer, &bufferSize, path.c_str());
+		input = buffer;
+		inputSize = bufferSize;
+	}
+
+	LodePNGState decoder;
+	lodepng_state_init(&decoder);
+	decoder.info_raw.colortype = LodePNGColorType::LCT_RGBA;
+	decoder.info_raw.bitdepth = 8u;
+#ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
+	decoder.decoder.read_text_chunks = 0u;
+	decoder.decoder.remember_unknown_chunks = 0u;
 #endif
+
+	StreamBands bands;
+	bands.pipeline = &pipeline;
+	bands.halo = static_cast<uint32_t>(pipelineHalo(pipeline));
+
+	if (!error)
+		error = lodepng_inspect(&bands.width, &bands.height, &decoder, input, inputSize);
+
+	//the results are RGBA8 like exportFile gets them, without the statistics auto convert would need the whole image for
+	lodepng::State encoder;
+	encoder.info_raw.colortype = LodePNGColorType::LCT_RGBA;
+	encoder.info_raw.bitdepth = 8u;
+	encoder.info_png.color.colortype = LodePNGColorType::LCT_RGBA;
+	encoder.info_png.color.bitdepth = 8u;
+	applyCompressionLevel(compressionLevel, encoder.encoder);
+
+	std::ofstream file;
+	if (!error)
+	{
+		const size_t rowBytes = static_cast<size_t>(bands.width) << 2u;
+		bands.bandRows = static_cast<uint32_t>(min(static_cast<size_t>(bands.height), max(static_cast<size_t>(streamMinRows), streamBandBytes / max(rowBytes, size_t(1u)))));
+
+		file.open(std::filesystem::path(resultname), std::ios::binary | std::ios::trunc);
+		if (!file)
+			error = 79;//failed to open file for writing
+	}
+
+	if (!error)
+		error = lodepng_row_encoder_begin(&bands.encoder, bands.width, bands.height, &encoder, streamWrite, &file);
+
+	if (!error)
+	{
+		error = lodepng_decode_rows(&bands.width, &bands.height, &decoder, input, inputSize, bands.bandRows, streamRows, &bands);
+
+		//the encoder always frees itself, its error only counts when decoding went through
+		const uint32_t finishError = lodepng_row_encoder_finish(bands.encoder);
+		if (!error)
+			error = finishError;
+	}
+
+	file.close();
+	mapped.Close();
+	free(buffer);
+	lodepng_state_cleanup(&decoder);
+	timer.TimerStop();
+
+	//a stream that broke off leaves a file without its end
+	if (bands.failed || error)
+	{
+		std::error_code removeError;
+		std::filesystem::remove(std::filesystem::path(resultname), removeError);
+	}
+
+	if (bands.failed)
+		return false;
+
+	if (error)
+	{
+		if (bands.encoderError)
+			error = bands.encoderError;
+
+		std::cout << "Stream error " << error << ": " << lodepng_error_text(error) << std::endl;
+		return false;
+	}
+
+	std::cout << "=> Result filename:" << resultpath << '\n'
+		<< "=> stream time used:" << timer.getTime() << "(second), band rows:" << bands.bandRows << std::endl;
+	return true;
+}
+
+void PngProcessingTools::pipelineProgram(std::vector<std::string>& steps, std::filesystem::path& pngfile)
+{
+	std::cout << "Pipeline:\n";
+
+	std::vector<PipelineStep> pipeline;
+	std::wstring stepsName;
+	parsePipeline(steps, pipeline, stepsName);
+
+	std::cout << "Start processing . . ." << std::endl;
+
+	std::wstring resultname;
+	resultname.append(pngfile.parent_path()).append(L"/").append(pngfile.stem())
+		.append(L"_pipeline").append(stepsName)
+		.append(pngfile.extension());
+
+	if (shouldStream(pngfile, pipeline))
+	{
+		if (!streamPipeline(pipeline, pngfile, resultname))
+		{
+			std::cout << "Something wrong in convert." << std::endl;
+			exit(0);
+		}
+		return;
+	}
+
+	TextureData image;
+	importFile(image, pngfile);
+
+	if (runPipeline(image, pipeline))
+	{
+		exportFile(image, resultname);
 	}
 	else
 	{
 		std::cout << "Something wrong in convert." << std::endl;
 		exit(0);
 	}
+}
+
+bool PngProcessingTools::isBatchInput(const std::filesystem::path& input)
+{
+	const std::wstring text = input.wstring();
+	const std::wstring name = input.filename().wstring();
+
+	if (!text.empty() && text.front() == L'@')
+		return true;
+
+	if (name.find_first_of(L"*?") != std::wstring::npos)
+		return true;
+
+	std::error_code error;
+	return std::filesystem::is_directory(input, error);
+}
+
+std::vector<std::filesystem::path> PngProcessingTools::collectBatchFiles(const std::filesystem::path& input)
+{
+	std::vector<std::filesystem::path> files;
+	std::error_code error;
+
+	const std::wstring text = input.wstring();
+	const std::wstring name = input.filename().wstring();
+
+	if (!text.empty() && text.front() == L'@')
+	{
+		//one path per line
+		std::ifstream list(std::filesystem::path(text.substr(1u)));
+		std::string line;
+
+		while (std::getline(list, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			if (!line.empty())
+				files.emplace_back(line);
+		}
+		return files;
+	}
+
+	const bool isPattern = name.find_first_of(L"*?") != std::wstring::npos;
+	const std::filesystem::path directory = isPattern ? input.parent_path() : input;
+
+	for (const auto& entry : std::filesystem::directory_iterator(directory.empty() ? std::filesystem::path(L".") : directory, error))
+	{
+		if (!entry.is_regular_file(error))
+			continue;
+
+		const std::wstring fileName = entry.path().filename().wstring();
+
+		if (isPattern ? wildcardMatch(name.c_str(), fileName.c_str()) : isPngExtension(entry.path()))
+			files.push_back(entry.path());
+	}
+
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+size_t PngProcessingTools::batchProgram(std::vector<std::filesystem::path>& files, std::vector<std::string>& steps)
+{
+	std::cout << "Batch:\n"
+		<< "Input files:" << files.size() << '\n';
+
+	std::vector<PipelineStep> pipeline;
+	std::wstring stepsName;
+	parsePipeline(steps, pipeline, stepsName);
+
+	if (files.empty())
+	{
+		std::cout << "No input file,Wrong!" << std::endl;
+		exit(0);
+	}
+
+	std::cout << "Start processing . . ." << std::endl;
+
+	struct BatchItem
+	{
+		size_t index = 0u;
+		TextureData image;
+	};
+
+	//decode of file N+1 and encode of file N-1 overlap the processing of file N,
+	//the queues bound how many decoded images can wait in memory
+	BoundedQueue<BatchItem> decoded(batchQueueDepth);
+	BoundedQueue<BatchItem> processed(batchQueueDepth);
+
+	std::atomic<size_t> failures{ 0u };
+
+	std::thread decoder([&files, &decoded, &failures]() {
+		for (size_t i = 0u; i < files.size(); ++i)
+		{
+			BatchItem item;
+			item.index = i;
+
+			if (!decodeFile(item.image, files[i]))
+			{
+				std::cout << "=> skipped:" << files[i] << std::endl;
+				++failures;
+				continue;
+			}
+
+			if (!decoded.Push(std::move(item)))
+				break;
+		}
+		decoded.Close();
+		});
+
+	//encodeFile rather than exportFile, whose exit on an encoder error would end every thread and the other files with it
+	std::thread encoder([&files, &processed, &stepsName, &failures]() {
+		BatchItem item;
+
+		while (processed.Pop(item))
+		{
+			const std::filesystem::path& pngfile = files[item.index];
+
+			std::wstring resultname;
+			resultname.append(pngfile.parent_path()).append(L"/").append(pngfile.stem())
+				.append(L"_pipeline").append(stepsName)
+				.append(pngfile.extension());
+
+			const std::string path = AdaptString::toString(resultname);
+			clockTimer timer;
+
+			timer.TimerStart();
+			const uint32_t error = encodeFile(path, item.image.image.data(), item.image.width, item.image.height, LodePNGColorType::LCT_RGBA, 8u, EncoderHints());
+			timer.TimerStop();
+
+			if (error)
+			{
+				std::cout << "Encoder error " << error << ": " << lodepng_error_text(error) << '\n'
+					<< "=> not written:" << path << std::endl;
+				++failures;
+			}
+			else
+			{
+				std::cout << "=> Result filename:" << path << '\n' <<
+					"=> encode time used:" << timer.getTime() << "(second)" << std::endl;
+			}
+			item.image.clear();
+		}
+		});
+
+	BatchItem item;
+
+	while (decoded.Pop(item))
+	{
+		std::cout << "=> [" << (item.index + 1u) << "/" << files.size() << "] " << files[item.index] << std::endl;
+
+		if (!runPipeline(item.image, pipeline))
+		{
+			std::cout << "Something wrong in convert:" << files[item.index] << std::endl;
+			++failures;
+			continue;
+		}
+
+		processed.Push(std::move(item));
+	}
+	processed.Close();
+
+	decoder.join();
+	encoder.join();
+
+	std::cout << "Batch finished, failed files:" << failures.load() << std::endl;
+	return failures.load();
 }
\ No newline at end of file
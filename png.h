@@ -30,11 +30,25 @@ so you should also comply with the requirements of its header declaration
 #include "lodepng.h"
 #include "AdaptString.h"
 
+//what a program already knows about its result, so the encoder can skip or shorten the color statistics of auto convert
+struct EncoderHints
+{
+	bool known = false;//write colorType and bitdepth as they are, no statistics at all
+	LodePNGColorType colorType = LodePNGColorType::LCT_RGBA;
+	uint32_t bitdepth = 8u;
+	std::vector<byte> palette;//RGBA entries when colorType is LCT_PALETTE
+	bool manyColors = false;//a palette can't fit, only check grey and alpha
+
+	static EncoderHints Grey(const uint32_t& bitdepth);
+	static EncoderHints ManyColors();
+};
+
 class PngProcessingTools :public ImageProcessingTools
 {
 public:
 	enum class Mode :char
 	{
+		areaMinification = 'a',
 		binarization = 'b',
 		Binarization = 'B',
 		cut = 'c',
@@ -48,9 +62,12 @@ public:
 		hexadecimalization = 'h',
 		HSLAdjustment = 'H',
 		InterlacedScanning = 'i',
+		colorCube = 'l',
+		ColorCube = 'L',
 		mosaicPixelation = 'm',
 		MixedGraph = 'M',
 		pixelToRGB8_3x3 = 'p',
+		Pipeline = 'P',
 		quaternization = 'q',
 		Quaternization = 'Q',
 		reverseColor = 'r',
@@ -66,12 +83,51 @@ public:
 		unknown = '?'
 	};
 
+	//encoder presets for exportFile, from the fastest to the smallest file
+	enum class CompressionLevel :uint8_t
+	{
+		store = 0,//no compression, filter none
+		rle = 1,//runs at distance 1 only, filter up
+		fast = 2,//greedy matching on short hash chains
+		normal = 3,//the lodepng defaults
+		best = 4//full 32K window, long matches
+	};
+
+	//decoded or processed images a batch stage may hold before it waits for the next one
+	static constexpr size_t batchQueueDepth = 2u;
+
+	//RGBA bytes above which a streamable pipeline runs band by band even without --stream
+	static constexpr size_t streamThreshold = size_t(1u) << 30u;
+	//RGBA bytes of one streamed band, the band is never shorter than streamMinRows
+	static constexpr size_t streamBandBytes = size_t(16u) << 20u;
+	static constexpr uint32_t streamMinRows = 16u;
+
+	//one entry of the pipeline mode: a mode character and up to three parameters
+	struct PipelineStep
+	{
+		char mode = (char)Mode::unknown;
+		float32_t param[3] = { 0.0f, 0.0f, 0.0f };
+		//the table of an l step, read once when the step is parsed
+		std::shared_ptr<const ColorCube> cube;
+	};
+
 public:
 	static void help();
 	static void commandStartUps(int32_t argCount, STR argValues[]);
 
+	//the level every following exportFile encodes with
+	static void setCompressionLevel(const CompressionLevel& level);
+	static CompressionLevel getCompressionLevel();
+	//--stream: decode, process and encode streamable pipelines in row bands
+	static void setStreaming(const bool& enable);
+	static bool getStreaming();
+	static void applyCompressionLevel(const CompressionLevel& level, LodePNGEncoderSettings& settings);
+	//a digit 0-4 or the preset name
+	static bool parseCompressionLevel(const std::string& text, CompressionLevel& level);
+
 	static void zoomProgramDefault(float32_t& zoomRatio, std::filesystem::path& pngfile, float32_t& threshold, const Exponent& exponent = Exponent::one);
 	static void zoomProgramBicubicConvolution(float32_t& zoomRatio, std::filesystem::path& pngfile, float32_t& a);
+	static void zoomProgramMinification(float32_t& zoomRatio, std::filesystem::path& pngfile, uint32_t& filter);
 	static void laplaceSharpenProgram(float32_t& sharpenRatio, std::filesystem::path& pngfile);
 	static void gaussLaplaceSharpenProgram(float32_t& sharpenRatio, std::filesystem::path& pngfile);
 	static void hdrToneMappingColorProgram(float32_t& lumRatio, std::filesystem::path& pngfile);
@@ -93,13 +149,50 @@ public:
 	static void interlacedScanningProgram(std::filesystem::path& pngfile);
 	static void encryption_xorProgram(uint32_t& xorKey, std::filesystem::path& pngfile);
 	static void hslAdjustMentProgram(float32_t& hueChange, float32_t& saturationRatio, float32_t& lightnessRatio, std::filesystem::path& pngfile);
+	static void colorCubeProgram(std::filesystem::path& cubefile, std::filesystem::path& pngfile);
+	//bakes color steps into a cube of cubeSize^3 points, saves it as .cube and applies it
+	static void colorCubeBakeProgram(uint32_t& cubeSize, std::vector<std::string>& steps, std::filesystem::path& pngfile);
+	static void pipelineProgram(std::vector<std::string>& steps, std::filesystem::path& pngfile);
+	static void parsePipeline(std::vector<std::string>& steps, std::vector<PipelineStep>& pipeline, std::wstring& stepsName);
+	static bool parsePipelineStep(const std::string& text, PipelineStep& step);
+	static bool runPipeline(TextureData& image, const std::vector<PipelineStep>& pipeline);
+	//false if the step is not a point-wise color step
+	static bool pointOperationOf(const PipelineStep& step, PointOperation& operation);
 
-	//The following three methods rely on lodepng
+	//rows a pipeline reads above and below an output row, -1 if a step needs the whole image
+	static int32_t pipelineHalo(const std::vector<PipelineStep>& pipeline);
+	//a streamable pipeline on a non-interlaced file, with --stream or above streamThreshold
+	static bool shouldStream(const std::filesystem::path& pngfile, const std::vector<PipelineStep>& pipeline);
+	//the result name the single mode program of a streamable step gives, text is the step as GetSteps made it
+	static std::wstring singleResultName(const PipelineStep& step, const std::string& text, const std::filesystem::path& pngfile);
+	//memory is bounded by the band height plus the halo rows, not by the image size
+	static bool streamPipeline(const std::vector<PipelineStep>& pipeline, const std::filesystem::path& pngfile, const std::wstring& resultname);
+
+	//a directory, a wildcard filename or @list.txt runs the steps on every file, see batchProgram
+	static bool isBatchInput(const std::filesystem::path& input);
+	static std::vector<std::filesystem::path> collectBatchFiles(const std::filesystem::path& input);
+	//returns how many files could not be decoded, processed or written, the others are done either way
+	static size_t batchProgram(std::vector<std::filesystem::path>& files, std::vector<std::string>& steps);
+
+	//Adobe/Resolve .cube text with a 3D table, a 1D table is not supported
+	static bool readCubeFile(const std::filesystem::path& cubefile, ColorCube& cube);
+	//R G B only, the alpha table of the cube is not part of the format
+	static bool writeCubeFile(const ColorCube& cube, const std::wstring& cubename, const std::string& title);
+
+	//The following methods rely on lodepng
 	static void importFile(TextureData& data, std::filesystem::path& pngfile);
+	//reports the error and returns false instead of exiting
+	static bool decodeFile(TextureData& data, const std::filesystem::path& pngfile);
 	static void exportFile(TextureData& result, std::wstring& resultname,
-		const LodePNGColorType& colorType = LodePNGColorType::LCT_RGBA, const uint32_t& bitdepth = 8u);
+		const LodePNGColorType& colorType = LodePNGColorType::LCT_RGBA, const uint32_t& bitdepth = 8u, const EncoderHints& hints = EncoderHints());
 
 	static void exportFile(const byte* result, const uint32_t& width, const uint32_t& height, std::wstring& resultname,
-		const LodePNGColorType& colorType = LodePNGColorType::LCT_RGBA, const uint32_t& bitdepth = 8u);
+		const LodePNGColorType& colorType = LodePNGColorType::LCT_RGBA, const uint32_t& bitdepth = 8u, const EncoderHints& hints = EncoderHints());
+	static uint32_t encodeFile(const std::string& path, const byte* result, const uint32_t& width, const uint32_t& height,
+		const LodePNGColorType& colorType, const uint32_t& bitdepth, const EncoderHints& hints);
+
+protected:
+	static inline CompressionLevel compressionLevel = CompressionLevel::normal;
+	static inline bool streaming = false;
 };
 #endif // !PNG
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+* lodepng_crc32 check and micro-benchmark: the byte table, slice-by-8 and PCLMULQDQ folding.
+* lodepng.cpp is included so the static kernels can be called one by one.
+* build: g++ -std=c++17 -O2 -pthread tests/crc32_bench.cpp -o crc32_bench
+* run: crc32_bench [MiB, default 256], exits with 1 if any kernel disagrees with the byte table
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../lodepng.cpp"
+#include "../clockTimer.h"
+
+//the byte-at-a-time table lodepng uses without IMSD_SOURCE_CODE_MODIFICATION
+static uint32_t ByteTable[256];
+
+static void MakeByteTable()
+{
+	for (uint32_t n = 0u; n < 256u; ++n)
+	{
+		uint32_t c = n;
+		for (uint32_t bit = 0u; bit < 8u; ++bit) c = (c & 1u) ? (0xedb88320u ^ (c >> 1u)) : (c >> 1u);
+		ByteTable[n] = c;
+	}
+}
+
+static uint32_t Crc32ByteTable(const byte* data, size_t length)
+{
+	uint32_t r = 0xffffffffu;
+	for (size_t i = 0u; i < length; ++i)
+	{
+		r = ByteTable[(r ^ data[i]) & 0xffu] ^ (r >> 8u);
+	}
+	return r ^ 0xffffffffu;
+}
+
+static uint32_t Crc32Slice8(const byte* data, size_t length)
+{
+	return lodepng_crc32_slice8(0xffffffffu, data, length) ^ 0xffffffffu;
+}
+
+#if LODEPNG_X86_SIMD
+static bool HasPclmul()
+{
+	return CpuFeatures::Get().pclmul && CpuFeatures::Get().sse41;
+}
+
+//the folded body plus the slice-by-8 tail, like lodepng_crc32 but without the 64 byte cutoff
+static uint32_t Crc32Pclmul(const byte* data, size_t length)
+{
+	const size_t folded = (length >= 64u) ? (length & ~static_cast<size_t>(15u)) : 0u;
+	uint32_t r = 0xffffffffu;
+
+	if (folded) r = lodepng_crc32_pclmul(r, data, folded);
+	return lodepng_crc32_slice8(r, data + folded, length - folded) ^ 0xffffffffu;
+}
+#endif // LODEPNG_X86_SIMD
+
+typedef uint32_t (*Crc32Function)(const byte* data, size_t length);
+
+//every length from 0 to 3000 at a random offset
+static bool Check(const char* name, const Crc32Function& function, const std::vector<byte>& buffer, std::mt19937& random)
+{
+	size_t failures = 0u;
+
+	for (size_t length = 0u; length <= 3000u; ++length)
+	{
+		const size_t offset = random() % (buffer.size() - length);
+
+		if (function(buffer.data() + offset, length) != Crc32ByteTable(buffer.data() + offset, length))
+			++failures;
+	}
+
+	std::printf("%-12s %s\n", name, failures ? "MISMATCH" : "ok");
+	return failures == 0u;
+}
+
+static void Bench(const char* name, const Crc32Function& function, const std::vector<byte>& buffer)
+{
+	constexpr int rounds = 4;
+	volatile uint32_t sink = 0u;
+
+	clockTimer timer;
+	timer.TimerStart();
+	for (int round = 0; round < rounds; ++round)
+	{
+		sink = sink ^ function(buffer.data(), buffer.size());
+	}
+	timer.TimerStop();
+
+	const double seconds = timer.getTime();
+	std::printf("%-12s %6.2f GB/s\n", name, (seconds > 0.0) ? (static_cast<double>(buffer.size()) * rounds / seconds / 1e9) : 0.0);
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t mebibytes = (argc > 1) ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 256u;
+	std::vector<byte> buffer(std::max(mebibytes, static_cast<size_t>(1u)) << 20u);
+	std::mt19937 random(2024u);
+
+	for (byte& value : buffer) value = static_cast<byte>(random());
+
+	MakeByteTable();
+
+	bool ok = Check("slice-by-8", Crc32Slice8, buffer, random);
+	ok = Check("lodepng", lodepng_crc32, buffer, random) && ok;
+#if LODEPNG_X86_SIMD
+	if (HasPclmul()) ok = Check("PCLMULQDQ", Crc32Pclmul, buffer, random) && ok;
+#endif // LODEPNG_X86_SIMD
+
+	std::printf("\n%zu MiB hashed 4 times\n", buffer.size() >> 20u);
+	Bench("byte table", Crc32ByteTable, buffer);
+	Bench("slice-by-8", Crc32Slice8, buffer);
+#if LODEPNG_X86_SIMD
+	if (HasPclmul()) Bench("PCLMULQDQ", Crc32Pclmul, buffer);
+#endif // LODEPNG_X86_SIMD
+	Bench("lodepng", lodepng_crc32, buffer);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/*
+* Inflate conformance runner for the zlib streams in tests/inflate_corpus (see make_corpus.py there).
+* Every stream is inflated whole and through the streaming sink, in one buffer and split into segments like IDAT chunks
+* (of 1 byte, around the seam copy size and random sizes). The valid ones must give the size and CRC of MANIFEST,
+* the invalid ones and every truncation of a valid one must fail, and bit-flipped copies must not crash.
+* Each stream or segment sits in a buffer of exactly its size, build with -fsanitize=address to catch reads past insize.
+* lodepng.cpp is included so the streaming and chained inflate can be called directly.
+* build: g++ -std=c++17 -O2 -pthread tests/inflate_conformance.cpp -o inflate_conformance
+* run: inflate_conformance [corpus directory, default tests/inflate_corpus]
+*/
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../lodepng.cpp"
+
+struct CorpusStream
+{
+	std::unique_ptr<byte[]> data;
+	size_t size = 0u;
+};
+
+struct InflateResult
+{
+	uint32_t error = 0u;
+	std::vector<byte> out;
+};
+
+static bool LoadStream(const std::string& path, CorpusStream& stream)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	stream.size = content.size();
+	stream.data.reset(new byte[stream.size ? stream.size : 1u]);
+	std::memcpy(stream.data.get(), content.data(), stream.size);
+	return true;
+}
+
+//a copy of exactly size bytes, so a sanitizer sees any read past the end
+static InflateResult InflateWhole(const byte* in, const size_t& size)
+{
+	std::unique_ptr<byte[]> exact(new byte[size ? size : 1u]);
+	std::memcpy(exact.get(), in, size);
+
+	InflateResult result;
+	byte* out = nullptr;
+	size_t outsize = 0u;
+
+	result.error = lodepng_zlib_decompress(&out, &outsize, exact.get(), size, &lodepng_default_decompress_settings);
+	if (!result.error) result.out.assign(out, out + outsize);
+	lodepng_free(out);
+	return result;
+}
+
+static uint32_t CollectSink(const byte* data, size_t size, void* context)
+{
+	std::vector<byte>* out = static_cast<std::vector<byte>*>(context);
+	out->insert(out->end(), data, data + size);
+	return 0u;
+}
+
+static InflateResult InflateStreamed(const byte* in, const size_t& size)
+{
+	std::unique_ptr<byte[]> exact(new byte[size ? size : 1u]);
+	std::memcpy(exact.get(), in, size);
+
+	InflateResult result;
+	ucvector window(nullptr, 0);
+	InflateStream stream = { CollectSink, &result.out, 0 };
+
+	result.error = lodepng_zlib_decompressv(&window, exact.get(), size, &lodepng_default_decompress_settings, &stream);
+	lodepng_free(window.data);
+	if (result.error) result.out.clear();
+	return result;
+}
+
+//size bytes cut into segments of the given lengths, the last one repeats, 0 draws each length from 1 to 2048
+struct SplitStream
+{
+	std::vector<std::unique_ptr<byte[]>> pieces;
+	std::vector<InflateSegment> segments;
+
+	SplitStream(const byte* in, size_t size, const std::vector<size_t>& lengths, std::mt19937& random)
+	{
+		for (size_t i = 0u; size; ++i)
+		{
+			size_t length = lengths[(i < lengths.size()) ? i : lengths.size() - 1u];
+			if (!length) length = 1u + random() % 2048u;
+			if (length > size) length = size;
+
+			pieces.emplace_back(new byte[length]);
+			std::memcpy(pieces.back().get(), in, length);
+			segments.push_back({ pieces.back().get(), length });
+			in += length;
+			size -= length;
+		}
+	}
+};
+
+static InflateResult InflateChained(const SplitStream& split)
+{
+	InflateResult result;
+	byte* out = nullptr;
+	size_t outsize = 0u;
+
+	result.error = zlib_decompress(&out, &outsize, 0u, split.segments.data(), split.segments.size(), &lodepng_default_decompress_settings);
+	if (!result.error) result.out.assign(out, out + outsize);
+	lodepng_free(out);
+	return result;
+}
+
+static InflateResult InflateChainedStreamed(const SplitStream& split)
+{
+	InflateResult result;
+	ucvector window(nullptr, 0);
+	InflateStream stream = { CollectSink, &result.out, 0 };
+
+	result.error = zlibDecompressChain(&window, split.segments.data(), split.segments.size(), &lodepng_default_decompress_settings, &stream);
+	lodepng_free(window.data);
+	if (result.error) result.out.clear();
+	return result;
+}
+
+//segment lengths to split a stream of size bytes with, 1 byte segments only for the short streams
+static std::vector<std::vector<size_t>> SplitLengths(const size_t& size)
+{
+	std::vector<std::vector<size_t>> splits = { { 2u, 1u, 7u }, { 63u }, { 1023u }, { 1024u }, { 1025u }, { 3u, 8192u }, { 0u } };
+	if (size <= 65536u) splits.push_back({ 1u });
+	return splits;
+}
+
+static std::string Describe(const InflateResult& result)
+{
+	std::ostringstream text;
+	if (result.error)
+		text << "error " << result.error << " (" << lodepng_error_text(result.error) << ")";
+	else
+		text << result.out.size() << " bytes, crc " << std::hex << lodepng_crc32(result.out.data(), result.out.size());
+	return text.str();
+}
+
+//the prefixes checked for truncation, all of them for short streams
+static std::vector<size_t> TruncationLengths(const size_t& size)
+{
+	std::vector<size_t> lengths;
+
+	for (size_t length = 0u; length < size; ++length)
+	{
+		if (size <= 2048u || length < 64u || length + 64u >= size || (length % (size / 256u)) == 0u)
+			lengths.push_back(length);
+	}
+	return lengths;
+}
+
+int main(int argc, char* argv[])
+{
+	const std::string directory = (argc > 1) ? argv[1] : "tests/inflate_corpus";
+	std::ifstream manifest(directory + "/MANIFEST");
+
+	if (!manifest)
+	{
+		std::printf("no MANIFEST in %s\n", directory.c_str());
+		return 1;
+	}
+
+	size_t streams = 0u, failures = 0u, splits = 0u, truncations = 0u, flips = 0u;
+	std::string line;
+
+	while (std::getline(manifest, line))
+	{
+		std::istringstream fields(line);
+		std::string name, expect;
+		size_t size = 0u;
+		uint32_t crc = 0u;
+
+		if (!(fields >> name >> expect))
+			continue;
+		if (expect == "ok")
+			fields >> size >> std::hex >> crc;
+
+		CorpusStream stream;
+		if (!LoadStream(directory + "/" + name, stream))
+		{
+			std::printf("%-28s cannot be read\n", name.c_str());
+			++failures;
+			continue;
+		}
+		++streams;
+
+		const InflateResult whole = InflateWhole(stream.data.get(), stream.size);
+		const InflateResult streamed = InflateStreamed(stream.data.get(), stream.size);
+		bool ok;
+
+		if (expect == "ok")
+		{
+			ok = !whole.error && whole.out.size() == size && lodepng_crc32(whole.out.data(), whole.out.size()) == crc
+				&& !streamed.error && streamed.out == whole.out;
+		}
+		else
+		{
+			ok = whole.error && streamed.error;
+		}
+
+		std::mt19937 random(static_cast<uint32_t>(streams));
+		for (const std::vector<size_t>& lengths : SplitLengths(stream.size))
+		{
+			const SplitStream split(stream.data.get(), stream.size, lengths, random);
+			const InflateResult chained = InflateChained(split);
+			const InflateResult chainedStreamed = InflateChainedStreamed(split);
+
+			++splits;
+			if ((expect == "ok") ? (chained.error || chained.out != whole.out || chainedStreamed.error || chainedStreamed.out != whole.out)
+				: (!chained.error || !chainedStreamed.error))
+			{
+				if (ok) std::printf("%-28s split into %zu segments: %s\n", name.c_str(), split.segments.size(), Describe(chained).c_str());
+				ok = false;
+			}
+		}
+
+		if (ok && expect == "ok")
+		{
+			for (const size_t& length : TruncationLengths(stream.size))
+			{
+				const SplitStream split(stream.data.get(), length, { 0u }, random);
+
+				++truncations;
+				if (!InflateWhole(stream.data.get(), length).error || !InflateStreamed(stream.data.get(), length).error
+					|| !InflateChained(split).error || !InflateChainedStreamed(split).error)
+				{
+					std::printf("%-28s accepts the first %zu of %zu bytes\n", name.c_str(), length, stream.size);
+					ok = false;
+					break;
+				}
+			}
+
+			//any result is fine, the decoder only has to stay inside its buffers
+			for (int flip = 0; flip < 64 && stream.size; ++flip, ++flips)
+			{
+				std::vector<byte> copy(stream.data.get(), stream.data.get() + stream.size);
+				copy[random() % copy.size()] ^= static_cast<byte>(1u << (random() % 8u));
+				InflateWhole(copy.data(), copy.size());
+				InflateStreamed(copy.data(), copy.size());
+
+				const SplitStream split(copy.data(), copy.size(), { 0u }, random);
+				InflateChained(split);
+				InflateChainedStreamed(split);
+			}
+		}
+
+		std::printf("%-28s %-5s %s\n", name.c_str(), ok ? "ok" : "FAIL", Describe(whole).c_str());
+		if (!ok)
+		{
+			std::printf("%28s streamed: %s\n", "", Describe(streamed).c_str());
+			++failures;
+		}
+	}
+
+	std::printf("\n%zu streams, %zu splits, %zu truncations, %zu bit flips, %zu failed\n", streams, splits, truncations, flips, failures);
+	return (failures || !streams) ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+#!/usr/bin/env python3
+"""
+Writes the zlib streams of the inflate conformance corpus and MANIFEST next to this script.
+Valid streams come from Python's zlib, the invalid ones are written bit by bit and zlib must reject them too.
+MANIFEST lines: <file> ok <size> <crc32 hex> | <file> error
+"""
+import os
+import random
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+entries = []
+
+
+def text(rng, size):
+    words = [''.join(rng.choice('etaoinshrdlucmfwyp') for _ in range(rng.randint(1, 9))) for _ in range(400)]
+    out = []
+    while sum(len(w) + 1 for w in out) < size:
+        out.append(rng.choice(words))
+    return ' '.join(out).encode()[:size]
+
+
+def compress(data, level=6, strategy=zlib.Z_DEFAULT_STRATEGY, wbits=15, flushes=()):
+    c = zlib.compressobj(level, zlib.DEFLATED, wbits, 9, strategy)
+    out, last = b'', 0
+    for cut in flushes:
+        out += c.compress(data[last:cut]) + c.flush(zlib.Z_FULL_FLUSH)
+        last = cut
+    return out + c.compress(data[last:]) + c.flush()
+
+
+def valid(name, data, stream):
+    assert zlib.decompress(stream) == data
+    open(os.path.join(HERE, name + '.zz'), 'wb').write(stream)
+    entries.append('%s.zz ok %d %08x' % (name, len(data), zlib.crc32(data)))
+
+
+def invalid(name, stream):
+    try:
+        zlib.decompress(stream)
+    except zlib.error:
+        pass
+    else:
+        raise AssertionError(name + ' is accepted by zlib')
+    open(os.path.join(HERE, name + '.zz'), 'wb').write(stream)
+    entries.append('%s.zz error' % name)
+
+
+class Bits:
+    """deflate bit order, huffman codes go in from their first bit"""
+
+    def __init__(self):
+        self.bits = []
+
+    def put(self, value, count):
+        self.bits += [(value >> i) & 1 for i in range(count)]
+
+    def code(self, code, length):
+        self.bits += [(code >> (length - 1 - i)) & 1 for i in range(length)]
+
+    def align(self):
+        self.bits += [0] * (-len(self.bits) % 8)
+
+    def bytes(self):
+        self.align()
+        return bytes(sum(b << i for i, b in enumerate(self.bits[k:k + 8])) for k in range(0, len(self.bits), 8))
+
+
+def fixed_code(symbol):
+    if symbol < 144:
+        return 0x30 + symbol, 8
+    if symbol < 256:
+        return 0x190 + symbol - 144, 9
+    if symbol < 280:
+        return symbol - 256, 7
+    return 0xC0 + symbol - 280, 8
+
+
+def canonical(lengths):
+    codes, code, counts = {}, 0, [0] * 16
+    for l in lengths:
+        counts[l] += 1
+    counts[0] = 0
+    start = [0] * 16
+    for bits in range(1, 16):
+        code = (code + counts[bits - 1]) << 1
+        start[bits] = code
+    for symbol, l in enumerate(lengths):
+        if l:
+            codes[symbol] = (start[l], l)
+            start[l] += 1
+    return codes
+
+
+CLCL_ORDER = [16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15]
+
+
+def dynamic_header(bits, litlen, dist, first_symbols=None):
+    """lengths written as plain code length symbols 0-15, first_symbols replaces the start of that list"""
+    bits.put(len(litlen) - 257, 5)
+    bits.put(len(dist) - 1, 5)
+    bits.put(19 - 4, 4)
+    cl_lengths = [4] * 13 + [5] * 6  # complete: 13 / 16 + 6 / 32
+    cl = [0] * 19
+    for symbol, l in zip(range(19), cl_lengths):
+        cl[symbol] = l
+    for symbol in CLCL_ORDER:
+        bits.put(cl[symbol], 3)
+    codes = canonical(cl)
+    symbols = list(litlen) + list(dist)
+    if first_symbols:
+        for s, extra in first_symbols:
+            bits.code(*codes[s])
+            bits.put(*extra)
+        symbols = symbols[len(first_symbols):]
+    for s in symbols:
+        bits.code(*codes[s])
+
+
+def zlib_wrap(body, data=b''):
+    return b'\x78\x01' + body + zlib.adler32(data).to_bytes(4, 'big')
+
+
+def main():
+    rng = random.Random(2024)
+    for name in os.listdir(HERE):
+        if name.endswith('.zz'):
+            os.remove(os.path.join(HERE, name))
+
+    # stored blocks
+    valid('stored_empty', b'', compress(b'', 0))
+    data = bytes(rng.randrange(256) for _ in range(70000))
+    valid('stored_multi', data, compress(data, 0))
+
+    # fixed and dynamic huffman blocks
+    valid('fixed_empty', b'', compress(b'', 6, zlib.Z_FIXED))
+    valid('fixed_one', b'x', compress(b'x', 6, zlib.Z_FIXED))
+    data = text(rng, 60000)
+    valid('fixed_text', data, compress(data, 6, zlib.Z_FIXED))
+    valid('dynamic_text', data, compress(data, 9))
+    valid('dynamic_text_level1', data, compress(data, 1))
+    valid('dynamic_window9', data, compress(data, 6, wbits=9))
+    data = bytes(rng.randrange(256) for _ in range(5000))
+    valid('random_level9', data, compress(data, 9))
+    data += text(rng, 5000)
+    valid('huffman_only', data, compress(data, 6, zlib.Z_HUFFMAN_ONLY))
+
+    # every block type in one stream, with empty stored blocks from the full flushes
+    data = text(rng, 20000) + bytes(rng.randrange(256) for _ in range(3000)) + b'\0' * 5000
+    valid('mixed_blocks', data, compress(data, 6, flushes=(7, 4000, 4001, 20000, 23000)))
+
+    # distance 1: runs of every length up to 300 and a long one
+    data = b''.join(bytes([rng.randrange(256)]) * n for n in range(1, 301)) + b'\x7f' * 70000
+    valid('distance1_runs', data, compress(data, 9))
+    valid('distance1_rle', data, compress(data, 6, zlib.Z_RLE))
+
+    # overlapping matches, periods 2 to 33 so every copy width of the fast path shows up
+    data = b''.join(bytes(rng.randrange(256) for _ in range(p)) * (1200 // p) for p in range(2, 34))
+    valid('overlap_periods', data, compress(data, 9))
+
+    # length 258 matches, at distances from 1K to the largest one
+    block = bytes(rng.randrange(256) for _ in range(1024))
+    data = block * 40
+    valid('maxlen_near', data, compress(data, 9))
+    block = bytes(rng.randrange(256) for _ in range(32768))
+    data = block + block[:6000]
+    valid('maxlen_window', data, compress(data, 9))
+
+    # rows of a synthetic RGBA image that repeat every 4 rows, 4MB, so the streaming inflate flushes more than once
+    rows = []
+    for y in range(1024):
+        row = bytearray([1])
+        for x in range(1024):
+            row += bytes([(x + (y & 3)) & 255, (x * 3) & 255, y & 3, 255])
+        if y % 97 == 0:
+            row[1 + rng.randrange(4096)] ^= 0x5a
+        rows.append(bytes(row))
+    data = b''.join(rows)
+    valid('image_rows', data, compress(data, 6))
+
+    # invalid streams
+    invalid('header_fcheck', b'\x78\x02' + compress(b'abc')[2:])
+    # compression method 9 with a valid FCHECK
+    invalid('header_method', bytes([0x79, 31 - (0x79 * 256) % 31]) + compress(b'abc')[2:])
+    invalid('header_dictionary', b'\x78\xbb' + compress(b'abc')[2:])
+    stream = bytearray(compress(text(rng, 3000)))
+    stream[-1] ^= 1
+    invalid('adler_wrong', bytes(stream))
+
+    b = Bits(); b.put(1, 1); b.put(3, 2)
+    invalid('btype3', zlib_wrap(b.bytes()))
+
+    b = Bits(); b.put(1, 1); b.put(0, 2); b.align()
+    invalid('stored_nlen', zlib_wrap(b.bytes() + (5).to_bytes(2, 'little') + (5).to_bytes(2, 'little') + b'hello', b'hello'))
+    b = Bits(); b.put(1, 1); b.put(0, 2); b.align()
+    invalid('stored_short', b'\x78\x01' + b.bytes() + (100).to_bytes(2, 'little') + (0xffff - 100).to_bytes(2, 'little') + b'0123456789')
+
+    # a match before any output
+    b = Bits(); b.put(1, 1); b.put(1, 2)
+    b.code(*fixed_code(257)); b.code(0, 5); b.code(*fixed_code(256))
+    invalid('distance_too_far', zlib_wrap(b.bytes()))
+    # a match further back than the output so far
+    b = Bits(); b.put(1, 1); b.put(1, 2)
+    for c in b'abcd':
+        b.code(*fixed_code(c))
+    b.code(*fixed_code(257)); b.code(4, 5); b.put(0, 1); b.code(*fixed_code(256))
+    invalid('distance_past_start', zlib_wrap(b.bytes()))
+
+    b = Bits(); b.put(1, 1); b.put(1, 2)
+    b.code(*fixed_code(ord('a'))); b.code(*fixed_code(257)); b.code(30, 5); b.code(*fixed_code(256))
+    invalid('distance_code30', zlib_wrap(b.bytes()))
+
+    b = Bits(); b.put(1, 1); b.put(1, 2)
+    b.code(*fixed_code(ord('a'))); b.code(*fixed_code(286)); b.code(0, 5); b.code(*fixed_code(256))
+    invalid('litlen_code286', zlib_wrap(b.bytes()))
+
+    # a long fixed block that stops before its end code, the fast path runs into the end of the input
+    b = Bits(); b.put(1, 1); b.put(1, 2)
+    for c in text(rng, 4000):
+        b.code(*fixed_code(c))
+    invalid('fixed_no_end', b'\x78\x01' + b.bytes())
+
+    # dynamic blocks with broken trees
+    b = Bits(); b.put(1, 1); b.put(2, 2)
+    dynamic_header(b, [8] * 256 + [0], [5] * 30)
+    invalid('dynamic_no_end_code', zlib_wrap(b.bytes()))
+
+    b = Bits(); b.put(1, 1); b.put(2, 2)
+    dynamic_header(b, [8] * 257, [5] * 30)
+    invalid('dynamic_oversubscribed', zlib_wrap(b.bytes()))
+
+    b = Bits(); b.put(1, 1); b.put(2, 2)
+    dynamic_header(b, [8] * 257, [5] * 30, first_symbols=[(16, (0, 2))])
+    invalid('dynamic_repeat_first', zlib_wrap(b.bytes()))
+
+    b = Bits(); b.put(1, 1); b.put(2, 2)
+    dynamic_header(b, [8] * 257, [5] * 30, first_symbols=[(18, (127, 7)), (18, (127, 7)), (18, (127, 7))])
+    invalid('dynamic_repeat_overflow', zlib_wrap(b.bytes()))
+
+    # a truncated dynamic header
+    invalid('dynamic_header_cut', compress(text(rng, 3000), 9)[:12])
+
+    open(os.path.join(HERE, 'MANIFEST'), 'w', newline='\n').write('\n'.join(entries) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,191 @@
+/*
+* Sharpen tolerance check: SharpenLaplace3x3 and SharpenGaussLaplace5x5 against the float kernels they had before the
+* 16-bit fixed point paths, every byte must stay within 1. Noise, flat and hard edged images from 1x1 to 1023x17 are
+* sharpened at strengths from 1 to 1000, on whatever path this CPU takes (SSE2, AVX2 or AVX-512).
+* It links the image sources, build it with MSVC like the project:
+* build: cl /std:c++17 /O2 /EHsc tests\sharpen_tolerance.cpp Image.cpp ImageSimd_AVX2.cpp ImageSimd_AVX512.cpp
+* run: sharpen_tolerance
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../Image.h"
+
+//the float kernels of Image.cpp, fed through the clamped sample like the border pixels are
+static RGBAColor_8i Laplace3x3(TextureData& input, const int64_t& X, const int64_t& Y, const float32_t& strength)
+{
+	const float32_t factor = -0.01f * strength;
+	constexpr float32_t oneHalfRoot = 0.70710678f;
+	constexpr float32_t oneHalfRootPlusOne = oneHalfRoot + 1.0f;
+
+	const float32_t& outerNear = factor;
+	const float32_t outerFar = factor * oneHalfRoot;
+	const float32_t center = 1.0f - (4.0f * oneHalfRootPlusOne) * factor;
+
+	const auto Fetch = [&input, &X, &Y](const int64_t& dx, const int64_t& dy) { return input.sample<BorderClamp>(X + dx, Y + dy); };
+
+	RGBAColor_32f rgba_f1(0.0f, 0.0f, 0.0f, 0.0f);
+	RGBAColor_32f rgba_f2(0.0f, 0.0f, 0.0f, 0.0f);
+
+	rgba_f1 += RGBAColor_32f(Fetch(-1, -1));
+	rgba_f1 += RGBAColor_32f(Fetch(+1, -1));
+	rgba_f1 += RGBAColor_32f(Fetch(-1, +1));
+	rgba_f1 += RGBAColor_32f(Fetch(+1, +1));
+
+	rgba_f2 += RGBAColor_32f(Fetch(+0, -1));
+	rgba_f2 += RGBAColor_32f(Fetch(-1, +0));
+	rgba_f2 += RGBAColor_32f(Fetch(+1, +0));
+	rgba_f2 += RGBAColor_32f(Fetch(+0, +1));
+
+	rgba_f1 *= outerFar;
+	rgba_f2 *= outerNear;
+
+	rgba_f1 += RGBAColor_32f(Fetch(+0, +0), center);
+	rgba_f1 += rgba_f2;
+
+	return rgba_f1.toRGBAColor_8i();
+}
+
+static RGBAColor_8i GaussLaplace5x5(TextureData& input, const int64_t& X, const int64_t& Y, const float32_t& strength)
+{
+	const float32_t factor = -0.002f * strength;
+
+	const float32_t& outerl2Far = factor;
+	const float32_t outerl2Near = 2.0f * factor;
+	const float32_t outerl1Near = -4.0f * factor;
+	const float32_t center = 1.0f - 12.0f * factor;
+
+	const auto Fetch = [&input, &X, &Y](const int64_t& dx, const int64_t& dy) { return input.sample<BorderClamp>(X + dx, Y + dy); };
+
+	RGBAColor_32f rgba_f1(0.0f, 0.0f, 0.0f, 0.0f);
+	RGBAColor_32f rgba_f2(0.0f, 0.0f, 0.0f, 0.0f);
+	RGBAColor_32f rgba_f3(0.0f, 0.0f, 0.0f, 0.0f);
+
+	rgba_f1 += RGBAColor_32f(Fetch(-2, -2));
+	rgba_f1 += RGBAColor_32f(Fetch(+2, -2));
+	rgba_f1 += RGBAColor_32f(Fetch(-2, +2));
+	rgba_f1 += RGBAColor_32f(Fetch(+2, +2));
+
+	rgba_f2 += RGBAColor_32f(Fetch(-1, -2));
+	rgba_f2 += RGBAColor_32f(Fetch(+0, -2));
+	rgba_f2 += RGBAColor_32f(Fetch(+1, -2));
+	rgba_f2 += RGBAColor_32f(Fetch(-2, -1));
+	rgba_f2 += RGBAColor_32f(Fetch(-2, +0));
+	rgba_f2 += RGBAColor_32f(Fetch(-2, +1));
+	rgba_f2 += RGBAColor_32f(Fetch(+2, -1));
+	rgba_f2 += RGBAColor_32f(Fetch(+2, +0));
+	rgba_f2 += RGBAColor_32f(Fetch(+2, +1));
+	rgba_f2 += RGBAColor_32f(Fetch(-1, +2));
+	rgba_f2 += RGBAColor_32f(Fetch(+0, +2));
+	rgba_f2 += RGBAColor_32f(Fetch(+1, +2));
+
+	rgba_f3 += RGBAColor_32f(Fetch(+0, -1));
+	rgba_f3 += RGBAColor_32f(Fetch(-1, +0));
+	rgba_f3 += RGBAColor_32f(Fetch(+1, +0));
+	rgba_f3 += RGBAColor_32f(Fetch(+0, +1));
+
+	rgba_f1 *= outerl2Far;
+	rgba_f2 *= outerl2Near;
+	rgba_f3 *= outerl1Near;
+
+	rgba_f1 += RGBAColor_32f(Fetch(+0, +0), center);
+	rgba_f1 += rgba_f2;
+	rgba_f1 += rgba_f3;
+
+	return rgba_f1.toRGBAColor_8i();
+}
+
+struct Tolerance
+{
+	size_t bytes = 0u, differing = 0u, failures = 0u;
+};
+
+typedef bool (*SharpenFunction)(TextureData& input, TextureData& result, const float32_t& strength);
+typedef RGBAColor_8i(*ReferenceFunction)(TextureData& input, const int64_t& X, const int64_t& Y, const float32_t& strength);
+
+static void Compare(TextureData& input, const float32_t& strength, const SharpenFunction& sharpen, const ReferenceFunction& reference, Tolerance& tolerance)
+{
+	TextureData result;
+	if (!sharpen(input, result, strength))
+	{
+		++tolerance.failures;
+		return;
+	}
+
+	for (int64_t Y = 0; Y < input.height; ++Y)
+	{
+		for (int64_t X = 0; X < input.width; ++X)
+		{
+			const RGBAColor_8i expected = reference(input, X, Y, strength);
+			const RGBAColor_8i& actual = result.at(X, Y);
+			const byte* a = &actual.R;
+			const byte* e = &expected.R;
+
+			for (size_t channel = 0u; channel < 4u; ++channel)
+			{
+				const int32_t difference = std::abs(static_cast<int32_t>(a[channel]) - static_cast<int32_t>(e[channel]));
+
+				++tolerance.bytes;
+				if (difference > 0) ++tolerance.differing;
+				if (difference > 1)
+				{
+					if (tolerance.failures++ == 0u)
+						std::printf("  %ux%u strength %g at %lld,%lld channel %zu: %u, float %u\n", input.width, input.height, strength,
+							static_cast<long long>(X), static_cast<long long>(Y), channel, a[channel], e[channel]);
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	static constexpr uint32_t widths[] = { 1u, 2u, 3u, 4u, 5u, 7u, 8u, 9u, 15u, 16u, 17u, 20u, 31u, 33u, 64u, 100u, 1023u };
+	static constexpr uint32_t heights[] = { 1u, 2u, 3u, 4u, 5u, 17u };
+	static constexpr float32_t strengths[] = { 1.0f, 2.0f, 7.5f, 15.0f, 50.0f, 99.0f, 250.0f, 512.0f, 999.0f, 1000.0f };
+
+	std::mt19937 random(2024u);
+	Tolerance laplace, gaussLaplace;
+
+	for (const uint32_t& width : widths)
+	{
+		for (const uint32_t& height : heights)
+		{
+			//noise, one flat color and 0 / 255 edges, the last two push the sums to the ends of the 16-bit range
+			for (int32_t content = 0; content < 3; ++content)
+			{
+				TextureData input;
+				input.resize(width, height);
+
+				for (uint32_t Y = 0u; Y < height; ++Y)
+				{
+					for (uint32_t X = 0u; X < width; ++X)
+					{
+						byte* pixel = &input.at(X, Y).R;
+						for (size_t channel = 0u; channel < 4u; ++channel)
+						{
+							pixel[channel] = (content == 0) ? static_cast<byte>(random())
+								: ((content == 1) ? static_cast<byte>(0xC8u) : static_cast<byte>((((X >> 1u) ^ Y ^ channel) & 1u) ? 255u : 0u));
+						}
+					}
+				}
+
+				for (const float32_t& strength : strengths)
+				{
+					Compare(input, strength, ImageProcessingTools::SharpenLaplace3x3, Laplace3x3, laplace);
+					Compare(input, strength, ImageProcessingTools::SharpenGaussLaplace5x5, GaussLaplace5x5, gaussLaplace);
+				}
+			}
+		}
+	}
+
+	const auto Report = [](const char* name, const Tolerance& tolerance) {
+		std::printf("%-16s %zu bytes, %.2f%% differ by 1, %zu beyond 1 %s\n", name, tolerance.bytes,
+			tolerance.bytes ? (100.0 * tolerance.differing / tolerance.bytes) : 0.0, tolerance.failures, tolerance.failures ? "FAIL" : "ok");
+		};
+
+	Report("Laplace 3x3", laplace);
+	Report("Gauss-Laplace 5x5", gaussLaplace);
+	return (laplace.failures || gaussLaplace.failures) ? 1 : 0;
+}
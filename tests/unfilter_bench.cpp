@@ -0,0 +1,108 @@
+/*
+* Unfilter kernel check and benchmark: the SSE4.1/AVX2 row kernels against unfilterScanline,
+* bit for bit on random rows of every filter type, in place and out of place, then both of them timed.
+* lodepng.cpp is included so the static kernels can be called one by one.
+* build: g++ -std=c++17 -O2 -pthread tests/unfilter_bench.cpp -o unfilter_bench
+* run: unfilter_bench [pixels per row, default 4096]
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../lodepng.cpp"
+#include "../clockTimer.h"
+
+#if IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD
+static const char* const FilterNames[5] = { "none", "sub", "up", "avg", "paeth" };
+
+//every filter type on rows of 1 to 64 pixels and one long row, with and without a previous row
+static bool Check(const size_t& bytewidth, const LodePNGUnfilterKernels* kernels, std::mt19937& random)
+{
+	size_t failures = 0u;
+
+	for (size_t pixels = 1u; pixels <= 65u; ++pixels)
+	{
+		const size_t length = ((pixels == 65u) ? 4099u : pixels) * bytewidth;
+		std::vector<byte> scanline(length), precon(length), expected(length), recon(length);
+
+		for (byte filterType = 0u; filterType <= 4u; ++filterType)
+		{
+			for (int first = 0; first < 2; ++first)
+			{
+				for (byte& value : scanline) value = static_cast<byte>(random());
+				for (byte& value : precon) value = static_cast<byte>(random());
+				const byte* previous = first ? nullptr : precon.data();
+
+				unfilterScanline(expected.data(), scanline.data(), previous, bytewidth, filterType, length);
+				unfilterScanlineKernels(kernels, recon.data(), scanline.data(), previous, bytewidth, filterType, length);
+				if (recon != expected) ++failures;
+
+				//recon and scanline may be the same memory
+				recon = scanline;
+				unfilterScanlineKernels(kernels, recon.data(), recon.data(), previous, bytewidth, filterType, length);
+				if (recon != expected) ++failures;
+			}
+		}
+	}
+
+	std::printf("bpp%zu check %s\n", bytewidth, failures ? "MISMATCH" : "ok");
+	return failures == 0u;
+}
+
+static double Throughput(const size_t& bytewidth, const LodePNGUnfilterKernels* kernels, const byte& filterType, const std::vector<byte>& rows, const size_t& length)
+{
+	const size_t count = rows.size() / length;
+	std::vector<byte> recon(rows.size());
+
+	clockTimer timer;
+	timer.TimerStart();
+	for (size_t y = 1u; y < count; ++y)
+	{
+		unfilterScanlineKernels(kernels, recon.data() + y * length, rows.data() + y * length, recon.data() + (y - 1u) * length, bytewidth, filterType, length);
+	}
+	timer.TimerStop();
+
+	const double seconds = timer.getTime();
+	return (seconds > 0.0) ? (static_cast<double>(length) * (count - 1u) / seconds / 1e9) : 0.0;
+}
+#endif // IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD
+
+int main(int argc, char* argv[])
+{
+#if IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD
+	const size_t pixels = (argc > 1) ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 4096u;
+	std::mt19937 random(2024u);
+	bool ok = true;
+
+	for (const size_t bytewidth : { 3u, 4u, 6u, 8u })
+	{
+		const LodePNGUnfilterKernels* kernels = unfilterKernels(bytewidth);
+		if (!kernels)
+		{
+			std::printf("bpp%zu has no kernels on this CPU\n", bytewidth);
+			continue;
+		}
+
+		ok = Check(bytewidth, kernels, random) && ok;
+
+		//about 64MB of rows, so the timing is not all cache hits
+		const size_t length = std::max(pixels, static_cast<size_t>(1u)) * bytewidth;
+		std::vector<byte> rows(std::max(static_cast<size_t>(64u << 20u) / length, static_cast<size_t>(2u)) * length);
+		for (byte& value : rows) value = static_cast<byte>(random());
+
+		for (byte filterType = 1u; filterType <= 4u; ++filterType)
+		{
+			const double scalar = Throughput(bytewidth, nullptr, filterType, rows, length);
+			const double simd = Throughput(bytewidth, kernels, filterType, rows, length);
+			std::printf("  %-5s scalar %6.2f GB/s  simd %6.2f GB/s\n", FilterNames[filterType], scalar, simd);
+		}
+	}
+	return ok ? 0 : 1;
+#else
+	(void)argc;
+	(void)argv;
+	std::printf("no unfilter kernels in this build\n");
+	return 0;
+#endif // IMSD_SOURCE_CODE_MODIFICATION && LODEPNG_X86_SIMD
+}